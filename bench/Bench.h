@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+// Time of one call of a benchmark body. Bodies run at least minRuns times and
+// for at least minSeconds; the fastest run is the one least disturbed by the
+// rest of the system, so it is what comparisons should use.
+struct BenchResult {
+    double bestMilliseconds = 0.0;
+    double meanMilliseconds = 0.0;
+    int runs = 0;
+};
+
+BenchResult measure(const std::function<void()>& body, int minRuns = 5, double minSeconds = 0.25);
+
+// One line per result; items scales the best time to a per-item figure
+void report(const std::string& name, const BenchResult& result, double items = 0.0, const std::string& note = "");
+
+// Keeps a result alive, so the compiler cannot drop the work that produced it
+void consume(double value);
+
+// Deterministic generator, so every run and every build sees the same data
+class BenchRandom {
+public:
+    explicit BenchRandom(uint64_t seed = 1) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    uint32_t next() {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<uint32_t>(state >> 32);
+    }
+
+    float uniform(float lo = 0.0f, float hi = 1.0f) {
+        return lo + (hi - lo) * static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    uint64_t state;
+};
+
+void benchMath();
+void benchAabbTree();
+void benchSimplifier();
+void benchOcclusion();
+void benchScheduler();
+void benchArchetype();
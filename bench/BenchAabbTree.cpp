@@ -0,0 +1,102 @@
+#include "Bench.h"
+#include "DynamicAabbTree.h"
+#include "Mat4.h"
+#include <string>
+#include <vector>
+
+// Boxes of about one unit scattered so the density stays the same at every size,
+// the way a larger level spreads out rather than piling up
+static std::vector<Aabb> makeBoxes(size_t count, float extent, BenchRandom& random)
+{
+    std::vector<Aabb> boxes(count);
+    for (Aabb& box : boxes) {
+        for (int i = 0; i < 3; ++i) {
+            const float center = random.uniform(-extent, extent);
+            const float half = random.uniform(0.25f, 1.0f);
+            box.min[i] = center - half;
+            box.max[i] = center + half;
+        }
+    }
+    return boxes;
+}
+
+static void benchTree(size_t count)
+{
+    constexpr size_t QueryCount = 1000;
+    const std::string suffix = ", " + std::to_string(count / 1000) + "k";
+
+    BenchRandom random(count);
+    const float extent = 4.0f * std::cbrt(static_cast<float>(count));
+    const std::vector<Aabb> boxes = makeBoxes(count, extent, random);
+    const std::vector<Aabb> queries = makeBoxes(QueryCount, extent, random);
+
+    // Builds run once each past the warm-up; a million inserts take long enough to be steady
+    DynamicAabbTree tree;
+    std::vector<int32_t> proxies(count);
+    BenchResult result = measure([&]() {
+        tree.clear();
+        for (size_t i = 0; i < count; ++i) proxies[i] = tree.insert(boxes[i], static_cast<uint32_t>(i));
+        consume(tree.getHeight());
+    }, 1, 0.0);
+    report("insert" + suffix, result, count, "height " + std::to_string(tree.getHeight()));
+
+    // Nudges that mostly stay inside the fat boxes, plus a share that jumps and reinserts
+    std::vector<Aabb> moved = boxes;
+    for (size_t i = 0; i < count; ++i) {
+        const float step = i % 16 == 0 ? 3.0f : 0.05f;
+        for (int k = 0; k < 3; ++k) {
+            moved[i].min[k] += step;
+            moved[i].max[k] += step;
+        }
+    }
+    size_t reinserted = 0;
+    result = measure([&]() {
+        reinserted = 0;
+        for (size_t i = 0; i < count; ++i) reinserted += tree.update(proxies[i], moved[i]);
+        for (size_t i = 0; i < count; ++i) tree.update(proxies[i], boxes[i]);
+    }, 1, 0.0);
+    report("update" + suffix, result, 2.0 * count, std::to_string(reinserted) + " reinserted");
+
+    size_t hits = 0;
+    result = measure([&]() {
+        hits = 0;
+        for (const Aabb& query : queries) tree.queryAabb(query, [&hits](uint32_t) { ++hits; });
+        consume(static_cast<double>(hits));
+    });
+    report("queryAabb x1000" + suffix, result, QueryCount, std::to_string(hits) + " hits");
+
+    hits = 0;
+    result = measure([&]() {
+        hits = 0;
+        BenchRandom rays(7);
+        for (size_t q = 0; q < QueryCount; ++q) {
+            const float origin[3] = { rays.uniform(-extent, extent), rays.uniform(-extent, extent), rays.uniform(-extent, extent) };
+            const Vec3 dir = normalize(Vec3(rays.uniform(-1.0f, 1.0f), rays.uniform(-1.0f, 1.0f), rays.uniform(-1.0f, 1.0f)));
+            const float direction[3] = { dir.x, dir.y, dir.z };
+            bool hit = false;
+            tree.raycast(origin, direction, 2.0f * extent, [&hit](uint32_t, float distance) { hit = true; return distance; });
+            hits += hit;
+        }
+        consume(static_cast<double>(hits));
+    });
+    report("raycast x1000" + suffix, result, QueryCount, std::to_string(hits) + " hits");
+
+    // A camera at the edge looking in, seeing a fraction of the level
+    const Mat4 view = Mat4::lookAtLH({ 0.0f, 0.0f, -extent }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+    const Mat4 viewProjection = view * Mat4::perspectiveFovLH(0.8f, 16.0f / 9.0f, 0.1f, extent);
+    const Frustum frustum = Frustum::fromViewProjection(viewProjection.data());
+    hits = 0;
+    result = measure([&]() {
+        hits = 0;
+        tree.queryFrustum(frustum, [&hits](uint32_t) { ++hits; });
+        consume(static_cast<double>(hits));
+    });
+    report("queryFrustum" + suffix, result, count, std::to_string(hits) + " visible");
+}
+
+void benchAabbTree()
+{
+    benchTree(10000);
+    benchTree(100000);
+    benchTree(1000000);
+}
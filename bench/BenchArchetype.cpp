@@ -0,0 +1,173 @@
+#include "Bench.h"
+#include "ComponentColumn.h"
+#include "Quat.h"
+#include "Vec.h"
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// Components are tied to Qt, so these stand in for them with the same layout:
+// a polymorphic base and the fields Transform, RigidBody and Light carry
+struct BenchComponent {
+    virtual ~BenchComponent() = default;
+    void* owner = nullptr;
+};
+
+struct BenchTransform : BenchComponent {
+    void* label = nullptr;
+    Vec3 position = { 0, 0, 0 };
+    Quat rotation;
+    Vec3 eulerAngles = { 0, 0, 0 };
+    bool eulerStale = false;
+    Vec3 scale = { 1, 1, 1 };
+    void* hierarchy = nullptr;
+    int32_t node = -1;
+    uint32_t version = 0;
+};
+
+struct BenchBody : BenchComponent {
+    float mass = 1.0f;
+    bool useGravity = true;
+    Vec3 velocity = { 0, 0, 0 };
+    Vec3 forces = { 0, 0, 0 };
+};
+
+struct BenchLight : BenchComponent {
+    int type = 0;
+    float color[4] = { 1, 1, 1, 1 };
+    float intensity = 1.0f;
+    float radius = 10.0f;
+    float spotFalloff = 30.0f;
+};
+
+// The object as it was before archetypes: every component its own allocation,
+// found through a hash map keyed by type
+class HashMapObject {
+public:
+    template<typename T>
+    T* addComponent() {
+        auto component = std::make_unique<T>();
+        T* ptr = component.get();
+        components[std::type_index(typeid(T))] = std::move(component);
+        return ptr;
+    }
+
+    template<typename T>
+    T* getComponent() {
+        auto it = components.find(std::type_index(typeid(T)));
+        return it != components.end() ? static_cast<T*>(it->second.get()) : nullptr;
+    }
+
+private:
+    std::unordered_map<std::type_index, std::unique_ptr<BenchComponent>> components;
+};
+
+// One archetype's columns; the ones its component set lacks stay empty
+struct BenchTable {
+    ComponentColumn transforms{ ColumnOps::of<BenchTransform, BenchComponent>() };
+    ComponentColumn bodies{ ColumnOps::of<BenchBody, BenchComponent>() };
+    ComponentColumn lights{ ColumnOps::of<BenchLight, BenchComponent>() };
+
+    size_t size() const { return transforms.size(); }
+};
+
+struct BenchTables {
+    BenchTable plain;
+    BenchTable bodies;
+    BenchTable lights;
+};
+
+// Every object has a Transform, half a RigidBody and a quarter a Light,
+// so the objects spread over three archetypes
+static bool hasBody(size_t i) { return i % 2 == 0; }
+static bool hasLight(size_t i) { return i % 4 == 1; }
+
+static void buildHashMapObjects(std::vector<std::unique_ptr<HashMapObject>>& objects, size_t count, BenchRandom& random)
+{
+    objects.clear();
+    for (size_t i = 0; i < count; ++i) {
+        objects.push_back(std::make_unique<HashMapObject>());
+        objects.back()->addComponent<BenchTransform>()->position = { random.uniform(), random.uniform(), random.uniform() };
+        if (hasBody(i)) objects.back()->addComponent<BenchBody>()->velocity = { random.uniform(), 0, 0 };
+        if (hasLight(i)) objects.back()->addComponent<BenchLight>();
+    }
+}
+
+// The way ArchetypeStorage builds them: created with a Transform, then each added
+// component moves the row to the next archetype by value
+static void buildTables(BenchTables& tables, size_t count, BenchRandom& random)
+{
+    BenchTable& plain = tables.plain;
+    BenchTable& bodies = tables.bodies;
+    BenchTable& lights = tables.lights;
+    for (size_t i = 0; i < count; ++i) {
+        plain.transforms.emplaceBack<BenchTransform>()->position = { random.uniform(), random.uniform(), random.uniform() };
+        if (hasBody(i)) {
+            bodies.transforms.moveFrom(plain.transforms, plain.size() - 1);
+            bodies.bodies.emplaceBack<BenchBody>()->velocity = { random.uniform(), 0, 0 };
+        }
+        if (hasLight(i)) {
+            lights.transforms.moveFrom(plain.transforms, plain.size() - 1);
+            lights.lights.emplaceBack<BenchLight>();
+        }
+    }
+}
+
+void benchArchetype()
+{
+    constexpr size_t Count = 100000;
+
+    std::vector<std::unique_ptr<HashMapObject>> objects;
+    objects.reserve(Count);
+    std::unique_ptr<BenchTables> tables;
+
+    report("hash map objects, build 100k", measure([&]() {
+        BenchRandom random(5);
+        buildHashMapObjects(objects, Count, random);
+        consume(double(objects.size()));
+    }, 3), Count);
+
+    report("archetype columns, build 100k by moving rows", measure([&]() {
+        BenchRandom random(5);
+        tables = std::make_unique<BenchTables>();
+        buildTables(*tables, Count, random);
+        consume(double(tables->plain.size()));
+    }, 3), Count);
+
+    const BenchTable& bodies = tables->bodies;
+
+    report("hash map getComponent<Transform>, 100k", measure([&]() {
+        Vec3 sum = { 0, 0, 0 };
+        for (const auto& object : objects) sum += object->getComponent<BenchTransform>()->position;
+        consume(sum.x);
+    }), Count);
+
+    report("archetype columns Transform, 100k", measure([&]() {
+        Vec3 sum = { 0, 0, 0 };
+        for (const BenchTable* table : { &tables->plain, &tables->bodies, &tables->lights }) {
+            const BenchTransform* transforms = table->transforms.data<BenchTransform>();
+            for (size_t row = 0; row < table->size(); ++row) sum += transforms[row].position;
+        }
+        consume(sum.x);
+    }), Count);
+
+    // Systems skipped objects without the component after looking it up
+    report("hash map getComponent<Transform, RigidBody>, 50k", measure([&]() {
+        Vec3 sum = { 0, 0, 0 };
+        for (const auto& object : objects) {
+            const BenchBody* body = object->getComponent<BenchBody>();
+            if (!body) continue;
+            sum += object->getComponent<BenchTransform>()->position + body->velocity;
+        }
+        consume(sum.x);
+    }), Count / 2);
+
+    report("archetype columns Transform, RigidBody, 50k", measure([&]() {
+        Vec3 sum = { 0, 0, 0 };
+        const BenchTransform* transforms = bodies.transforms.data<BenchTransform>();
+        const BenchBody* rigidBodies = bodies.bodies.data<BenchBody>();
+        for (size_t row = 0; row < bodies.size(); ++row) sum += transforms[row].position + rigidBodies[row].velocity;
+        consume(sum.x);
+    }), Count / 2);
+}
@@ -0,0 +1,76 @@
+#include "Bench.h"
+#include "Mat4.h"
+#include "TransformBatch.h"
+#include <numeric>
+#include <vector>
+
+// The same code runs as AdskBench and as AdskBenchScalar, which is built with
+// ADSK_MATH_SCALAR; comparing the two gives the SIMD speedup
+void benchMath()
+{
+    constexpr size_t Count = 100000;
+    BenchRandom random;
+
+    std::vector<Vec3> positions(Count);
+    std::vector<Quat> rotations(Count);
+    std::vector<Vec3> scales(Count);
+    std::vector<Mat4> matrices(Count);
+    for (size_t i = 0; i < Count; ++i) {
+        positions[i] = { random.uniform(-100.0f, 100.0f), random.uniform(-100.0f, 100.0f), random.uniform(-100.0f, 100.0f) };
+        rotations[i] = Quat::fromYawPitchRoll(random.uniform(-3.0f, 3.0f), random.uniform(-1.5f, 1.5f), random.uniform(-3.0f, 3.0f));
+        scales[i] = { random.uniform(0.5f, 2.0f), random.uniform(0.5f, 2.0f), random.uniform(0.5f, 2.0f) };
+        matrices[i] = Mat4::compose(scales[i], rotations[i], positions[i]);
+    }
+
+    std::vector<Mat4> out(Count);
+
+    // A chain of parent * local products, as a hierarchy update does
+    report("Mat4 product, 100k", measure([&]() {
+        for (size_t i = 0; i < Count; ++i) out[i] = matrices[i] * matrices[Count - 1 - i];
+        consume(out[Count / 2].m[3][0]);
+    }), Count);
+
+    report("Mat4 inverse, 100k", measure([&]() {
+        for (size_t i = 0; i < Count; ++i) out[i] = inverse(matrices[i]);
+        consume(out[Count / 2].m[3][0]);
+    }), Count);
+
+    report("transformPoint, 100k", measure([&]() {
+        Vec3 sum;
+        for (size_t i = 0; i < Count; ++i) sum += transformPoint(positions[i], matrices[Count - 1 - i]);
+        consume(sum.x + sum.y + sum.z);
+    }), Count);
+
+    report("Mat4::compose, 100k", measure([&]() {
+        for (size_t i = 0; i < Count; ++i) out[i] = Mat4::compose(scales[i], rotations[i], positions[i]);
+        consume(out[Count / 2].m[3][0]);
+    }), Count);
+
+    // The batched path over structure-of-arrays, as TransformSystem feeds it
+    std::vector<float> soaData[10];
+    for (std::vector<float>& values : soaData) values.resize(Count);
+    for (size_t i = 0; i < Count; ++i) {
+        soaData[0][i] = positions[i].x;
+        soaData[1][i] = positions[i].y;
+        soaData[2][i] = positions[i].z;
+        soaData[3][i] = rotations[i].x;
+        soaData[4][i] = rotations[i].y;
+        soaData[5][i] = rotations[i].z;
+        soaData[6][i] = rotations[i].w;
+        soaData[7][i] = scales[i].x;
+        soaData[8][i] = scales[i].y;
+        soaData[9][i] = scales[i].z;
+    }
+    const TransformSoA soa = {
+        soaData[0].data(), soaData[1].data(), soaData[2].data(),
+        soaData[3].data(), soaData[4].data(), soaData[5].data(), soaData[6].data(),
+        soaData[7].data(), soaData[8].data(), soaData[9].data()
+    };
+    std::vector<int32_t> indices(Count);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    report("composeTransforms, 100k", measure([&]() {
+        composeTransforms(soa, indices.data(), Count, out.data());
+        consume(out[Count / 2].m[3][0]);
+    }), Count);
+}
@@ -0,0 +1,96 @@
+#include "Bench.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+#include <string>
+#include <vector>
+
+// Occluders only read positions
+static Vertex corner(float x, float y, float z)
+{
+    return { x, y, z, 0.0f, 0.0f, 0.0f, 0xFFFFFFFFu, 0.0f, 0.0f };
+}
+
+// Unit cube, the occluder mesh of every building
+static const Vertex cubeVertices[8] = {
+    corner(-0.5f, -0.5f, -0.5f), corner(0.5f, -0.5f, -0.5f), corner(0.5f, 0.5f, -0.5f), corner(-0.5f, 0.5f, -0.5f),
+    corner(-0.5f, -0.5f, 0.5f), corner(0.5f, -0.5f, 0.5f), corner(0.5f, 0.5f, 0.5f), corner(-0.5f, 0.5f, 0.5f),
+};
+static const uint32_t cubeIndices[36] = {
+    0, 2, 1, 0, 3, 2,   4, 5, 6, 4, 6, 7,   0, 1, 5, 0, 5, 4,
+    3, 6, 2, 3, 7, 6,   0, 4, 7, 0, 7, 3,   1, 2, 6, 1, 6, 5,
+};
+
+// A city block grid seen from street level: buildings on a grid occlude most of
+// the small props scattered between and behind them. Mirrors Scene::cullVisible,
+// frustum culling first and then testing what is left against the occluders.
+static void benchCity(int blocks, size_t propCount)
+{
+    constexpr float Spacing = 20.0f;
+    const float extent = blocks * Spacing * 0.5f;
+    BenchRandom random(blocks);
+
+    std::vector<Mat4> buildings;
+    for (int z = 0; z < blocks; ++z) {
+        for (int x = 0; x < blocks; ++x) {
+            const Vec3 size(14.0f, random.uniform(10.0f, 40.0f), 14.0f);
+            const Vec3 center(-extent + (x + 0.5f) * Spacing, size.y * 0.5f, -extent + (z + 0.5f) * Spacing);
+            buildings.push_back(Mat4::scaling(size) * Mat4::translation(center));
+        }
+    }
+
+    FrustumCuller culler;
+    for (size_t i = 0; i < propCount; ++i) {
+        Aabb box;
+        const float x = random.uniform(-extent, extent);
+        const float z = random.uniform(-extent, extent);
+        const float half = random.uniform(0.25f, 1.5f);
+        box.min[0] = x - half; box.min[1] = 0.0f; box.min[2] = z - half;
+        box.max[0] = x + half; box.max[1] = 2.0f * half; box.max[2] = z + half;
+        culler.insert(box, static_cast<uint32_t>(i));
+    }
+
+    const Mat4 view = Mat4::lookAtLH({ 0.0f, 1.7f, -extent - 5.0f }, { 0.0f, 1.7f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+    const Mat4 viewProjection = view * Mat4::perspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 4.0f * extent);
+    JobSystem& jobs = JobSystem::getInstance();
+    OcclusionCuller occlusion;
+
+    const std::string suffix = ", " + std::to_string(buildings.size()) + " occluders, " + std::to_string(propCount / 1000) + "k boxes";
+
+    BenchResult result = measure([&]() {
+        occlusion.begin(viewProjection);
+        for (const Mat4& world : buildings) occlusion.addOccluder(cubeVertices, cubeIndices, 12, world);
+        occlusion.rasterize(jobs);
+        consume(occlusion.getDepth(occlusion.getLevelCount() - 1)[0]);
+    });
+    report("rasterize" + suffix, result, 0.0, std::to_string(occlusion.getStats().occluderTriangles) + " triangles drawn");
+
+    std::vector<uint32_t> values;
+    std::vector<uint32_t> slots;
+    result = measure([&]() {
+        values.clear();
+        culler.cull(viewProjection, 0.0f, jobs, values);
+        consume(static_cast<double>(values.size()));
+    });
+    report("frustum only" + suffix, result, static_cast<double>(propCount), std::to_string(values.size()) + " visible");
+
+    // The pyramid from the last raster run stays valid; only the tests are timed here
+    std::vector<Aabb> boxes;
+    result = measure([&]() {
+        values.clear();
+        slots.clear();
+        culler.cull(viewProjection, 0.0f, jobs, values, &slots);
+        boxes.resize(slots.size());
+        for (size_t i = 0; i < slots.size(); ++i) boxes[i] = culler.getBounds(slots[i]);
+        occlusion.cull(values, boxes, jobs);
+        consume(static_cast<double>(values.size()));
+    });
+    report("frustum + occlusion" + suffix, result, static_cast<double>(propCount), std::to_string(values.size()) + " visible");
+}
+
+void benchOcclusion()
+{
+    benchCity(8, 100000);
+    benchCity(16, 100000);
+    benchCity(32, 1000000);
+}
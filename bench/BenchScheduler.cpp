@@ -0,0 +1,110 @@
+#include "Bench.h"
+#include "JobSystem.h"
+#include "SystemScheduler.h"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Each bit stands for one component type; the systems below only use the masks
+// to get ordered, so any bits will do
+constexpr ComponentMask Bit(int n) { return ComponentMask(1) << n; }
+
+constexpr size_t ItemCount = 1 << 18;
+constexpr size_t MinChunk = 4096;
+
+// Reads its source columns and writes its own one, a few flops per item, the way
+// a movement or animation pass would
+class SyntheticSystem : public System {
+public:
+    SyntheticSystem(const char* name, std::vector<float>* output, std::vector<const std::vector<float>*> inputs,
+        ComponentMask reads, ComponentMask writes)
+        : name(name), output(output), inputs(std::move(inputs)), reads(reads), writes(writes) {}
+
+    const char* getName() const override { return name; }
+    ComponentMask getReadMask() const override { return reads; }
+    ComponentMask getWriteMask() const override { return writes; }
+
+    void update(float deltaTime, JobSystem& jobs) override {
+        jobs.parallelFor(output->size(), MinChunk, [this, deltaTime](size_t begin, size_t end) {
+            float* out = output->data();
+            for (size_t i = begin; i < end; ++i) {
+                float value = out[i];
+                for (const std::vector<float>* input : inputs) value += (*input)[i] * deltaTime;
+                out[i] = std::sqrt(value * value + 1.0f) - 0.999f * value;
+            }
+        });
+    }
+
+private:
+    const char* name;
+    std::vector<float>* output;
+    std::vector<const std::vector<float>*> inputs;
+    ComponentMask reads;
+    ComponentMask writes;
+};
+
+// Six systems in three waves: two independent writers, two passes that each read
+// one of them, an unrelated pass, and a final one that reads both middle passes
+struct SyntheticFrame {
+    std::vector<std::vector<float>> columns;
+    std::vector<std::unique_ptr<SyntheticSystem>> systems;
+
+    SyntheticFrame() : columns(6, std::vector<float>(ItemCount)) {
+        BenchRandom random(3);
+        for (auto& column : columns) {
+            for (float& value : column) value = random.uniform(-1.0f, 1.0f);
+        }
+
+        add("input", 0, {}, 0);
+        add("physics", 1, {}, 0);
+        add("animation", 2, { 0 }, Bit(0));
+        add("movement", 3, { 1 }, Bit(1));
+        add("audio", 4, {}, 0);
+        add("bounds", 5, { 2, 3 }, Bit(2) | Bit(3));
+    }
+
+    void add(const char* name, int output, std::vector<int> inputs, ComponentMask reads) {
+        std::vector<const std::vector<float>*> sources;
+        for (int input : inputs) sources.push_back(&columns[input]);
+        systems.push_back(std::make_unique<SyntheticSystem>(name, &columns[output], std::move(sources), reads, Bit(output)));
+    }
+};
+
+void benchScheduler()
+{
+    static const unsigned ThreadCounts[] = { 1, 2, 4, 8 };
+
+    SyntheticFrame frame;
+    double scheduledBase = 0.0;
+    double loopBase = 0.0;
+
+    for (unsigned threads : ThreadCounts) {
+        JobSystem jobs(threads);
+        SystemScheduler scheduler(jobs);
+        for (const auto& system : frame.systems) scheduler.addSystem(system.get());
+
+        const std::string suffix = ", " + std::to_string(threads) + " thread" + (threads > 1 ? "s" : "");
+
+        BenchResult result = measure([&]() {
+            scheduler.run(0.016f);
+            consume(frame.columns[5][0]);
+        });
+        if (threads == 1) scheduledBase = result.bestMilliseconds;
+        char note[64];
+        std::snprintf(note, sizeof(note), "%.2fx over 1 thread", scheduledBase / result.bestMilliseconds);
+        report("SystemScheduler::run, 6 systems" + suffix, result, frame.systems.size() * double(ItemCount), note);
+
+        // The same amount of work as back-to-back parallelFor passes with no graph
+        SyntheticSystem& flat = *frame.systems[4];
+        result = measure([&]() {
+            for (size_t i = 0; i < frame.systems.size(); ++i) flat.update(0.016f, jobs);
+            consume(frame.columns[4][0]);
+        });
+        if (threads == 1) loopBase = result.bestMilliseconds;
+        std::snprintf(note, sizeof(note), "%.2fx over 1 thread", loopBase / result.bestMilliseconds);
+        report("parallelFor, 6 passes" + suffix, result, frame.systems.size() * double(ItemCount), note);
+    }
+}
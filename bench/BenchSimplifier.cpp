@@ -0,0 +1,147 @@
+#include "Bench.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Closed-form test surfaces, so the error of a simplified mesh can be measured
+// exactly: distance from points on its triangles to the true surface
+struct TestSurface {
+    std::string name;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::function<float(const Vec3&)> distance;
+    float diagonal;
+};
+
+// Unit UV sphere; the first and last columns are separate vertices with the same
+// positions, so it has a texture seam from pole to pole
+static TestSurface makeSphere(uint32_t rings, uint32_t segments)
+{
+    TestSurface surface;
+    surface.name = "sphere";
+    for (uint32_t r = 0; r <= rings; ++r) {
+        const float theta = 3.14159265f * r / rings;
+        for (uint32_t s = 0; s <= segments; ++s) {
+            const float phi = 6.28318531f * s / segments;
+            const Vec3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            surface.vertices.push_back({ n.x, n.y, n.z, n.x, n.y, n.z, 0xFFFFFFFFu,
+                static_cast<float>(s) / segments, static_cast<float>(r) / rings });
+        }
+    }
+    for (uint32_t r = 0; r < rings; ++r) {
+        for (uint32_t s = 0; s < segments; ++s) {
+            const uint32_t a = r * (segments + 1) + s;
+            const uint32_t b = a + segments + 1;
+            surface.indices.insert(surface.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+    surface.distance = [](const Vec3& p) { return std::fabs(length(p) - 1.0f); };
+    surface.diagonal = 2.0f * std::sqrt(3.0f);
+    return surface;
+}
+
+// Height field over [-1, 1]^2 with an open boundary all around
+static TestSurface makeTerrain(uint32_t size)
+{
+    auto height = [](float x, float z) { return 0.1f * std::sin(3.0f * x) * std::cos(2.0f * z) + 0.05f * std::sin(7.0f * x + 5.0f * z); };
+
+    TestSurface surface;
+    surface.name = "terrain";
+    for (uint32_t j = 0; j <= size; ++j) {
+        for (uint32_t i = 0; i <= size; ++i) {
+            const float x = -1.0f + 2.0f * i / size;
+            const float z = -1.0f + 2.0f * j / size;
+            surface.vertices.push_back({ x, height(x, z), z, 0.0f, 1.0f, 0.0f, 0xFFFFFFFFu,
+                static_cast<float>(i) / size, static_cast<float>(j) / size });
+        }
+    }
+    for (uint32_t j = 0; j < size; ++j) {
+        for (uint32_t i = 0; i < size; ++i) {
+            const uint32_t a = j * (size + 1) + i;
+            const uint32_t b = a + size + 1;
+            surface.indices.insert(surface.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+    // Height difference scaled by the slope, the distance along the surface normal to first order
+    auto slope = [](float x, float z) {
+        const float dx = 0.3f * std::cos(3.0f * x) * std::cos(2.0f * z) + 0.35f * std::cos(7.0f * x + 5.0f * z);
+        const float dz = -0.2f * std::sin(3.0f * x) * std::sin(2.0f * z) + 0.25f * std::cos(7.0f * x + 5.0f * z);
+        return std::sqrt(1.0f + dx * dx + dz * dz);
+    };
+    surface.distance = [height, slope](const Vec3& p) { return std::fabs(p.y - height(p.x, p.z)) / slope(p.x, p.z); };
+    surface.diagonal = std::sqrt(8.0f + 0.09f);
+    return surface;
+}
+
+// Largest distance to the surface over each triangle's centroid and edge midpoints;
+// the corners are original vertices, which lie on it
+static float measureError(const TestSurface& surface, const std::vector<uint32_t>& indices)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Vec3 p[3];
+        for (int k = 0; k < 3; ++k) {
+            const Vertex& v = surface.vertices[indices[i + k]];
+            p[k] = Vec3(v.x, v.y, v.z);
+        }
+        const Vec3 samples[4] = { (p[0] + p[1] + p[2]) * (1.0f / 3.0f),
+            (p[0] + p[1]) * 0.5f, (p[1] + p[2]) * 0.5f, (p[2] + p[0]) * 0.5f };
+        for (const Vec3& sample : samples) worst = std::max(worst, surface.distance(sample));
+    }
+    return worst;
+}
+
+// The simplifier only knows the input mesh, so what it reports bounds the
+// distance to the true surface once the input's own error is added
+static const char* boundNote(const TestSurface& surface, const std::vector<uint32_t>& simplified, float reported)
+{
+    const float inputError = measureError(surface, surface.indices);
+    return reported + inputError >= measureError(surface, simplified) ? "" : ", BOUND MISSED";
+}
+
+static void benchSurface(const TestSurface& surface)
+{
+    const size_t triangleCount = surface.indices.size() / 3;
+    const std::string prefix = surface.name + " " + std::to_string(triangleCount / 1000) + "k";
+
+    // Halving from the full mesh down to a sixteenth, with no error limit, then
+    // once with the limit Mesh::buildLods uses per level
+    for (size_t divisor = 2; divisor <= 16; divisor *= 2) {
+        std::vector<uint32_t> simplified;
+        float reported = 0.0f;
+        const BenchResult result = measure([&]() {
+            simplified = simplifyMesh(surface.vertices, surface.indices, surface.indices.size() / divisor, FLT_MAX, &reported);
+            consume(static_cast<double>(simplified.size()));
+        }, 3, 0.0);
+
+        char note[128];
+        std::snprintf(note, sizeof(note), "%zu tris, error %.5f reported, %.5f measured%s",
+            simplified.size() / 3, reported / surface.diagonal, measureError(surface, simplified) / surface.diagonal,
+            boundNote(surface, simplified, reported));
+        report(prefix + " -> 1/" + std::to_string(divisor), result, static_cast<double>(triangleCount), note);
+    }
+
+    std::vector<uint32_t> simplified;
+    float reported = 0.0f;
+    const BenchResult result = measure([&]() {
+        simplified = simplifyMesh(surface.vertices, surface.indices, surface.indices.size() / 6 * 3, 0.05f * surface.diagonal, &reported);
+        consume(static_cast<double>(simplified.size()));
+    }, 3, 0.0);
+
+    char note[128];
+    std::snprintf(note, sizeof(note), "%zu tris, error %.5f reported, %.5f measured%s",
+        simplified.size() / 3, reported / surface.diagonal, measureError(surface, simplified) / surface.diagonal,
+        boundNote(surface, simplified, reported));
+    report(prefix + " -> 1/2, error limit", result, static_cast<double>(triangleCount), note);
+}
+
+// Errors are printed as fractions of the bounding box diagonal, like MeshLod::error
+void benchSimplifier()
+{
+    benchSurface(makeSphere(200, 400));
+    benchSurface(makeTerrain(256));
+}
@@ -0,0 +1,91 @@
+#include "Bench.h"
+#include "JobSystem.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Volatile, so the values folded into it have to be computed
+static volatile double sink = 0.0;
+
+BenchResult measure(const std::function<void()>& body, int minRuns, double minSeconds)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // One untimed run to fault in memory and warm the caches
+    body();
+
+    BenchResult result;
+    result.bestMilliseconds = 1e30;
+    double total = 0.0;
+    while (result.runs < minRuns || total < minSeconds * 1000.0) {
+        const Clock::time_point start = Clock::now();
+        body();
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        result.bestMilliseconds = std::min(result.bestMilliseconds, ms);
+        total += ms;
+        ++result.runs;
+    }
+    result.meanMilliseconds = total / result.runs;
+    return result;
+}
+
+void report(const std::string& name, const BenchResult& result, double items, const std::string& note)
+{
+    std::printf("  %-52s %10.3f ms  mean %10.3f ms", name.c_str(), result.bestMilliseconds, result.meanMilliseconds);
+    if (items > 0.0) std::printf("  %9.2f ns/item", result.bestMilliseconds * 1e6 / items);
+    if (!note.empty()) std::printf("  %s", note.c_str());
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+void consume(double value)
+{
+    sink = sink + value;
+}
+
+static const char* mathBackend()
+{
+#if defined(ADSK_SIMD_AVX2) && defined(ADSK_SIMD_FMA)
+    return "AVX2+FMA";
+#elif defined(ADSK_SIMD_AVX2)
+    return "AVX2";
+#elif defined(ADSK_SIMD_SSE)
+    return "SSE";
+#elif defined(ADSK_SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+struct Suite {
+    const char* name;
+    void (*run)();
+};
+
+static const Suite suites[] = {
+    { "math", benchMath },
+    { "aabbtree", benchAabbTree },
+    { "simplifier", benchSimplifier },
+    { "occlusion", benchOcclusion },
+    { "scheduler", benchScheduler },
+    { "archetype", benchArchetype },
+};
+
+// Runs every suite, or only the ones named on the command line
+int main(int argc, char** argv)
+{
+    std::printf("math: %s, job threads: %u\n", mathBackend(), JobSystem::getInstance().getThreadCount());
+
+    for (const Suite& suite : suites) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) selected |= std::strcmp(argv[i], suite.name) == 0;
+        if (!selected) continue;
+
+        std::printf("%s\n", suite.name);
+        suite.run();
+    }
+
+    return 0;
+}
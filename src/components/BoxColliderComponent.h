@@ -1,15 +1,13 @@
 #pragma once
 
-#define NOMINMAX
 #include "ColliderComponent.h"
-#include <d3dx9.h>
 
 class SceneObject;
 
 class BoxColliderComponent : public ColliderComponent {
-    Q_OBJECT
 public:
     ColliderType getType() const override { return BOX; }
+    std::string getTypeName() const override { return "BoxCollider"; }
 
-    bool checkCollision(const D3DXVECTOR3& position, const ColliderComponent* other, const D3DXVECTOR3& otherPosition) const override;
+    bool checkCollision(const Vec3& position, const ColliderComponent* other, const Vec3& otherPosition) const override;
 };
\ No newline at end of file
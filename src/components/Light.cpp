@@ -25,53 +25,43 @@ void Light::deserialize(const QJsonObject& data)
     color.b = static_cast<float>(data["colorB"].toDouble());
 }
 
-void Light::render(LPDIRECT3DDEVICE9 device)
+void Light::render(RenderDevice& device)
 {
-    D3DLIGHT9 L{};
-    L.Type = (type == LightType::Directional ? D3DLIGHT_DIRECTIONAL :
-        type == LightType::Point ? D3DLIGHT_POINT : D3DLIGHT_SPOT);
-    L.Diffuse = color;
-    L.Diffuse.r *= intensity;
-    L.Diffuse.g *= intensity;
-    L.Diffuse.b *= intensity;
-
-    auto* tr = getOwner()->getComponent<Transform>();
-    if (tr) {
-        const auto& pos = tr->getPosition();
-        const auto& rot = tr->getRotation();
-
-        L.Position = pos;
-
-        if (type != LightType::Point) {
-            D3DXVECTOR3 dir(0, 0, 1);
-            D3DXMATRIX rotationMatrix;
-
-            D3DXMatrixRotationYawPitchRoll(&rotationMatrix,
-                D3DXToRadian(rot.y),
-                D3DXToRadian(rot.x),
-                D3DXToRadian(rot.z));
-
-            D3DXVec3TransformNormal(&dir, &dir, &rotationMatrix);
-            D3DXVec3Normalize(&dir, &dir);
-            L.Direction = dir;
-        }
+    apply(device, getOwner()->getComponent<Transform>()->getWorldMatrix());
+}
+
+void Light::apply(RenderDevice& device, const Mat4& world)
+{
+    LightDesc L;
+    L.kind = (type == LightType::Directional ? LightKind::Directional :
+        type == LightType::Point ? LightKind::Point : LightKind::Spot);
+    L.diffuse = color;
+    L.diffuse.r *= intensity;
+    L.diffuse.g *= intensity;
+    L.diffuse.b *= intensity;
+
+    // World placement, so lights follow their parents
+    L.position = world.getTranslation();
+
+    if (type != LightType::Point) {
+        L.direction = normalize(world.getRow(2));
     }
 
     if (type == LightType::Point || type == LightType::Spot) {
-        L.Range = radius;
-        L.Attenuation0 = 1.0f;
-        L.Attenuation1 = 0.1f;
-        L.Attenuation2 = 0.01f;
+        L.range = radius;
+        L.attenuation[0] = 1.0f;
+        L.attenuation[1] = 0.1f;
+        L.attenuation[2] = 0.01f;
 
         if (type == LightType::Spot) {
-            L.Theta = D3DXToRadian(30.0f);
-            L.Phi = D3DXToRadian(45.0f);
-            L.Falloff = spotFalloff;
+            L.innerAngle = toRadians(30.0f);
+            L.outerAngle = toRadians(45.0f);
+            L.falloff = spotFalloff;
         }
     }
 
-    device->SetLight(index, &L);
-    device->LightEnable(index, TRUE);
+    device.setLight(index, L);
+    device.enableLight(index, true);
 }
 
 void Light::createInspector(QWidget* parent, QFormLayout* layout)
@@ -79,46 +69,50 @@ void Light::createInspector(QWidget* parent, QFormLayout* layout)
     auto* componentLabel = new QLabel("Light", parent);
     layout->addRow(componentLabel);
 
+    // Rows move when the owner's components change, so look this light up again
+    SceneObject* owner = getOwner();
+
     auto* combo = new QComboBox(parent);
     combo->addItems({ "Directional","Point","Spot" });
     combo->setCurrentIndex(int(type));
-    connect(combo, QOverload<int>::of(&QComboBox::currentIndexChanged),
-        [this](int i) { type = LightType(i); emit getOwner()->propertiesChanged(); });
+    QObject::connect(combo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+        [owner](int i) { if (Light* light = owner->getComponent<Light>()) { light->type = LightType(i); light->notifyChanged(); } });
     layout->addRow("Light Type", combo);
 
     auto* intens = new QDoubleSpinBox(parent);
     intens->setRange(0, 10); intens->setValue(intensity);
-    connect(intens, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
-        [this](double v) { intensity = float(v); emit getOwner()->propertiesChanged(); });
+    QObject::connect(intens, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+        [owner](double v) { if (Light* light = owner->getComponent<Light>()) { light->intensity = float(v); light->notifyChanged(); } });
     layout->addRow("Intensity", intens);
 
     auto* rad = new QDoubleSpinBox(parent);
     rad->setRange(0, 10000); rad->setValue(radius);
-    connect(rad, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
-        [this](double v) { radius = float(v); emit getOwner()->propertiesChanged(); });
+    QObject::connect(rad, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+        [owner](double v) { if (Light* light = owner->getComponent<Light>()) { light->radius = float(v); light->notifyChanged(); } });
     layout->addRow("Radius", rad);
 
     auto* fal = new QDoubleSpinBox(parent);
     fal->setRange(0, 90); fal->setValue(radius);
-    connect(fal, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
-        [this](double v) { spotFalloff = float(v); emit getOwner()->propertiesChanged(); });
+    QObject::connect(fal, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+        [owner](double v) { if (Light* light = owner->getComponent<Light>()) { light->spotFalloff = float(v); light->notifyChanged(); } });
     layout->addRow("Falloff", rad);
 
     auto* btn = new QPushButton(parent);
     QColor qc;
     qc.setRgbF(color.r, color.g, color.b);
     btn->setStyleSheet("background-color:" + qc.name());
-    connect(btn, &QPushButton::clicked, [this, btn]() {
+    QObject::connect(btn, &QPushButton::clicked, [owner, btn]() {
         QColor newC = QColorDialog::getColor();
-        if (newC.isValid()) {
-            color = {
+        Light* light = owner->getComponent<Light>();
+        if (light && newC.isValid()) {
+            light->color = {
                 static_cast<float>(newC.redF()),
                 static_cast<float>(newC.greenF()),
                 static_cast<float>(newC.blueF()),
                 1.0f
             };
             btn->setStyleSheet("background-color:" + newC.name());
-            emit getOwner()->propertiesChanged();
+            light->notifyChanged();
         }
         });
     layout->addRow("Color", btn);
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "Component.h"
-#include <d3dx9math.h>
+#include "Mat4.h"
+#include "RenderDevice.h"
 
 #include <QComboBox>
 #include <QDoubleSpinBox>
@@ -15,20 +16,22 @@ class Transform;
 enum class LightType { Directional, Point, Spot };
 
 class Light : public Component {
-    Q_OBJECT
 public:
-    explicit Light(QObject* parent = nullptr) : Component(parent) {}
+    Light() = default;
 
     QJsonObject serialize() const override;
     void deserialize(const QJsonObject& data) override;
 
     std::string getTypeName() const override { return "Light"; }
 
-    void render(LPDIRECT3DDEVICE9 device) override;
+    void render(RenderDevice& device) override;
+
+    // Sets the light up with an explicit world matrix, e.g. one taken from a RenderSnapshot
+    void apply(RenderDevice& device, const Mat4& world);
     void createInspector(QWidget* parent, QFormLayout* layout) override;
 
     LightType type = LightType::Point;
-    D3DCOLORVALUE color{ 1,1,1,1 };
+    Color color{ 1,1,1,1 };
     float intensity = 1.0f;
     float radius = 100.0f;
     float spotFalloff = 45.0f;
@@ -2,73 +2,69 @@
 #include "Transform.h"
 #include "ConsolePanel.h"
 #include "ResourceManager.h"
+#include "RenderQueue.h"
+#include "OcclusionCuller.h"
 
-#include <d3d9types.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include <QPushButton>
+#include <QCheckBox>
 #include <QFileDialog>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMessageBox>
 
+MeshRenderer::MeshRenderer(MeshRenderer&& other) noexcept
+    : Component(std::move(other)), boundsIndex(other.boundsIndex), boundsProxy(other.boundsProxy),
+    cullSet(other.cullSet), cullSlot(other.cullSlot), boundsVersion(other.boundsVersion),
+    mesh(std::move(other.mesh)), currentLod(other.currentLod), occluder(other.occluder),
+    meshPath(std::move(other.meshPath)), mrLabel(other.mrLabel)
+{
+    other.boundsIndex = nullptr;
+    other.boundsProxy = DynamicAabbTree::NullNode;
+    other.cullSet = nullptr;
+    other.cullSlot = FrustumCuller::NullSlot;
+}
+
 QJsonObject MeshRenderer::serialize() const
 {
     QJsonObject jsMr;
     jsMr["meshPath"] = meshPath;
+    jsMr["occluder"] = occluder;
     return jsMr;
 }
 
 void MeshRenderer::deserialize(const QJsonObject& data)
 {
     setMeshPath(data["meshPath"].toString());
+    occluder = data["occluder"].toBool(false);
 }
 
-void MeshRenderer::render(LPDIRECT3DDEVICE9 device) {
-    if (!mesh || mesh->vertices.empty()) return;
+void MeshRenderer::render(RenderDevice& device) {
+    RenderQueue queue;
+    queue.begin(device);
+    enqueue(queue, device, getOwner()->getComponent<Transform>()->getWorldMatrix());
+    queue.submit(device);
+}
 
-    if (needsRestore) {
-        if (!restoreDeviceObjects(device)) {
-            return;
-        }
-    }
+void MeshRenderer::enqueue(RenderQueue& queue, RenderDevice& device, const Mat4& world) {
+    if (mesh) mesh->enqueue(queue, device, world, currentLod);
+}
 
-    if (!vb || !ib) {
-        return;
-    }
+void MeshRenderer::addOccluder(OcclusionCuller& culler, const Mat4& world) const
+{
+    if (!mesh || mesh->vertices.empty() || mesh->indices.empty()) return;
+
+    size_t level = 0;
+    const float maxError = MaxOccluderError * length(mesh->maxBounds - mesh->minBounds);
+    while (level + 1 < mesh->lods.size() && mesh->lods[level + 1].error <= maxError) ++level;
 
-    updateWorldMatrix();
-
-    D3DXMATRIX old;
-    device->GetTransform(D3DTS_WORLD, &old);
-    device->SetTransform(D3DTS_WORLD, &cachedWorldMatrix);
-
-    D3DMATERIAL9 material;
-    ZeroMemory(&material, sizeof(material));
-    material.Diffuse = D3DXCOLOR(1.0f, 1.0f, 1.0f, 1.0f);
-    material.Ambient = D3DXCOLOR(1.0f, 1.0f, 1.0f, 1.0f);
-    device->SetMaterial(&material);
-
-    DWORD lightingState;
-    device->GetRenderState(D3DRS_LIGHTING, &lightingState);
-    device->SetRenderState(D3DRS_LIGHTING, TRUE);
-
-    device->SetStreamSource(0, vb, 0, sizeof(Vertex));
-    device->SetFVF(FVF_VERTEX);
-    device->SetIndices(ib);
-    device->DrawIndexedPrimitive(
-        D3DPT_TRIANGLELIST,
-        0,
-        0,
-        mesh->vertices.size(),
-        0,
-        mesh->indices.size() / 3
-    );
-
-    device->SetTransform(D3DTS_WORLD, &old);
-    device->SetRenderState(D3DRS_LIGHTING, lightingState);
+    const uint32_t triangleCount = mesh->lods.empty()
+        ? static_cast<uint32_t>(mesh->indices.size() / 3)
+        : mesh->lods[level].triangleCount;
+    culler.addOccluder(mesh->vertices.data(), mesh->getLodIndices(level), triangleCount, world);
 }
 
 void MeshRenderer::createInspector(QWidget* parent, QFormLayout* layout) {
@@ -82,85 +78,30 @@ void MeshRenderer::createInspector(QWidget* parent, QFormLayout* layout) {
     QPushButton* browseBtn = new QPushButton("Load Model", parent);
     layout->addRow("", browseBtn);
 
-    connect(browseBtn, &QPushButton::clicked, [this, pathField]() {
+    // Rows move when the owner's components change, so look this renderer up again
+    SceneObject* owner = getOwner();
+    QObject::connect(browseBtn, &QPushButton::clicked, [owner, pathField]() {
         QString file = QFileDialog::getOpenFileName(nullptr, "Choose Model", "",
             "Model Files (*.fbx *.obj *.dae *.gltf)");
 
-        if (!file.isEmpty()) {
-            setMeshPath(file);
+        MeshRenderer* renderer = owner->getComponent<MeshRenderer>();
+        if (renderer && !file.isEmpty()) {
+            renderer->setMeshPath(file);
             pathField->setText(file);
-            if (getOwner()) {
-                emit getOwner()->propertiesChanged();
-            }
+            renderer->notifyChanged();
         }
     });
-}
-
-void MeshRenderer::invalidateDeviceObjects()
-{
-    releaseResources();
-    needsRestore = true;
-}
-
-bool MeshRenderer::restoreDeviceObjects(LPDIRECT3DDEVICE9 device) {
-    if (!needsRestore || !mesh) return true;
-    if (mesh->vertices.empty() || mesh->indices.empty()) return false;
 
-    if (!device) {
-        ConsolePanel::sError("Cannot restore mesh buffers: invalid device");
-        return false;
-    }
-
-    releaseResources();
-
-    if (FAILED(device->CreateVertexBuffer(
-        mesh->vertices.size() * sizeof(Vertex),
-        D3DUSAGE_WRITEONLY,
-        FVF_VERTEX,
-        D3DPOOL_MANAGED,
-        &vb,
-        nullptr
-    ))) {
-        ConsolePanel::sError("Failed to create vertex buffer");
-        return false;
-    }
+    QCheckBox* occluderBox = new QCheckBox("Occluder", parent);
+    occluderBox->setChecked(occluder);
+    layout->addRow("", occluderBox);
 
-    void* ptr = nullptr;
-    if (FAILED(vb->Lock(0, 0, &ptr, 0))) {
-        ConsolePanel::sError("Failed to lock vertex buffer");
-        return false;
-    }
-    memcpy(ptr, mesh->vertices.data(), mesh->vertices.size() * sizeof(Vertex));
-    vb->Unlock();
-
-    if (FAILED(device->CreateIndexBuffer(
-        mesh->indices.size() * sizeof(WORD),
-        D3DUSAGE_WRITEONLY,
-        D3DFMT_INDEX16,
-        D3DPOOL_MANAGED,
-        &ib,
-        nullptr
-    ))) {
-        ConsolePanel::sError("Failed to create index buffer");
-        return false;
-    }
-
-    if (FAILED(ib->Lock(0, 0, &ptr, 0))) {
-        ConsolePanel::sError("Failed to lock index buffer");
-        ib->Release();
-        ib = nullptr;
-        return false;
-    }
-    memcpy(ptr, mesh->indices.data(), mesh->indices.size() * sizeof(WORD));
-    ib->Unlock();
-
-    needsRestore = false;
-    return true;
-}
-
-void MeshRenderer::onPropertiesChanged()
-{
-    worldMatrixValid = false;
+    QObject::connect(occluderBox, &QCheckBox::toggled, [owner](bool checked) {
+        if (MeshRenderer* renderer = owner->getComponent<MeshRenderer>()) {
+            renderer->setOccluder(checked);
+            renderer->notifyChanged();
+        }
+    });
 }
 
 void MeshRenderer::setMeshPath(const QString& path)
@@ -169,45 +110,32 @@ void MeshRenderer::setMeshPath(const QString& path)
 
     meshPath = path;
     if (loadMeshFromFile(path)) {
-        invalidateDeviceObjects();
-        if (getOwner()) {
-            emit getOwner()->propertiesChanged();
-        }
+        notifyChanged();
     }
 }
 
-bool MeshRenderer::isVisible(const D3DXMATRIX& viewProj) const
+bool MeshRenderer::getLocalBounds(Aabb& bounds) const
 {
     if (!mesh || mesh->vertices.empty()) return false;
 
-    D3DXVECTOR3 min = mesh->minBounds;
-    D3DXVECTOR3 max = mesh->maxBounds;
-
-    D3DXVECTOR3 corners[8] = {
-        D3DXVECTOR3(min.x, min.y, min.z),
-        D3DXVECTOR3(max.x, min.y, min.z),
-        D3DXVECTOR3(min.x, max.y, min.z),
-        D3DXVECTOR3(max.x, max.y, min.z),
-        D3DXVECTOR3(min.x, min.y, max.z),
-        D3DXVECTOR3(max.x, min.y, max.z),
-        D3DXVECTOR3(min.x, max.y, max.z),
-        D3DXVECTOR3(max.x, max.y, max.z)
+    bounds = {
+        { mesh->minBounds.x, mesh->minBounds.y, mesh->minBounds.z },
+        { mesh->maxBounds.x, mesh->maxBounds.y, mesh->maxBounds.z }
     };
+    return true;
+}
 
-    D3DXMATRIX worldViewProj = cachedWorldMatrix * viewProj;
+void MeshRenderer::unlinkBounds()
+{
+    if (boundsProxy == DynamicAabbTree::NullNode) return;
 
-    for (auto& corner : corners) {
-        D3DXVECTOR3 projected;
-        D3DXVec3TransformCoord(&projected, &corner, &worldViewProj);
+    boundsIndex->remove(boundsProxy);
+    boundsIndex = nullptr;
+    boundsProxy = DynamicAabbTree::NullNode;
 
-        if (projected.x >= -1.0f && projected.x <= 1.0f &&
-            projected.y >= -1.0f && projected.y <= 1.0f &&
-            projected.z >= 0.0f && projected.z <= 1.0f) {
-            return true;
-        }
-    }
-
-    return false;
+    cullSet->remove(cullSlot);
+    cullSet = nullptr;
+    cullSlot = FrustumCuller::NullSlot;
 }
 
 bool MeshRenderer::loadMeshFromFile(const QString& path) {
@@ -222,24 +150,3 @@ bool MeshRenderer::loadMeshFromFile(const QString& path) {
         return false;
     }
 }
-
-void MeshRenderer::releaseResources()
-{
-    if (vb) { vb->Release(); vb = nullptr; }
-    if (ib) { ib->Release(); ib = nullptr; }
-}
-
-void MeshRenderer::updateWorldMatrix()
-{
-    if (worldMatrixValid) return;
-
-    auto* tr = getOwner()->getComponent<Transform>();
-    if (tr) {
-        cachedWorldMatrix = tr->getWorldMatrix();
-    }
-    else {
-        D3DXMatrixIdentity(&cachedWorldMatrix);
-    }
-
-    worldMatrixValid = true;
-}
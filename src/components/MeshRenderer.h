@@ -3,65 +3,72 @@
 #include "Component.h"
 #include "Transform.h"
 #include "SceneObject.h"
+#include "DynamicAabbTree.h"
+#include "FrustumCuller.h"
+#include "Mesh.h"
 
-#include <d3dx9.h>
 #include <QString>
 #include <QJsonObject>
 #include <vector>
 
-struct Vertex {
-    float x, y, z;
-    float nx, ny, nz;
-    D3DCOLOR color;
-    float u, v;
-};
-
-#define FVF_VERTEX (D3DFVF_XYZ | D3DFVF_NORMAL | D3DFVF_DIFFUSE)
-
-class Mesh {
-public:
-    std::vector<Vertex> vertices;
-    std::vector<WORD> indices;
-    D3DXVECTOR3 minBounds;
-    D3DXVECTOR3 maxBounds;
-};
+class RenderQueue;
+class OcclusionCuller;
 
 class MeshRenderer : public Component {
-    Q_OBJECT
 public:
     MeshRenderer() = default;
-    ~MeshRenderer() override { invalidate(); }
+    ~MeshRenderer() override { unlinkBounds(); }
+
+    // Takes over the other's bounds entries, for archetype rows moving
+    MeshRenderer(MeshRenderer&& other) noexcept;
 
     QJsonObject serialize() const override;
     void deserialize(const QJsonObject& data) override;
 
     std::string getTypeName() const override { return "MeshRenderer"; }
 
-    void render(LPDIRECT3DDEVICE9 device) override;
+    void render(RenderDevice& device) override;
+
+    // Queues a draw with an explicit world matrix, e.g. one taken from a
+    // RenderSnapshot; the mesh is uploaded to the device first if needed
+    void enqueue(RenderQueue& queue, RenderDevice& device, const Mat4& world);
+
+    // Occluders are drawn into the CPU depth buffer that hides other meshes,
+    // at the coarsest level whose error stays within MaxOccluderError
+    bool isOccluder() const { return occluder; }
+    void setOccluder(bool value) { occluder = value; }
+    void addOccluder(OcclusionCuller& culler, const Mat4& world) const;
     void createInspector(QWidget* parent, QFormLayout* layout) override;
 
-    void invalidateDeviceObjects() override;
-    bool restoreDeviceObjects(LPDIRECT3DDEVICE9 device) override;
-    void onPropertiesChanged() override;
+    void onDetach() override { unlinkBounds(); }
 
     void setMeshPath(const QString& path);
     const QString& getMeshPath() const { return meshPath; }
 
-    bool isVisible(const D3DXMATRIX& viewProj) const;
+    // Model-space box of the loaded mesh; false while there is nothing to draw
+    bool getLocalBounds(Aabb& bounds) const;
 
 private:
-    LPDIRECT3DVERTEXBUFFER9 vb = nullptr;
-    LPDIRECT3DINDEXBUFFER9 ib = nullptr;
-    bool needsRestore = true;
+    // Entries in the scene's spatial index and culler, maintained by BoundsSystem
+    friend class BoundsSystem;
+    DynamicAabbTree* boundsIndex = nullptr;
+    int32_t boundsProxy = DynamicAabbTree::NullNode;
+    FrustumCuller* cullSet = nullptr;
+    uint32_t cullSlot = FrustumCuller::NullSlot;
+    uint32_t boundsVersion = 0;         // Transform version the entry was built from
+    void unlinkBounds();
 
     std::shared_ptr<Mesh> mesh;
-    D3DXMATRIX cachedWorldMatrix;
-    bool worldMatrixValid = false;
+
+    // Level drawn last frame, for Mesh::enqueue's hysteresis
+    uint32_t currentLod = 0;
+
+    // Of the bounds' diagonal; a coarser occluder could hide what it should not
+    static constexpr float MaxOccluderError = 0.01f;
+    bool occluder = false;
 
     QString meshPath;
-    QLabel* mrLabel;
+    QLabel* mrLabel = nullptr;
 
     bool loadMeshFromFile(const QString& path);
-    void releaseResources();
-    void updateWorldMatrix();
 };
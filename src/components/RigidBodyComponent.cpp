@@ -2,9 +2,18 @@
 #include "Transform.h"
 #include "SceneObject.h"
 
-RigidBodyComponent::RigidBodyComponent(QObject* parent)
-    : Component(parent)
+QJsonObject RigidBodyComponent::serialize() const
 {
+    QJsonObject jsRb;
+    jsRb["mass"] = mass;
+    jsRb["useGravity"] = useGravity;
+    return jsRb;
+}
+
+void RigidBodyComponent::deserialize(const QJsonObject& data)
+{
+    mass = static_cast<float>(data["mass"].toDouble(1.0));
+    useGravity = data["useGravity"].toBool(true);
 }
 
 void RigidBodyComponent::update(float deltaTime) {
@@ -17,11 +26,11 @@ void RigidBodyComponent::update(float deltaTime) {
         forces.y -= 9.81f * mass;
     }
 
-    D3DXVECTOR3 acceleration = forces / mass;
+    Vec3 acceleration = forces / mass;
 
     velocity += acceleration * deltaTime;
 
-    D3DXVECTOR3 position = transform->getPosition();
+    Vec3 position = transform->getPosition();
     position += velocity * deltaTime;
     transform->setPosition(position);
 
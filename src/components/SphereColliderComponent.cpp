@@ -1,17 +1,17 @@
 #include "SphereColliderComponent.h"
 
-bool SphereColliderComponent::checkCollision(const D3DXVECTOR3& position, const ColliderComponent* other,
-    const D3DXVECTOR3& otherPosition) const {
+bool SphereColliderComponent::checkCollision(const Vec3& position, const ColliderComponent* other,
+    const Vec3& otherPosition) const {
     if (!other) return false;
 
-    D3DXVECTOR3 center = position + offset;
+    Vec3 center = position + offset;
     float radius = size.x;
 
     if (other->getType() == SPHERE) {
-        D3DXVECTOR3 otherCenter = otherPosition + other->getOffset();
+        Vec3 otherCenter = otherPosition + other->getOffset();
         float otherRadius = other->getSize().x;
 
-        float distance = D3DXVec3Length(&(center - otherCenter));
+        float distance = length(center - otherCenter);
         return distance < (radius + otherRadius);
     }
     else if (other->getType() == BOX) {
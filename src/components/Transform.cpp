@@ -1,23 +1,39 @@
 #include "Transform.h"
 #include "SceneObject.h"
+#include "TransformHierarchy.h"
 
-D3DXMATRIX Transform::getWorldMatrix() const {
-    if (isDirty) {
-        D3DXMATRIX S, R, T;
-        const D3DXVECTOR3 rad = {
-            D3DXToRadian(rotation.x),
-            D3DXToRadian(rotation.y),
-            D3DXToRadian(rotation.z)
-        };
-
-        D3DXMatrixScaling(&S, scale.x, scale.y, scale.z);
-        D3DXMatrixRotationYawPitchRoll(&R, rad.y, rad.x, rad.z);
-        D3DXMatrixTranslation(&T, position.x, position.y, position.z);
-
-        cachedWorldMatrix = S * R * T;
-        isDirty = false;
-    }
-    return cachedWorldMatrix;
+Transform::Transform(Transform&& other) noexcept
+    : Component(std::move(other)), transformLabel(other.transformLabel),
+    position(other.position), rotation(other.rotation), eulerAngles(other.eulerAngles), eulerStale(other.eulerStale),
+    scale(other.scale), hierarchy(other.hierarchy), node(other.node), version(other.version)
+{
+    if (hierarchy) hierarchy->relocate(this);
+    other.hierarchy = nullptr;
+    other.node = TransformHierarchy::NoNode;
+}
+
+Mat4 Transform::getLocalMatrix() const {
+    return Mat4::compose(scale, rotation, position);
+}
+
+Mat4 Transform::getWorldMatrix() const {
+    return hierarchy ? hierarchy->getWorldMatrix(this) : getLocalMatrix();
+}
+
+Transform* Transform::getParent() const {
+    return hierarchy ? hierarchy->getParent(this) : nullptr;
+}
+
+void Transform::onDetach()
+{
+    if (hierarchy) hierarchy->remove(this);
+}
+
+void Transform::markDirty()
+{
+    // Attached transforms are bumped when the hierarchy recomputes them
+    if (hierarchy) hierarchy->markDirty(this);
+    else ++version;
 }
 
 QJsonObject Transform::serialize() const
@@ -26,9 +42,14 @@ QJsonObject Transform::serialize() const
     jsTr["posX"] = position.x;
     jsTr["posY"] = position.y;
     jsTr["posZ"] = position.z;
-    jsTr["rotX"] = rotation.x;
-    jsTr["rotY"] = rotation.y;
-    jsTr["rotZ"] = rotation.z;
+    const Vec3& degrees = getEulerAngles();
+    jsTr["rotX"] = degrees.x;
+    jsTr["rotY"] = degrees.y;
+    jsTr["rotZ"] = degrees.z;
+    jsTr["rotQX"] = rotation.x;
+    jsTr["rotQY"] = rotation.y;
+    jsTr["rotQZ"] = rotation.z;
+    jsTr["rotQW"] = rotation.w;
     jsTr["scaleX"] = scale.x;
     jsTr["scaleY"] = scale.y;
     jsTr["scaleZ"] = scale.z;
@@ -43,11 +64,23 @@ void Transform::deserialize(const QJsonObject& data)
         static_cast<float>(data["posZ"].toDouble())
         });
 
-    setRotation({
+    const Vec3 degrees(
         static_cast<float>(data["rotX"].toDouble()),
         static_cast<float>(data["rotY"].toDouble()),
-        static_cast<float>(data["rotZ"].toDouble())
-        });
+        static_cast<float>(data["rotZ"].toDouble()));
+
+    // Older scenes only have the Euler angles
+    if (data.contains("rotQW")) {
+        const Quat rot(
+            static_cast<float>(data["rotQX"].toDouble()),
+            static_cast<float>(data["rotQY"].toDouble()),
+            static_cast<float>(data["rotQZ"].toDouble()),
+            static_cast<float>(data["rotQW"].toDouble()));
+        if (applyRotation(normalize(rot), degrees)) notifyChanged(ObjectChangeTransform);
+    }
+    else {
+        setEulerAngles(degrees);
+    }
 
     setScale({
         static_cast<float>(data["scaleX"].toDouble()),
@@ -61,54 +94,94 @@ void Transform::createInspector(QWidget* parent, QFormLayout* layout)
     transformLabel = new QLabel("Transform", parent);
     layout->addRow(transformLabel);
 
-    auto createInput = [parent, layout](const QString& label, float value, auto setter) {
+    // Rows move when the owner's components change, so look this transform up again
+    SceneObject* owner = getOwner();
+    auto createInput = [parent, layout, owner](const QString& label, float value, void (Transform::*setter)(float)) {
         auto* spinner = new QDoubleSpinBox(parent);
         spinner->setRange(-100000, 100000);
         spinner->setValue(value);
 
         QObject::connect(spinner, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
-            [setter](double v) { (setter)(static_cast<float>(v)); });
+            [owner, setter](double v) {
+                if (Transform* transform = owner->getComponent<Transform>()) (transform->*setter)(static_cast<float>(v));
+            });
 
         layout->addRow(label, spinner);
         return spinner;
     };
 
-    createInput("Position X", position.x, [this](float v) { setPositionX(v); });
-    createInput("Position Y", position.y, [this](float v) { setPositionY(v); });
-    createInput("Position Z", position.z, [this](float v) { setPositionZ(v); });
+    createInput("Position X", position.x, &Transform::setPositionX);
+    createInput("Position Y", position.y, &Transform::setPositionY);
+    createInput("Position Z", position.z, &Transform::setPositionZ);
 
-    createInput("Rotation X", rotation.x, [this](float v) { setRotationX(v); });
-    createInput("Rotation Y", rotation.y, [this](float v) { setRotationY(v); });
-    createInput("Rotation Z", rotation.z, [this](float v) { setRotationZ(v); });
+    const Vec3& degrees = getEulerAngles();
+    createInput("Rotation X", degrees.x, &Transform::setRotationX);
+    createInput("Rotation Y", degrees.y, &Transform::setRotationY);
+    createInput("Rotation Z", degrees.z, &Transform::setRotationZ);
 
-    createInput("Scale X", scale.x, [this](float v) { setScaleX(v); });
-    createInput("Scale Y", scale.y, [this](float v) { setScaleY(v); });
-    createInput("Scale Z", scale.z, [this](float v) { setScaleZ(v); });
+    createInput("Scale X", scale.x, &Transform::setScaleX);
+    createInput("Scale Y", scale.y, &Transform::setScaleY);
+    createInput("Scale Z", scale.z, &Transform::setScaleZ);
 }
 
-void Transform::setPosition(const D3DXVECTOR3& pos)
+void Transform::setPosition(const Vec3& pos)
 {
     if (position.x != pos.x || position.y != pos.y || position.z != pos.z) {
         position = pos;
-        isDirty = true;
-        if (getOwner()) emit getOwner()->propertiesChanged();
+        markDirty();
+        notifyChanged(ObjectChangeTransform);
     }
 }
 
-void Transform::setRotation(const D3DXVECTOR3& rot)
+void Transform::setRotation(const Quat& rot)
+{
+    const Quat n = normalize(rot);
+    if (n == rotation) return;
+
+    rotation = n;
+    eulerStale = true;
+    markDirty();
+    notifyChanged(ObjectChangeTransform);
+}
+
+const Vec3& Transform::getEulerAngles() const
 {
-    if (rotation.x != rot.x || rotation.y != rot.y || rotation.z != rot.z) {
-        rotation = rot;
-        isDirty = true;
-        if (getOwner()) emit getOwner()->propertiesChanged();
+    if (eulerStale) {
+        const Vec3 ypr = toYawPitchRoll(rotation);
+        eulerAngles = { toDegrees(ypr.y), toDegrees(ypr.x), toDegrees(ypr.z) };
+        eulerStale = false;
     }
+    return eulerAngles;
+}
+
+void Transform::setEulerAngles(const Vec3& degrees)
+{
+    const Vec3& current = getEulerAngles();
+    if (degrees.x == current.x && degrees.y == current.y && degrees.z == current.z) return;
+
+    const Quat rot = Quat::fromYawPitchRoll(toRadians(degrees.y), toRadians(degrees.x), toRadians(degrees.z));
+    applyRotation(rot, degrees);
+    notifyChanged(ObjectChangeTransform);
+}
+
+// Returns false when neither the rotation nor its editor view changed
+bool Transform::applyRotation(const Quat& rot, const Vec3& degrees)
+{
+    const bool viewChanged = eulerStale || degrees.x != eulerAngles.x || degrees.y != eulerAngles.y || degrees.z != eulerAngles.z;
+    eulerAngles = degrees;
+    eulerStale = false;
+    if (rot == rotation) return viewChanged;
+
+    rotation = rot;
+    markDirty();
+    return true;
 }
 
-void Transform::setScale(const D3DXVECTOR3& scl)
+void Transform::setScale(const Vec3& scl)
 {
     if (scale.x != scl.x || scale.y != scl.y || scale.z != scl.z) {
         scale = scl;
-        isDirty = true;
-        if (getOwner()) emit getOwner()->propertiesChanged();
+        markDirty();
+        notifyChanged(ObjectChangeTransform);
     }
 }
\ No newline at end of file
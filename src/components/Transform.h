@@ -7,14 +7,18 @@
 #include <QWidget>
 #include <QJsonObject>
 #include <QLabel>
-#include <d3dx9math.h>
+#include "Mat4.h"
+#include <cstdint>
 
 class SceneObject;
+class TransformHierarchy;
 
 class Transform : public Component {
-    Q_OBJECT
 public:
-    explicit Transform(QObject* parent = nullptr) : Component(parent) {}
+    Transform() = default;
+
+    // Takes over the other's hierarchy node, for archetype rows moving
+    Transform(Transform&& other) noexcept;
 
     QJsonObject serialize() const override;
     void deserialize(const QJsonObject& data) override;
@@ -25,40 +29,64 @@ public:
     void setPositionY(float y) { setPosition({ position.x, y, position.z }); }
     void setPositionZ(float z) { setPosition({ position.x, position.y, z }); }
 
-    void setRotationX(float x) { setRotation({ x, rotation.y, rotation.z }); }
-    void setRotationY(float y) { setRotation({ rotation.x, y, rotation.z }); }
-    void setRotationZ(float z) { setRotation({ rotation.x, rotation.y, z }); }
+    void setRotationX(float x) { const Vec3& e = getEulerAngles(); setEulerAngles({ x, e.y, e.z }); }
+    void setRotationY(float y) { const Vec3& e = getEulerAngles(); setEulerAngles({ e.x, y, e.z }); }
+    void setRotationZ(float z) { const Vec3& e = getEulerAngles(); setEulerAngles({ e.x, e.y, z }); }
 
     void setScaleX(float x) { setScale({ x, scale.y, scale.z }); }
     void setScaleY(float y) { setScale({ scale.x, y, scale.z }); }
     void setScaleZ(float z) { setScale({ scale.x, scale.y, z }); }
 
-    void setPosition(const D3DXVECTOR3& pos);
-    void setRotation(const D3DXVECTOR3& rot);
-    void setScale(const D3DXVECTOR3& scl);
+    void setPosition(const Vec3& pos);
+    void setRotation(const Quat& rot);
+    void setScale(const Vec3& scl);
+
+    const Vec3& getPosition() const { return position; }
+    const Quat& getRotation() const { return rotation; }
+    const Vec3& getScale() const { return scale; }
+
+    // Applies delta after the current rotation
+    void rotate(const Quat& delta) { setRotation(rotation * delta); }
+
+    // Editor view of the rotation in degrees: X is pitch, Y is yaw, Z is roll. Values
+    // typed in are kept as entered; setting a quaternion only marks them stale, and
+    // they are derived again the next time they are asked for.
+    void setEulerAngles(const Vec3& degrees);
+    const Vec3& getEulerAngles() const;
+
+    // S*R*T of the local values, relative to the parent
+    Mat4 getLocalMatrix() const;
+
+    // Result of the scene's last hierarchy update; the local matrix while detached
+    Mat4 getWorldMatrix() const;
+    TransformHierarchy* getHierarchy() const { return hierarchy; }
+    Transform* getParent() const;
 
-    const D3DXVECTOR3& getPosition() const { return position; }
-    const D3DXVECTOR3& getRotation() const { return rotation; }
-    const D3DXVECTOR3& getScale() const { return scale; }
+    // Bumped whenever the world matrix changes. Caches derived from it keep the
+    // value they were built from and rebuild on a mismatch.
+    uint32_t getVersion() const { return version; }
 
-    D3DXMATRIX getWorldMatrix() const;
+    void onDetach() override;
     void createInspector(QWidget* parent, QFormLayout* layout) override;
 
 private:
-    QLabel* transformLabel;
-
-    D3DXVECTOR3 position{ 0, 0, 0 };
-    D3DXVECTOR3 rotation{ 0, 0, 0 };
-    D3DXVECTOR3 scale{ 1, 1, 1 };
-
-    mutable D3DXMATRIX cachedWorldMatrix;
-    mutable bool isDirty = true;
-
-    D3DXVECTOR3 getRotationRadians() const {
-        return {
-            D3DXToRadian(rotation.x),
-            D3DXToRadian(rotation.y),
-            D3DXToRadian(rotation.z)
-        };
-    }
+    friend class TransformHierarchy;
+
+    void markDirty();
+    bool applyRotation(const Quat& rot, const Vec3& degrees);
+
+    QLabel* transformLabel = nullptr;
+
+    Vec3 position{ 0, 0, 0 };
+    Quat rotation;
+    mutable Vec3 eulerAngles{ 0, 0, 0 };
+    mutable bool eulerStale = false;
+    Vec3 scale{ 1, 1, 1 };
+
+    // Slot in the owning scene's hierarchy, maintained by TransformHierarchy
+    TransformHierarchy* hierarchy = nullptr;
+    int32_t node = -1;
+
+    // Starts above the zero that dependents start from, so a first compare always misses
+    uint32_t version = 1;
 };
\ No newline at end of file
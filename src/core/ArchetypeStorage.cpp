@@ -0,0 +1,194 @@
+#include "ArchetypeStorage.h"
+#include "SceneObject.h"
+#include "Transform.h"
+#include "MeshRenderer.h"
+#include "Light.h"
+#include "RigidBodyComponent.h"
+#include "BoxColliderComponent.h"
+#include "SphereColliderComponent.h"
+#include <cassert>
+#include <atomic>
+
+namespace {
+    template<typename... Ts>
+    std::array<const ColumnOps*, sizeof...(Ts)> makeColumnOps(ComponentTypeList<Ts...>) {
+        return { { ColumnOps::of<Ts, Component>()... } };
+    }
+
+    // Indexed by ComponentTypeId
+    const ColumnOps* columnOps(ComponentTypeId id) {
+        static const auto ops = makeColumnOps(RegisteredComponents{});
+        return ops[id];
+    }
+}
+
+ArchetypeStorage::ArchetypeStorage()
+{
+    // The empty archetype always exists so freshly inserted objects have a row
+    findOrCreate(0);
+}
+
+ArchetypeStorage::~ArchetypeStorage()
+{
+    for (auto& archetype : archetypes) {
+        for (SceneObject* object : archetype->objects) {
+            object->storage = nullptr;
+            object->archetype = nullptr;
+        }
+    }
+}
+
+ArchetypeStorage& ArchetypeStorage::detached()
+{
+    static ArchetypeStorage storage;
+    return storage;
+}
+
+void ArchetypeStorage::insert(SceneObject* object)
+{
+    Archetype* empty = archetypes.front().get();
+    empty->objects.push_back(object);
+
+    object->storage = this;
+    object->archetype = empty;
+    object->mask = 0;
+    object->row = empty->objects.size() - 1;
+}
+
+void ArchetypeStorage::adopt(SceneObject* object)
+{
+    if (object->storage == this) return;
+
+    object->storage = this;
+    moveRow(object, object->mask);
+}
+
+void ArchetypeStorage::destroy(SceneObject* object)
+{
+    if (object->storage != this) return;
+
+    Archetype* archetype = object->archetype;
+    const size_t row = object->row;
+    for (size_t i = 0; i < archetype->columns.size(); ++i) {
+        archetype->get(static_cast<int>(i), row)->onDetach();
+    }
+    for (ComponentColumn& column : archetype->columns) {
+        column.swapRemove(row);
+    }
+    removeObject(archetype, row);
+
+    object->storage = nullptr;
+    object->archetype = nullptr;
+}
+
+Archetype* ArchetypeStorage::addColumn(SceneObject* object, ComponentTypeId id)
+{
+    assert(object->storage == this);
+
+    const ComponentMask bit = ComponentMask(1) << id;
+    assert(!(object->mask & bit));
+
+    return moveRow(object, object->mask | bit);
+}
+
+void ArchetypeStorage::removeComponent(SceneObject* object, ComponentTypeId id)
+{
+    assert(object->storage == this);
+
+    int column = object->archetype->columnOf(id);
+    if (column < 0) return;
+
+    object->archetype->get(column, object->row)->onDetach();
+    moveRow(object, object->mask & ~(ComponentMask(1) << id));
+}
+
+size_t ArchetypeStorage::nextQueryId()
+{
+    static std::atomic<size_t> counter{ 0 };
+    return counter++;
+}
+
+std::vector<Archetype*> ArchetypeStorage::match(size_t query, std::initializer_list<ComponentMask> required)
+{
+    std::lock_guard<std::mutex> lock(queryMutex);
+
+    if (query >= queries.size()) {
+        queries.resize(query + 1);
+    }
+    auto& cache = queries[query];
+    if (!cache) {
+        cache = std::make_unique<QueryCache>();
+        cache->required.assign(required.begin(), required.end());
+    }
+
+    // Archetypes are never destroyed, so only the new ones need testing
+    for (; cache->scanned < archetypes.size(); ++cache->scanned) {
+        Archetype* archetype = archetypes[cache->scanned].get();
+        bool matches = true;
+        for (ComponentMask mask : cache->required) {
+            matches &= (archetype->mask & mask) != 0;
+        }
+        if (matches) cache->matches.push_back(archetype);
+    }
+
+    return cache->matches;
+}
+
+Archetype* ArchetypeStorage::findOrCreate(ComponentMask mask)
+{
+    auto it = lookup.find(mask);
+    if (it != lookup.end()) {
+        return it->second;
+    }
+
+    auto archetype = std::make_unique<Archetype>();
+    archetype->mask = mask;
+    for (ComponentMask rest = mask; rest; rest &= rest - 1) {
+        ComponentTypeId id = lowestComponentId(rest);
+        archetype->columnIndex[id] = static_cast<int8_t>(archetype->columnIds.size());
+        archetype->columnIds.push_back(id);
+    }
+    archetype->columns.reserve(archetype->columnIds.size());
+    for (ComponentTypeId id : archetype->columnIds) {
+        archetype->columns.emplace_back(columnOps(id));
+    }
+
+    Archetype* raw = archetype.get();
+    archetypes.push_back(std::move(archetype));
+    lookup.emplace(mask, raw);
+    return raw;
+}
+
+Archetype* ArchetypeStorage::moveRow(SceneObject* object, ComponentMask mask)
+{
+    Archetype* source = object->archetype;
+    Archetype* target = findOrCreate(mask);
+    const size_t row = object->row;
+
+    // Every source column gives up the row, into the target or to destruction,
+    // and fills it from its last one, the same way removeObject does
+    for (size_t i = 0; i < source->columns.size(); ++i) {
+        const int column = target->columnOf(source->columnIds[i]);
+        if (column >= 0) target->columns[column].moveFrom(source->columns[i], row);
+        else source->columns[i].swapRemove(row);
+    }
+
+    removeObject(source, row);
+
+    target->objects.push_back(object);
+    object->archetype = target;
+    object->mask = mask;
+    object->row = target->objects.size() - 1;
+    return target;
+}
+
+void ArchetypeStorage::removeObject(Archetype* archetype, size_t row)
+{
+    const size_t last = archetype->objects.size() - 1;
+    if (row != last) {
+        SceneObject* moved = archetype->objects[last];
+        archetype->objects[row] = moved;
+        moved->row = row;
+    }
+    archetype->objects.pop_back();
+}
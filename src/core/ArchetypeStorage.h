@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Component.h"
+#include "ComponentColumn.h"
+#include "ComponentTypeId.h"
+#include <vector>
+#include <memory>
+#include <array>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <mutex>
+
+class SceneObject;
+
+// All objects sharing one exact component mask. Each column holds one component
+// type by value in ascending id order, rows line up across columns, and rows are
+// kept dense with swap-remove, so a row walk reads contiguous component memory.
+//
+// Components move whenever a row does: an object changing archetype, another
+// row filling a gap, or a column growing. Component pointers are only good until
+// the next structural change of the storage; keep the SceneObject instead.
+class Archetype {
+public:
+    Archetype() { columnIndex.fill(-1); }
+
+    ComponentMask getMask() const { return mask; }
+    size_t size() const { return objects.size(); }
+    size_t columnCount() const { return columns.size(); }
+    const std::vector<SceneObject*>& getObjects() const { return objects; }
+
+    int columnOf(ComponentTypeId id) const { return columnIndex[id]; }
+    ComponentTypeId idOfColumn(size_t column) const { return columnIds[column]; }
+
+    // Resolves a concrete type or a family base to the column that satisfies it
+    template<typename T>
+    int findColumn() const {
+        if constexpr (ComponentTraits<T>::concrete) {
+            return columnIndex[ComponentTraits<T>::id];
+        }
+        else {
+            ComponentMask found = mask & ComponentTraits<T>::mask;
+            return found ? columnIndex[lowestComponentId(found)] : -1;
+        }
+    }
+
+    template<typename T>
+    bool has() const { return (mask & componentMask<T>()) != 0; }
+
+    Component* get(int column, size_t row) const { return static_cast<Component*>(columns[column].base(row)); }
+    SceneObject* const* objectData() const { return objects.data(); }
+
+    // First component of a concrete type's column, for walking rows directly
+    template<typename T>
+    T* columnData(int column) const {
+        static_assert(ComponentTraits<T>::concrete, "Family bases have no single column type");
+        return columns[column].template data<T>();
+    }
+
+private:
+    friend class ArchetypeStorage;
+
+    ComponentMask mask = 0;
+    std::array<int8_t, MaxComponentTypes> columnIndex;
+    std::vector<ComponentTypeId> columnIds;
+    std::vector<ComponentColumn> columns;
+    std::vector<SceneObject*> objects;
+};
+
+// Owns the component data of a set of SceneObjects, grouped by archetype
+class ArchetypeStorage {
+public:
+    ArchetypeStorage();
+    ~ArchetypeStorage();
+
+    ArchetypeStorage(const ArchetypeStorage&) = delete;
+    ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+    // Home of objects that were created but not yet added to a scene
+    static ArchetypeStorage& detached();
+
+    void insert(SceneObject* object);
+    void adopt(SceneObject* object);
+    void destroy(SceneObject* object);
+
+    // Moves the object's row to the archetype with T added and builds T there
+    template<typename T, typename... Args>
+    T* addComponent(SceneObject* object, Args&&... args) {
+        constexpr ComponentTypeId id = ComponentTraits<T>::id;
+        Archetype* target = addColumn(object, id);
+        return target->columns[target->columnOf(id)].template emplaceBack<T>(std::forward<Args>(args)...);
+    }
+
+    // Detaches and destroys the component, then moves the row to the archetype without it
+    void removeComponent(SceneObject* object, ComponentTypeId id);
+
+    const std::vector<std::unique_ptr<Archetype>>& getArchetypes() const { return archetypes; }
+
+    // Archetypes holding every one of Ts (a family base matches any of its members).
+    // Each distinct query keeps a cached list that is only extended with archetypes
+    // created since it was last asked, so steady-state lookups don't scan anything.
+    // The result is a copy and safe to use while other threads query.
+    template<typename... Ts>
+    std::vector<Archetype*> match() {
+        static const size_t query = nextQueryId();
+        return match(query, { componentMask<Ts>()... });
+    }
+
+private:
+    struct QueryCache {
+        std::vector<ComponentMask> required;
+        std::vector<Archetype*> matches;
+        size_t scanned = 0;
+    };
+
+    static size_t nextQueryId();
+    std::vector<Archetype*> match(size_t query, std::initializer_list<ComponentMask> required);
+
+    Archetype* findOrCreate(ComponentMask mask);
+
+    // Moves the object's row to the archetype of mask, destroying the components
+    // that archetype has no column for. A column the old one lacked is left one
+    // row short, for the caller to fill.
+    Archetype* moveRow(SceneObject* object, ComponentMask mask);
+    Archetype* addColumn(SceneObject* object, ComponentTypeId id);
+
+    // Swap-removes the object at row; the columns are up to the caller
+    void removeObject(Archetype* archetype, size_t row);
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, Archetype*> lookup;
+
+    // Indexed by query id
+    std::vector<std::unique_ptr<QueryCache>> queries;
+    std::mutex queryMutex;
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+// Axis-aligned box in world units
+struct Aabb {
+    float min[3];
+    float max[3];
+
+    bool overlaps(const Aabb& other) const {
+        return min[0] <= other.max[0] && max[0] >= other.min[0]
+            && min[1] <= other.max[1] && max[1] >= other.min[1]
+            && min[2] <= other.max[2] && max[2] >= other.min[2];
+    }
+
+    bool contains(const Aabb& other) const {
+        return min[0] <= other.min[0] && max[0] >= other.max[0]
+            && min[1] <= other.min[1] && max[1] >= other.max[1]
+            && min[2] <= other.min[2] && max[2] >= other.max[2];
+    }
+
+    Aabb merged(const Aabb& other) const {
+        return {
+            { std::min(min[0], other.min[0]), std::min(min[1], other.min[1]), std::min(min[2], other.min[2]) },
+            { std::max(max[0], other.max[0]), std::max(max[1], other.max[1]), std::max(max[2], other.max[2]) }
+        };
+    }
+
+    Aabb expanded(float margin) const {
+        return {
+            { min[0] - margin, min[1] - margin, min[2] - margin },
+            { max[0] + margin, max[1] + margin, max[2] + margin }
+        };
+    }
+
+    float surfaceArea() const {
+        const float dx = max[0] - min[0];
+        const float dy = max[1] - min[1];
+        const float dz = max[2] - min[2];
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+};
+
+// Bounds of a local box under a row-vector 4x4 matrix laid out like Mat4
+inline Aabb transformAabb(const Aabb& local, const float* m) {
+    Aabb result;
+    for (int i = 0; i < 3; ++i) {
+        // Start from the translation row and add the extreme of each basis term
+        result.min[i] = result.max[i] = m[12 + i];
+        for (int j = 0; j < 3; ++j) {
+            const float a = m[j * 4 + i] * local.min[j];
+            const float b = m[j * 4 + i] * local.max[j];
+            result.min[i] += std::min(a, b);
+            result.max[i] += std::max(a, b);
+        }
+    }
+    return result;
+}
+
+inline bool overlapsSphere(const Aabb& box, const float center[3], float radius) {
+    float distanceSq = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+        const float v = std::clamp(center[i], box.min[i], box.max[i]) - center[i];
+        distanceSq += v * v;
+    }
+    return distanceSq <= radius * radius;
+}
+
+// Slab test; invDir is 1/dir per axis. On a hit, tEnter is the entry distance (0 when inside).
+inline bool intersectRay(const Aabb& box, const float origin[3], const float invDir[3], float maxT, float& tEnter) {
+    float tMin = 0.0f;
+    float tMax = maxT;
+    for (int i = 0; i < 3; ++i) {
+        float t0 = (box.min[i] - origin[i]) * invDir[i];
+        float t1 = (box.max[i] - origin[i]) * invDir[i];
+        if (t0 > t1) std::swap(t0, t1);
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if (tMin > tMax) return false;
+    }
+    tEnter = tMin;
+    return true;
+}
+
+// Points p with dot(normal, p) + d >= 0 are on the inner side
+struct Plane {
+    float normal[3];
+    float d;
+};
+
+struct Frustum {
+    enum Result { Outside, Intersects, Inside };
+
+    Plane planes[6];
+
+    // Extracts the clip planes of a row-vector view * projection matrix with D3D's
+    // [0, 1] depth range
+    static Frustum fromViewProjection(const float* m) {
+        auto column = [m](int c, int row) { return m[row * 4 + c]; };
+
+        Frustum f;
+        for (int row = 0; row < 4; ++row) {
+            const float c0 = column(0, row), c1 = column(1, row), c2 = column(2, row), c3 = column(3, row);
+            const float values[6] = { c3 + c0, c3 - c0, c3 + c1, c3 - c1, c2, c3 - c2 };
+            for (int p = 0; p < 6; ++p) {
+                if (row < 3) f.planes[p].normal[row] = values[p];
+                else f.planes[p].d = values[p];
+            }
+        }
+
+        for (Plane& plane : f.planes) {
+            const float length = std::sqrt(plane.normal[0] * plane.normal[0]
+                + plane.normal[1] * plane.normal[1]
+                + plane.normal[2] * plane.normal[2]);
+            if (length > 0.0f) {
+                plane.normal[0] /= length;
+                plane.normal[1] /= length;
+                plane.normal[2] /= length;
+                plane.d /= length;
+            }
+        }
+        return f;
+    }
+
+    Result classify(const Aabb& box) const {
+        const float center[3] = {
+            (box.min[0] + box.max[0]) * 0.5f,
+            (box.min[1] + box.max[1]) * 0.5f,
+            (box.min[2] + box.max[2]) * 0.5f
+        };
+        const float extent[3] = {
+            (box.max[0] - box.min[0]) * 0.5f,
+            (box.max[1] - box.min[1]) * 0.5f,
+            (box.max[2] - box.min[2]) * 0.5f
+        };
+
+        Result result = Inside;
+        for (const Plane& plane : planes) {
+            const float s = plane.normal[0] * center[0] + plane.normal[1] * center[1] + plane.normal[2] * center[2] + plane.d;
+            const float r = std::abs(plane.normal[0]) * extent[0] + std::abs(plane.normal[1]) * extent[1] + std::abs(plane.normal[2]) * extent[2];
+            if (s + r < 0.0f) return Outside;
+            if (s - r < 0.0f) result = Intersects;
+        }
+        return result;
+    }
+};
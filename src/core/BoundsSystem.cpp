@@ -0,0 +1,50 @@
+#include "BoundsSystem.h"
+#include "Scene.h"
+#include "SceneObject.h"
+#include "MeshRenderer.h"
+
+ComponentMask BoundsSystem::getReadMask() const
+{
+    return componentMask<Transform>() | componentMask<MeshRenderer>();
+}
+
+ComponentMask BoundsSystem::getWriteMask() const
+{
+    return componentMask<MeshRenderer>();
+}
+
+void BoundsSystem::update(float, JobSystem&)
+{
+    scene.view<Transform, MeshRenderer>().each([this](SceneObject& object, Transform& transform, MeshRenderer& renderer) {
+        if (renderer.boundsVersion != transform.getVersion()) sync(object);
+    });
+}
+
+void BoundsSystem::sync(SceneObject& object)
+{
+    auto* renderer = object.getComponent<MeshRenderer>();
+    if (!renderer) return;
+
+    const Transform* transform = object.getComponent<Transform>();
+    renderer->boundsVersion = transform->getVersion();
+
+    Aabb local;
+    if (!renderer->getLocalBounds(local)) {
+        renderer->unlinkBounds();
+        return;
+    }
+
+    const Mat4 world = transform->getWorldMatrix();
+    const Aabb bounds = transformAabb(local, world.data());
+
+    if (renderer->boundsProxy == DynamicAabbTree::NullNode) {
+        renderer->boundsIndex = &index;
+        renderer->boundsProxy = index.insert(bounds, object.getHandle().value);
+        renderer->cullSet = &culler;
+        renderer->cullSlot = culler.insert(bounds, object.getHandle().value);
+    }
+    else {
+        index.update(renderer->boundsProxy, bounds);
+        culler.update(renderer->cullSlot, bounds);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SystemScheduler.h"
+#include "DynamicAabbTree.h"
+#include "FrustumCuller.h"
+
+class Scene;
+class SceneObject;
+
+// Keeps the scene's spatial index and frustum culler in step with mesh world
+// bounds. Runs after the transform pass; each renderer remembers the transform version its entry was
+// built from, so unmoved meshes cost one integer compare. Only those bounds fields
+// are written; the rest of MeshRenderer belongs to the frame (see FrameOwnedMask).
+class BoundsSystem : public System {
+public:
+    BoundsSystem(Scene& scene, DynamicAabbTree& index, FrustumCuller& culler)
+        : scene(scene), index(index), culler(culler) {}
+
+    const char* getName() const override { return "Bounds"; }
+    ComponentMask getReadMask() const override;
+    ComponentMask getWriteMask() const override;
+
+    void update(float deltaTime, JobSystem& jobs) override;
+
+    // Inserts, moves or drops the object's entries to match its MeshRenderer
+    void sync(SceneObject& object);
+
+private:
+    Scene& scene;
+    DynamicAabbTree& index;
+    FrustumCuller& culler;
+};
@@ -0,0 +1,25 @@
+#include "ChangeBus.h"
+#include "SceneObject.h"
+
+void ChangeBus::publish(SceneObject* object, uint32_t changes)
+{
+    // Only the first change since the last collect queues the object
+    if (object->pendingChanges.fetch_or(changes, std::memory_order_acq_rel) != 0) return;
+
+    SceneObject* top = head.load(std::memory_order_relaxed);
+    do {
+        object->nextPending = top;
+    } while (!head.compare_exchange_weak(top, object, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void ChangeBus::collect(std::vector<ObjectModification>& out)
+{
+    SceneObject* node = head.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+        // Read the link first: once the flags are cleared the object can be queued again
+        SceneObject* next = node->nextPending;
+        uint32_t changes = node->pendingChanges.exchange(0, std::memory_order_acq_rel);
+        out.push_back({ node->getHandle(), changes });
+        node = next;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "SlotMap.h"
+#include "objectChange.h"
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+class SceneObject;
+
+struct ObjectModification {
+    EntityHandle handle;
+    uint32_t changes;
+};
+
+// Lock-free dirty list for scene objects. publish() may be called from any thread:
+// it ORs the flags into the object and, on the first change since the last collect,
+// pushes the object onto an intrusive stack. collect() takes the whole stack in one
+// exchange, so listeners hear about each object at most once per drain no matter
+// how often it changed.
+class ChangeBus {
+public:
+    void publish(SceneObject* object, uint32_t changes);
+
+    // Owning thread only; objects must stay alive until collected
+    void collect(std::vector<ObjectModification>& out);
+
+private:
+    std::atomic<SceneObject*> head{ nullptr };
+};
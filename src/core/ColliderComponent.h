@@ -1,23 +1,59 @@
 #pragma once
 
 #include "Component.h"
-#include <d3dx9.h>
+#include "Vec.h"
+#include "Transform.h"
 
 class ColliderComponent : public Component {
 public:
     enum ColliderType { BOX, SPHERE };
 
+    QJsonObject serialize() const override {
+        QJsonObject js;
+        js["offsetX"] = offset.x;
+        js["offsetY"] = offset.y;
+        js["offsetZ"] = offset.z;
+        js["sizeX"] = size.x;
+        js["sizeY"] = size.y;
+        js["sizeZ"] = size.z;
+        return js;
+    }
+
+    void deserialize(const QJsonObject& data) override {
+        offset = Vec3(
+            static_cast<float>(data["offsetX"].toDouble(0.0)),
+            static_cast<float>(data["offsetY"].toDouble(0.0)),
+            static_cast<float>(data["offsetZ"].toDouble(0.0)));
+        size = Vec3(
+            static_cast<float>(data["sizeX"].toDouble(1.0)),
+            static_cast<float>(data["sizeY"].toDouble(1.0)),
+            static_cast<float>(data["sizeZ"].toDouble(1.0)));
+    }
+
     virtual ColliderType getType() const = 0;
-    virtual bool checkCollision(const D3DXVECTOR3& position, const ColliderComponent* other,
-        const D3DXVECTOR3& otherPosition) const = 0;
+    virtual bool checkCollision(const Vec3& position, const ColliderComponent* other,
+        const Vec3& otherPosition) const = 0;
 
-    void setOffset(const D3DXVECTOR3& offset) { this->offset = offset; }
-    const D3DXVECTOR3& getOffset() const { return offset; }
+    void setOffset(const Vec3& offset) { this->offset = offset; }
+    const Vec3& getOffset() const { return offset; }
 
-    void setSize(const D3DXVECTOR3& size) { this->size = size; }
-    const D3DXVECTOR3& getSize() const { return size; }
+    void setSize(const Vec3& size) { this->size = size; }
+    const Vec3& getSize() const { return size; }
+
+    // World position of the owner's transform, refreshed only when its version changes
+    const Vec3& getWorldPosition(const Transform& transform) {
+        if (positionVersion != transform.getVersion()) {
+            worldPosition = transform.getWorldMatrix().getTranslation();
+            positionVersion = transform.getVersion();
+        }
+        return worldPosition;
+    }
 
 protected:
-    D3DXVECTOR3 offset = { 0, 0, 0 };
-    D3DXVECTOR3 size = { 1, 1, 1 };
+    Vec3 offset = { 0, 0, 0 };
+    Vec3 size = { 1, 1, 1 };
+
+private:
+    Vec3 worldPosition = { 0, 0, 0 };
+    uint32_t positionVersion = 0;
 };
\ No newline at end of file
@@ -0,0 +1,7 @@
+#include "Component.h"
+#include "SceneObject.h"
+
+void Component::notifyChanged(uint32_t changes)
+{
+    if (owner) owner->notifyChanged(changes);
+}
@@ -1,36 +1,47 @@
 #pragma once
-#include "d3d9.h"
-#include <QObject>
+#include "objectChange.h"
 #include <QJsonObject>
 #include <QFormLayout>
+#include <cstdint>
+#include <string>
 
 class SceneObject;
+class RenderDevice;
 
-class Component : public QObject {
-    Q_OBJECT
+// Plain runtime data; only the inspector widgets built in createInspector are Qt objects
+class Component {
 public:
-    explicit Component(QObject* parent = nullptr) : QObject(parent) {}
+    Component() = default;
     virtual ~Component() = default;
 
+    Component(const Component&) = delete;
+    Component& operator=(const Component&) = delete;
+
     virtual QJsonObject serialize() const { return QJsonObject(); }
     virtual void deserialize(const QJsonObject& data) { Q_UNUSED(data); }
 
     virtual void onAttach() {}
     virtual void onDetach() {}
     virtual void update(float dt) {}
-    virtual void render(LPDIRECT3DDEVICE9 device) {}
+    virtual void render(RenderDevice& device) {}
     virtual void createInspector(QWidget* parent, QFormLayout* layout) {}
 
-    virtual void onPropertiesChanged() {}
     virtual std::string getTypeName() const { return "Component"; }
 
     virtual void invalidate() {}
     virtual void invalidateDeviceObjects() {}
-    virtual bool restoreDeviceObjects(LPDIRECT3DDEVICE9 device) { return true; }
+    virtual bool restoreDeviceObjects(RenderDevice& device) { return true; }
 
     void setOwner(SceneObject* owner) { this->owner = owner; }
     SceneObject* getOwner() const { return owner; }
 
+protected:
+    // Archetype columns store components by value and move them between rows
+    Component(Component&&) = default;
+
+    // Flags the owner on its scene's change bus; safe from any thread
+    void notifyChanged(uint32_t changes = ObjectChangeProperties);
+
 private:
     SceneObject* owner = nullptr;
 };
\ No newline at end of file
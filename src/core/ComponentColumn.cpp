@@ -0,0 +1,50 @@
+#include "ComponentColumn.h"
+
+ComponentColumn::~ComponentColumn()
+{
+    for (size_t row = 0; row < count; ++row) {
+        ops->destroy(at(row));
+    }
+    if (bytes) ::operator delete(bytes, std::align_val_t(ops->align));
+}
+
+ComponentColumn::ComponentColumn(ComponentColumn&& other) noexcept
+    : ops(other.ops), bytes(other.bytes), count(other.count), capacity(other.capacity)
+{
+    other.bytes = nullptr;
+    other.count = 0;
+    other.capacity = 0;
+}
+
+void ComponentColumn::moveFrom(ComponentColumn& from, size_t row)
+{
+    ops->relocate(grow(), from.at(row));
+    ++count;
+
+    const size_t last = from.count - 1;
+    if (row != last) from.ops->relocate(from.at(row), from.at(last));
+    --from.count;
+}
+
+void ComponentColumn::swapRemove(size_t row)
+{
+    const size_t last = count - 1;
+    ops->destroy(at(row));
+    if (row != last) ops->relocate(at(row), at(last));
+    --count;
+}
+
+void* ComponentColumn::grow()
+{
+    if (count == capacity) {
+        const size_t newCapacity = capacity ? capacity * 2 : 16;
+        unsigned char* newBytes = static_cast<unsigned char*>(::operator new(newCapacity * ops->size, std::align_val_t(ops->align)));
+        for (size_t row = 0; row < count; ++row) {
+            ops->relocate(newBytes + row * ops->size, at(row));
+        }
+        if (bytes) ::operator delete(bytes, std::align_val_t(ops->align));
+        bytes = newBytes;
+        capacity = newCapacity;
+    }
+    return at(count);
+}
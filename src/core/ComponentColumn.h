@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// How a column moves and destroys values of a type it only knows by size
+struct ColumnOps {
+    size_t size;
+    size_t align;
+
+    // Move-constructs the value at to from the one at from, then destroys from
+    void (*relocate)(void* to, void* from);
+    void (*destroy)(void* value);
+
+    // Address of the Base subobject of the value, for access through a common base
+    void* (*base)(void* value);
+
+    template<typename T, typename Base = T>
+    static const ColumnOps* of() {
+        static const ColumnOps ops = {
+            sizeof(T), alignof(T),
+            [](void* to, void* from) {
+                T* source = static_cast<T*>(from);
+                new (to) T(std::move(*source));
+                source->~T();
+            },
+            [](void* value) { static_cast<T*>(value)->~T(); },
+            [](void* value) -> void* { return static_cast<Base*>(static_cast<T*>(value)); }
+        };
+        return &ops;
+    }
+};
+
+// Values of one type stored by value, side by side in row order. Growing and
+// removing relocate values through their move constructor, so an address into a
+// column only holds until the next structural change.
+class ComponentColumn {
+public:
+    explicit ComponentColumn(const ColumnOps* ops) : ops(ops) {}
+    ~ComponentColumn();
+
+    ComponentColumn(ComponentColumn&& other) noexcept;
+    ComponentColumn(const ComponentColumn&) = delete;
+    ComponentColumn& operator=(const ComponentColumn&) = delete;
+    ComponentColumn& operator=(ComponentColumn&&) = delete;
+
+    size_t size() const { return count; }
+    const ColumnOps* getOps() const { return ops; }
+
+    void* at(size_t row) const { return bytes + row * ops->size; }
+    void* base(size_t row) const { return ops->base(at(row)); }
+
+    // Only valid for the exact type the column was made for
+    template<typename T>
+    T* data() const { return reinterpret_cast<T*>(bytes); }
+
+    // Constructs a value in a new last row
+    template<typename T, typename... Args>
+    T* emplaceBack(Args&&... args) {
+        T* value = new (grow()) T(std::forward<Args>(args)...);
+        ++count;
+        return value;
+    }
+
+    // Moves row of from to a new last row here; from's last value fills the gap
+    void moveFrom(ComponentColumn& from, size_t row);
+
+    // Destroys row; the last value fills the gap
+    void swapRemove(size_t row);
+
+private:
+    // Room for one more value, past the current last row
+    void* grow();
+
+    const ColumnOps* ops;
+    unsigned char* bytes = nullptr;
+    size_t count = 0;
+    size_t capacity = 0;
+};
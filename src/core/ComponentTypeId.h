@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+class Transform;
+class MeshRenderer;
+class Light;
+class RigidBodyComponent;
+class ColliderComponent;
+class BoxColliderComponent;
+class SphereColliderComponent;
+
+using ComponentTypeId = uint8_t;
+using ComponentMask = uint64_t;
+constexpr size_t MaxComponentTypes = 64;
+
+template<typename... Ts>
+struct ComponentTypeList {
+    static constexpr size_t size = sizeof...(Ts);
+};
+
+// Every concrete component type is registered here; its position in the list is its id.
+// Ids are assigned at compile time, so adding a type only means appending it.
+using RegisteredComponents = ComponentTypeList<
+    Transform,
+    MeshRenderer,
+    Light,
+    RigidBodyComponent,
+    BoxColliderComponent,
+    SphereColliderComponent
+>;
+
+static_assert(RegisteredComponents::size <= MaxComponentTypes, "Too many component types for ComponentMask");
+
+template<typename T, typename List>
+struct ComponentIndex;
+
+template<typename T, typename... Ts>
+struct ComponentIndex<T, ComponentTypeList<T, Ts...>> : std::integral_constant<size_t, 0> {};
+
+template<typename T, typename U, typename... Ts>
+struct ComponentIndex<T, ComponentTypeList<U, Ts...>>
+    : std::integral_constant<size_t, 1 + ComponentIndex<T, ComponentTypeList<Ts...>>::value> {};
+
+// Concrete components map to a single id. Abstract bases name the family of
+// registered types that satisfy a lookup for them.
+template<typename T>
+struct ComponentTraits {
+    static constexpr bool concrete = true;
+    static constexpr ComponentTypeId id = static_cast<ComponentTypeId>(ComponentIndex<T, RegisteredComponents>::value);
+    static constexpr ComponentMask mask = ComponentMask(1) << id;
+};
+
+template<typename... Ts>
+constexpr ComponentMask familyMask(ComponentTypeList<Ts...>) {
+    return (ComponentMask(0) | ... | ComponentTraits<Ts>::mask);
+}
+
+template<>
+struct ComponentTraits<ColliderComponent> {
+    static constexpr bool concrete = false;
+    static constexpr ComponentMask mask = familyMask(ComponentTypeList<BoxColliderComponent, SphereColliderComponent>{});
+};
+
+template<typename T>
+constexpr ComponentMask componentMask() { return ComponentTraits<T>::mask; }
+
+// Expects a non-zero mask
+inline ComponentTypeId lowestComponentId(ComponentMask mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<ComponentTypeId>(index);
+#else
+    return static_cast<ComponentTypeId>(__builtin_ctzll(mask));
+#endif
+}
@@ -0,0 +1,41 @@
+#include "ComponentUpdateSystem.h"
+#include "ArchetypeStorage.h"
+
+namespace {
+    // Rigid bodies are stepped by PhysicsSystem, and the frame owns what it draws
+    constexpr ComponentMask updatedMask = familyMask(RegisteredComponents{}) & ~componentMask<RigidBodyComponent>() & ~FrameOwnedMask;
+
+    constexpr size_t MinChunk = 256;
+}
+
+ComponentMask ComponentUpdateSystem::getReadMask() const
+{
+    return updatedMask;
+}
+
+ComponentMask ComponentUpdateSystem::getWriteMask() const
+{
+    return updatedMask;
+}
+
+void ComponentUpdateSystem::update(float deltaTime, JobSystem& jobs)
+{
+    if (!enabled) return;
+
+    for (const auto& archetype : storage.getArchetypes()) {
+        if (archetype->size() == 0 || !(archetype->getMask() & updatedMask)) continue;
+
+        for (size_t column = 0; column < archetype->columnCount(); ++column) {
+            const ComponentMask bit = ComponentMask(1) << archetype->idOfColumn(column);
+            if (!(bit & updatedMask)) continue;
+
+            const Archetype& table = *archetype;
+            const int col = static_cast<int>(column);
+            jobs.parallelFor(table.size(), MinChunk, [&table, col, deltaTime](size_t begin, size_t end) {
+                for (size_t row = begin; row < end; ++row) {
+                    table.get(col, row)->update(deltaTime);
+                }
+            });
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "SystemScheduler.h"
+
+class ArchetypeStorage;
+
+// Calls Component::update on every component while the scene is playing. Each
+// column is split into chunks across the job pool, so update() must only touch
+// its own component. Types in FrameOwnedMask are skipped.
+class ComponentUpdateSystem : public System {
+public:
+    explicit ComponentUpdateSystem(ArchetypeStorage& storage) : storage(storage) {}
+
+    const char* getName() const override { return "ComponentUpdate"; }
+    ComponentMask getReadMask() const override;
+    ComponentMask getWriteMask() const override;
+
+    void update(float deltaTime, JobSystem& jobs) override;
+
+    void setEnabled(bool value) { enabled = value; }
+    bool isEnabled() const { return enabled; }
+
+private:
+    ArchetypeStorage& storage;
+    bool enabled = false;
+};
@@ -0,0 +1,221 @@
+#include "DynamicAabbTree.h"
+#include <cassert>
+
+int32_t DynamicAabbTree::allocateNode()
+{
+    if (freeList == NullNode) {
+        nodes.push_back({});
+        nodes.back().parent = NullNode;
+        nodes.back().height = -1;
+        freeList = static_cast<int32_t>(nodes.size() - 1);
+    }
+
+    const int32_t index = freeList;
+    Node& node = nodes[index];
+    freeList = node.parent;
+    node.parent = NullNode;
+    node.child1 = NullNode;
+    node.child2 = NullNode;
+    node.height = 0;
+    node.userData = 0;
+    return index;
+}
+
+void DynamicAabbTree::freeNode(int32_t index)
+{
+    nodes[index].parent = freeList;
+    nodes[index].height = -1;
+    freeList = index;
+}
+
+int32_t DynamicAabbTree::insert(const Aabb& bounds, uint32_t userData)
+{
+    const int32_t proxy = allocateNode();
+    nodes[proxy].tight = bounds;
+    nodes[proxy].fat = bounds.expanded(margin);
+    nodes[proxy].userData = userData;
+
+    insertLeaf(proxy);
+    ++leafCount;
+    return proxy;
+}
+
+void DynamicAabbTree::remove(int32_t proxy)
+{
+    assert(proxy >= 0 && proxy < static_cast<int32_t>(nodes.size()) && nodes[proxy].isLeaf());
+
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --leafCount;
+}
+
+bool DynamicAabbTree::update(int32_t proxy, const Aabb& bounds)
+{
+    Node& node = nodes[proxy];
+    node.tight = bounds;
+
+    // Keep the fat box while it still holds the object and is not much larger
+    // than a freshly fattened one, otherwise a shrinking object keeps a stale box
+    const Aabb fat = bounds.expanded(margin);
+    if (node.fat.contains(bounds) && fat.expanded(margin * 4.0f).contains(node.fat)) {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    nodes[proxy].fat = fat;
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicAabbTree::clear()
+{
+    nodes.clear();
+    root = NullNode;
+    freeList = NullNode;
+    leafCount = 0;
+}
+
+void DynamicAabbTree::insertLeaf(int32_t leaf)
+{
+    if (root == NullNode) {
+        root = leaf;
+        nodes[root].parent = NullNode;
+        return;
+    }
+
+    // Descend towards the sibling with the lowest surface-area cost
+    const Aabb leafBox = nodes[leaf].fat;
+    int32_t index = root;
+    while (!nodes[index].isLeaf()) {
+        const Node& node = nodes[index];
+        const float area = node.fat.surfaceArea();
+        const float combinedArea = node.fat.merged(leafBox).surfaceArea();
+
+        // Cost of pairing with this node, and the cost pushed down to the children
+        const float cost = 2.0f * combinedArea;
+        const float inheritance = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int32_t child) {
+            const Aabb merged = leafBox.merged(nodes[child].fat);
+            if (nodes[child].isLeaf()) return merged.surfaceArea() + inheritance;
+            return merged.surfaceArea() - nodes[child].fat.surfaceArea() + inheritance;
+        };
+
+        const float cost1 = descendCost(node.child1);
+        const float cost2 = descendCost(node.child2);
+        if (cost < cost1 && cost < cost2) break;
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int32_t sibling = index;
+    const int32_t oldParent = nodes[sibling].parent;
+    const int32_t newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].fat = leafBox.merged(nodes[sibling].fat);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == NullNode) {
+        root = newParent;
+    }
+    else if (nodes[oldParent].child1 == sibling) {
+        nodes[oldParent].child1 = newParent;
+    }
+    else {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    refitUpwards(nodes[leaf].parent);
+}
+
+void DynamicAabbTree::removeLeaf(int32_t leaf)
+{
+    if (leaf == root) {
+        root = NullNode;
+        return;
+    }
+
+    const int32_t parent = nodes[leaf].parent;
+    const int32_t grandParent = nodes[parent].parent;
+    const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == NullNode) {
+        root = sibling;
+        nodes[sibling].parent = NullNode;
+        freeNode(parent);
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+    else nodes[grandParent].child2 = sibling;
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    refitUpwards(grandParent);
+}
+
+void DynamicAabbTree::refitUpwards(int32_t index)
+{
+    while (index != NullNode) {
+        index = balance(index);
+
+        Node& node = nodes[index];
+        const Node& child1 = nodes[node.child1];
+        const Node& child2 = nodes[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.fat = child1.fat.merged(child2.fat);
+
+        index = node.parent;
+    }
+}
+
+// Rotates the taller grandchild up when the children's heights differ by more than one.
+// Returns the node that now sits where index was.
+int32_t DynamicAabbTree::balance(int32_t indexA)
+{
+    Node& a = nodes[indexA];
+    if (a.isLeaf() || a.height < 2) return indexA;
+
+    const int32_t indexB = a.child1;
+    const int32_t indexC = a.child2;
+    const int32_t heightDelta = nodes[indexC].height - nodes[indexB].height;
+
+    auto rotate = [this, indexA](int32_t up, int32_t stay) {
+        // up becomes the parent of indexA; its shorter child moves down under indexA
+        Node& a = nodes[indexA];
+        Node& u = nodes[up];
+        const int32_t f = u.child1;
+        const int32_t g = u.child2;
+
+        u.child1 = indexA;
+        u.parent = a.parent;
+        a.parent = up;
+
+        if (u.parent == NullNode) root = up;
+        else if (nodes[u.parent].child1 == indexA) nodes[u.parent].child1 = up;
+        else nodes[u.parent].child2 = up;
+
+        const bool keepF = nodes[f].height > nodes[g].height;
+        const int32_t tall = keepF ? f : g;
+        const int32_t shortChild = keepF ? g : f;
+
+        u.child2 = tall;
+        if (a.child1 == up) a.child1 = shortChild;
+        else a.child2 = shortChild;
+        nodes[shortChild].parent = indexA;
+
+        a.fat = nodes[stay].fat.merged(nodes[shortChild].fat);
+        a.height = 1 + std::max(nodes[stay].height, nodes[shortChild].height);
+        u.fat = a.fat.merged(nodes[tall].fat);
+        u.height = 1 + std::max(a.height, nodes[tall].height);
+        return up;
+    };
+
+    if (heightDelta > 1) return rotate(indexC, indexB);
+    if (heightDelta < -1) return rotate(indexB, indexC);
+    return indexA;
+}
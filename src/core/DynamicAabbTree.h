@@ -0,0 +1,170 @@
+#pragma once
+
+#include "Bounds.h"
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+// Incrementally maintained bounding volume hierarchy. Leaves store the exact box
+// and a fattened copy; moves that stay inside the fat box only refresh the exact
+// box, anything else removes and reinserts the leaf. Insertion picks the sibling
+// with the lowest surface-area cost and the tree is kept balanced with AVL-style
+// rotations, so depth stays logarithmic under arbitrary motion.
+class DynamicAabbTree {
+public:
+    static constexpr int32_t NullNode = -1;
+
+    explicit DynamicAabbTree(float margin = 0.1f) : margin(margin) {}
+
+    int32_t insert(const Aabb& bounds, uint32_t userData);
+    void remove(int32_t proxy);
+
+    // Returns true when the leaf left its fat box and was reinserted
+    bool update(int32_t proxy, const Aabb& bounds);
+    void clear();
+
+    uint32_t getUserData(int32_t proxy) const { return nodes[proxy].userData; }
+    const Aabb& getBounds(int32_t proxy) const { return nodes[proxy].tight; }
+    size_t size() const { return leafCount; }
+    int32_t getHeight() const { return root == NullNode ? 0 : nodes[root].height; }
+
+    // fn(userData) for every leaf whose exact box overlaps the box
+    template<typename Fn>
+    void queryAabb(const Aabb& box, Fn&& fn) const {
+        query([&box](const Aabb& b) { return b.overlaps(box); }, fn);
+    }
+
+    template<typename Fn>
+    void querySphere(const float center[3], float radius, Fn&& fn) const {
+        query([center, radius](const Aabb& b) { return overlapsSphere(b, center, radius); }, fn);
+    }
+
+    // Subtrees entirely inside the frustum are reported without further tests
+    template<typename Fn>
+    void queryFrustum(const Frustum& frustum, Fn&& fn) const {
+        if (root == NullNode) return;
+
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(root);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+
+            const Frustum::Result result = frustum.classify(node.fat);
+            if (result == Frustum::Outside) continue;
+
+            if (node.isLeaf()) {
+                if (frustum.classify(node.tight) != Frustum::Outside) fn(node.userData);
+            }
+            else if (result == Frustum::Inside) {
+                reportSubtree(node.child1, fn);
+                reportSubtree(node.child2, fn);
+            }
+            else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+    // fn(userData, distance) is called for leaves the ray enters within maxDistance
+    // and returns the new maximum distance: its argument to keep only closer hits,
+    // maxDistance to see every hit, or 0 to stop.
+    template<typename Fn>
+    void raycast(const float origin[3], const float dir[3], float maxDistance, Fn&& fn) const {
+        if (root == NullNode) return;
+
+        const float invDir[3] = { 1.0f / dir[0], 1.0f / dir[1], 1.0f / dir[2] };
+        float maxT = maxDistance;
+
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(root);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+
+            float t;
+            if (!intersectRay(node.fat, origin, invDir, maxT, t)) continue;
+
+            if (node.isLeaf()) {
+                if (!intersectRay(node.tight, origin, invDir, maxT, t)) continue;
+                const float value = fn(node.userData, t);
+                if (value <= 0.0f) return;
+                maxT = std::min(maxT, value);
+            }
+            else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+private:
+    struct Node {
+        Aabb fat;
+        Aabb tight;
+        int32_t parent;         // next free node while on the free list
+        int32_t child1;
+        int32_t child2;
+        int32_t height;         // 0 for leaves, -1 while free
+        uint32_t userData;
+
+        bool isLeaf() const { return child1 == NullNode; }
+    };
+
+    template<typename Test, typename Fn>
+    void query(Test&& test, Fn& fn) const {
+        if (root == NullNode) return;
+
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(root);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+
+            if (!test(node.fat)) continue;
+            if (node.isLeaf()) {
+                if (test(node.tight)) fn(node.userData);
+            }
+            else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+    template<typename Fn>
+    void reportSubtree(int32_t start, Fn& fn) const {
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(start);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+
+            if (node.isLeaf()) {
+                fn(node.userData);
+            }
+            else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+    int32_t allocateNode();
+    void freeNode(int32_t index);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    void refitUpwards(int32_t index);
+    int32_t balance(int32_t index);
+
+    std::vector<Node> nodes;
+    int32_t root = NullNode;
+    int32_t freeList = NullNode;
+    size_t leafCount = 0;
+    float margin;
+};
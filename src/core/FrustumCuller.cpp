@@ -0,0 +1,176 @@
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "Simd.h"
+#include <chrono>
+#include <cmath>
+
+uint32_t FrustumCuller::insert(const Aabb& bounds, uint32_t data)
+{
+    if (freeSlots.empty()) {
+        // Grow by a whole group so the SIMD loop never needs a scalar tail
+        const uint32_t first = static_cast<uint32_t>(userData.size());
+        for (std::vector<float>* column : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ }) {
+            column->resize(first + 4, 0.0f);
+        }
+        userData.resize(first + 4, FreeSlot);
+        for (uint32_t i = 4; i > 0; --i) freeSlots.push_back(first + i - 1);
+    }
+
+    const uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+
+    userData[slot] = data;
+    update(slot, bounds);
+    ++liveCount;
+    return slot;
+}
+
+void FrustumCuller::update(uint32_t slot, const Aabb& bounds)
+{
+    centerX[slot] = (bounds.min[0] + bounds.max[0]) * 0.5f;
+    centerY[slot] = (bounds.min[1] + bounds.max[1]) * 0.5f;
+    centerZ[slot] = (bounds.min[2] + bounds.max[2]) * 0.5f;
+    extentX[slot] = (bounds.max[0] - bounds.min[0]) * 0.5f;
+    extentY[slot] = (bounds.max[1] - bounds.min[1]) * 0.5f;
+    extentZ[slot] = (bounds.max[2] - bounds.min[2]) * 0.5f;
+}
+
+Aabb FrustumCuller::getBounds(uint32_t slot) const
+{
+    return {
+        { centerX[slot] - extentX[slot], centerY[slot] - extentY[slot], centerZ[slot] - extentZ[slot] },
+        { centerX[slot] + extentX[slot], centerY[slot] + extentY[slot], centerZ[slot] + extentZ[slot] }
+    };
+}
+
+void FrustumCuller::remove(uint32_t slot)
+{
+    update(slot, Aabb{ { 0, 0, 0 }, { 0, 0, 0 } });
+    userData[slot] = FreeSlot;
+    freeSlots.push_back(slot);
+    --liveCount;
+}
+
+void FrustumCuller::clear()
+{
+    for (std::vector<float>* column : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ }) {
+        column->clear();
+    }
+    userData.clear();
+    freeSlots.clear();
+    liveCount = 0;
+}
+
+void FrustumCuller::cull(const Mat4& viewProjection, float minScreenSize, JobSystem& jobs, std::vector<uint32_t>& visible,
+    std::vector<uint32_t>* visibleSlots)
+{
+    const auto start = std::chrono::steady_clock::now();
+    stats = CullStats();
+
+    const Frustum frustum = Frustum::fromViewProjection(viewProjection.data());
+    std::copy(frustum.planes, frustum.planes + 6, planes);
+
+    // A sphere of radius r at clip depth w spans r * scale / w of the viewport
+    // height, where scale is the projection's y scale: the length of the y
+    // column of view * projection, since the view part is a rotation.
+    const float* m = viewProjection.data();
+    for (int i = 0; i < 4; ++i) wRow[i] = m[i * 4 + 3];
+    const float scale = std::sqrt(m[1] * m[1] + m[5] * m[5] + m[9] * m[9]);
+    sizeScale = minScreenSize > 0.0f ? (scale * scale) / (minScreenSize * minScreenSize) : 0.0f;
+
+    const size_t groups = userData.size() / 4;
+    results.resize(groups);
+    jobs.parallelFor(groups, MinGroupsPerJob, [this](size_t begin, size_t end) {
+        cullGroups(begin, end);
+    });
+
+    // Branch-free compaction: every lane is written and only visible ones advance
+    static constexpr uint8_t bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+    const size_t base = visible.size();
+    visible.resize(base + liveCount + 4);
+    uint32_t* out = visible.data() + base;
+    const size_t slotBase = visibleSlots ? visibleSlots->size() : 0;
+    if (visibleSlots) visibleSlots->resize(slotBase + liveCount + 4);
+    uint32_t* slotOut = visibleSlots ? visibleSlots->data() + slotBase : nullptr;
+    size_t written = 0;
+
+    for (size_t g = 0; g < groups; ++g) {
+        const int live = (results[g] >> 8) & 0xF;
+        const int outside = results[g] & live & 0xF;
+        const int small = (results[g] >> 4) & live & ~outside & 0xF;
+        const int inside = live & ~outside & ~small;
+
+        stats.tested += bitCount[live];
+        stats.frustumCulled += bitCount[outside];
+        stats.sizeCulled += bitCount[small];
+        if (!inside) continue;
+
+        const uint32_t* data = &userData[g * 4];
+        if (slotOut) {
+            for (int lane = 0; lane < 4; ++lane) {
+                out[written] = data[lane];
+                slotOut[written] = static_cast<uint32_t>(g * 4 + lane);
+                written += (inside >> lane) & 1;
+            }
+            continue;
+        }
+        for (int lane = 0; lane < 4; ++lane) {
+            out[written] = data[lane];
+            written += (inside >> lane) & 1;
+        }
+    }
+    stats.visible = static_cast<uint32_t>(written);
+    visible.resize(base + written);
+    if (visibleSlots) visibleSlots->resize(slotBase + written);
+
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Four boxes per iteration against each plane: the box is outside when its
+// center is farther behind the plane than its projected radius
+// |n.x| * e.x + |n.y| * e.y + |n.z| * e.z.
+void FrustumCuller::cullGroups(size_t begin, size_t end)
+{
+    Float4 planeN[6][3], planeAbs[6][3], planeD[6];
+    for (int p = 0; p < 6; ++p) {
+        for (int k = 0; k < 3; ++k) {
+            planeN[p][k] = simdSplat(planes[p].normal[k]);
+            planeAbs[p][k] = simdSplat(std::abs(planes[p].normal[k]));
+        }
+        planeD[p] = simdSplat(planes[p].d);
+    }
+
+    const Float4 zero = simdSplat(0.0f);
+    const Float4 w0 = simdSplat(wRow[0]), w1 = simdSplat(wRow[1]), w2 = simdSplat(wRow[2]), w3 = simdSplat(wRow[3]);
+    const Float4 scale = simdSplat(sizeScale);
+    const bool sizeCulling = sizeScale > 0.0f;
+
+    for (size_t g = begin; g < end; ++g) {
+        const size_t i = g * 4;
+        const Float4 cx = simdLoad(&centerX[i]), cy = simdLoad(&centerY[i]), cz = simdLoad(&centerZ[i]);
+        const Float4 ex = simdLoad(&extentX[i]), ey = simdLoad(&extentY[i]), ez = simdLoad(&extentZ[i]);
+
+        int outside = 0;
+        for (int p = 0; p < 6; ++p) {
+            const Float4 distance = simdMadd(planeN[p][0], cx, simdMadd(planeN[p][1], cy, simdMadd(planeN[p][2], cz, planeD[p])));
+            const Float4 radius = simdMadd(planeAbs[p][0], ex, simdMadd(planeAbs[p][1], ey, simdMul(planeAbs[p][2], ez)));
+            outside |= simdLessMask(simdAdd(distance, radius), zero);
+        }
+
+        // Too small: r^2 * scale^2 < (w * minSize)^2, only for spheres wholly in front (w > r)
+        int small = 0;
+        if (sizeCulling) {
+            const Float4 w = simdMadd(w0, cx, simdMadd(w1, cy, simdMadd(w2, cz, w3)));
+            const Float4 radiusSq = simdMadd(ex, ex, simdMadd(ey, ey, simdMul(ez, ez)));
+            const Float4 wSq = simdMul(w, w);
+            small = simdLessMask(simdMul(radiusSq, scale), wSq)
+                & simdLessMask(radiusSq, wSq) & simdLessMask(zero, w);
+        }
+
+        const uint32_t* data = &userData[i];
+        int live = 0;
+        for (int lane = 0; lane < 4; ++lane) live |= (data[lane] != FreeSlot) << lane;
+
+        results[g] = static_cast<uint16_t>(outside | (small << 4) | (live << 8));
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Bounds.h"
+#include "Mat4.h"
+#include <vector>
+#include <cstdint>
+
+class JobSystem;
+
+struct CullStats {
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+    uint32_t frustumCulled = 0;
+    uint32_t sizeCulled = 0;        // inside the frustum but below the size threshold
+    double milliseconds = 0.0;
+};
+
+// Flat list of world boxes, kept as centers and half extents in
+// structure-of-arrays form so cull() can test four boxes per plane at a time.
+// Slots are stable; freed ones are reused and hold an empty box at the origin
+// that is filtered out by its user data.
+class FrustumCuller {
+public:
+    static constexpr uint32_t NullSlot = UINT32_MAX;
+
+    uint32_t insert(const Aabb& bounds, uint32_t userData);
+    void update(uint32_t slot, const Aabb& bounds);
+    void remove(uint32_t slot);
+    void clear();
+
+    size_t size() const { return liveCount; }
+
+    // Appends the user data of every box that is at least partly inside the
+    // frustum of a row-vector view * projection matrix and whose bounding sphere
+    // covers at least minScreenSize of the viewport height. Chunks run on jobs.
+    // When visibleSlots is given, the slot of each appended value is appended to it.
+    void cull(const Mat4& viewProjection, float minScreenSize, JobSystem& jobs, std::vector<uint32_t>& visible,
+        std::vector<uint32_t>* visibleSlots = nullptr);
+
+    Aabb getBounds(uint32_t slot) const;
+
+    const CullStats& getStats() const { return stats; }
+
+private:
+    void cullGroups(size_t begin, size_t end);
+
+    static constexpr uint32_t FreeSlot = UINT32_MAX;
+    static constexpr size_t MinGroupsPerJob = 256;
+
+    // Padded to a multiple of four
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<uint32_t> userData;
+    std::vector<uint32_t> freeSlots;
+    size_t liveCount = 0;
+
+    // Per-frame inputs and outputs of cullGroups
+    Plane planes[6];
+    float wRow[4];                  // clip w as a function of the world position
+    float sizeScale = 0.0f;         // squared projection scale over squared threshold; 0 turns it off
+    std::vector<uint16_t> results;  // per group: lanes outside (bits 0-3), too small (4-7), live (8-11)
+
+    CullStats stats;
+};
@@ -0,0 +1,137 @@
+#include "JobSystem.h"
+#include <cstdlib>
+
+namespace {
+    // Identifies the pool and queue owned by the calling thread, if any
+    thread_local const JobSystem* workerSystem = nullptr;
+    thread_local size_t workerIndex = 0;
+
+    unsigned defaultThreadCount() {
+        if (const char* value = std::getenv("ADSK_JOB_THREADS")) {
+            int requested = std::atoi(value);
+            if (requested > 0) return static_cast<unsigned>(requested);
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+JobSystem& JobSystem::getInstance()
+{
+    static JobSystem instance(defaultThreadCount());
+    return instance;
+}
+
+JobSystem::JobSystem(unsigned threadCount)
+{
+    const size_t workerCount = threadCount > 1 ? threadCount - 1 : 0;
+
+    for (size_t i = 0; i < workerCount + 1; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t JobSystem::currentQueue() const
+{
+    return workerSystem == this ? workerIndex : workers.size();
+}
+
+void JobSystem::submit(Job job, JobCounter& counter)
+{
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+    if (workers.empty()) {
+        // No pool to hand the job to
+        job();
+        counter.pending.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    WorkQueue& queue = *queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back({ std::move(job), &counter });
+    }
+
+    queued.fetch_add(1);
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    const size_t home = currentQueue();
+    while (!counter.isDone()) {
+        if (!tryRunOne(home)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::pop(size_t queue, bool newest, Task& task)
+{
+    WorkQueue& q = *queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+
+    if (newest) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+    }
+    else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+    }
+    return true;
+}
+
+bool JobSystem::tryRunOne(size_t home)
+{
+    Task task;
+    bool found = pop(home, true, task);
+
+    // Steal the oldest job, which tends to be the largest remaining piece of work
+    for (size_t i = 1; !found && i < queues.size(); ++i) {
+        found = pop((home + i) % queues.size(), false, task);
+    }
+    if (!found) return false;
+
+    queued.fetch_sub(1);
+    task.job();
+    task.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::workerLoop(size_t index)
+{
+    workerSystem = this;
+    workerIndex = index;
+
+    while (!stopping) {
+        if (tryRunOne(index)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        ++sleepers;
+        wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+        --sleepers;
+    }
+}
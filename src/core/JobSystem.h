@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+// Counts outstanding jobs; a group of jobs is finished once it drops to zero
+class JobCounter {
+public:
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> pending{ 0 };
+};
+
+// Fixed pool of worker threads with one deque per worker. Workers pop their own
+// newest job and steal the oldest job of another queue when they run dry. Threads
+// outside the pool submit to a shared queue and help run jobs while they wait,
+// so nested waits inside jobs cannot deadlock the pool.
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+
+    // Sized from ADSK_JOB_THREADS when set, otherwise from the hardware
+    static JobSystem& getInstance();
+
+    explicit JobSystem(unsigned threadCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Threads that execute jobs, including the one that waits
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    void submit(Job job, JobCounter& counter);
+    void wait(JobCounter& counter);
+
+    // Splits [0, count) into chunks of at least minChunk and calls fn(begin, end)
+    // for each of them across the pool. Returns once every chunk has run.
+    template<typename Fn>
+    void parallelFor(size_t count, size_t minChunk, Fn&& fn) {
+        if (count == 0) return;
+
+        // A few chunks per thread so stealing can even out uneven work
+        const size_t threads = getThreadCount();
+        const size_t chunk = std::max<size_t>(std::max<size_t>(minChunk, 1), (count + threads * 4 - 1) / (threads * 4));
+        if (threads == 1 || chunk >= count) {
+            fn(size_t(0), count);
+            return;
+        }
+
+        JobCounter counter;
+        for (size_t begin = chunk; begin < count; begin += chunk) {
+            const size_t end = std::min(count, begin + chunk);
+            submit([&fn, begin, end]() { fn(begin, end); }, counter);
+        }
+        fn(size_t(0), chunk);
+        wait(counter);
+    }
+
+private:
+    struct Task {
+        Job job;
+        JobCounter* counter;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool tryRunOne(size_t home);
+    bool pop(size_t queue, bool newest, Task& task);
+    size_t currentQueue() const;
+
+    // One queue per worker, then one shared by every outside thread
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<int> queued{ 0 };
+    std::atomic<int> sleepers{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+};
@@ -0,0 +1,310 @@
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+
+void OcclusionCuller::begin(const Mat4& viewProj)
+{
+    viewProjection = viewProj;
+    occluders.clear();
+    ready = false;
+    stats = OcclusionStats();
+}
+
+void OcclusionCuller::addOccluder(const Vertex* vertices, const uint32_t* indices, uint32_t triangleCount, const Mat4& world)
+{
+    if (!vertices || !indices || triangleCount == 0) return;
+    occluders.push_back({ vertices, indices, triangleCount, world });
+}
+
+void OcclusionCuller::rasterize(JobSystem& jobs)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    if (levelOffsets.empty()) {
+        size_t size = 0;
+        for (int w = Width, h = Height; w >= 1 && h >= 1; w /= 2, h /= 2) {
+            levelOffsets.push_back(size);
+            size += static_cast<size_t>(w) * h;
+        }
+        pyramid.resize(size);
+    }
+    std::fill(pyramid.begin(), pyramid.begin() + Width * Height, 1.0f);
+
+    triangles.resize(std::max(triangles.size(), occluders.size()));
+    jobs.parallelFor(occluders.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) transformOccluder(i);
+    });
+
+    // Each triangle goes to every tile its bounds overlap
+    for (auto& bin : bins) bin.clear();
+    for (size_t i = 0; i < occluders.size(); ++i) {
+        for (const RasterTriangle& triangle : triangles[i]) {
+            for (int ty = triangle.minY / TileHeight; ty <= triangle.maxY / TileHeight; ++ty) {
+                for (int tx = triangle.minX / TileWidth; tx <= triangle.maxX / TileWidth; ++tx) {
+                    bins[ty * TilesX + tx].push_back(&triangle);
+                }
+            }
+        }
+        stats.occluderTriangles += static_cast<uint32_t>(triangles[i].size());
+    }
+    stats.occluders = static_cast<uint32_t>(occluders.size());
+
+    jobs.parallelFor(TilesX * TilesY, 1, [this](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; ++tile) rasterizeTile(static_cast<int>(tile));
+    });
+
+    buildPyramid();
+    ready = true;
+
+    stats.rasterMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Clip space through world * view * projection, one Float4 row per input axis
+void OcclusionCuller::transformOccluder(size_t index)
+{
+    const Occluder& occluder = occluders[index];
+    std::vector<RasterTriangle>& out = triangles[index];
+    out.clear();
+
+    const Mat4 m = occluder.world * viewProjection;
+    const Float4 row0 = simdLoad(m.m[0]), row1 = simdLoad(m.m[1]), row2 = simdLoad(m.m[2]), row3 = simdLoad(m.m[3]);
+
+    for (uint32_t t = 0; t < occluder.triangleCount; ++t) {
+        float clip[3][4];
+        for (int k = 0; k < 3; ++k) {
+            const Vertex& v = occluder.vertices[occluder.indices[t * 3 + k]];
+            simdStore(clip[k], simdMadd(simdSplat(v.x), row0, simdMadd(simdSplat(v.y), row1, simdMadd(simdSplat(v.z), row2, row3))));
+        }
+
+        // Wholly outside one side of the frustum, near plane aside
+        bool outside = false;
+        for (int axis = 0; axis < 2 && !outside; ++axis) {
+            outside = (clip[0][axis] > clip[0][3] && clip[1][axis] > clip[1][3] && clip[2][axis] > clip[2][3])
+                || (clip[0][axis] < -clip[0][3] && clip[1][axis] < -clip[1][3] && clip[2][axis] < -clip[2][3]);
+        }
+        if (outside) continue;
+
+        const int behind = (clip[0][2] < 0.0f) + (clip[1][2] < 0.0f) + (clip[2][2] < 0.0f);
+        if (behind == 3) continue;
+        if (behind == 0) {
+            emitTriangle(clip, out);
+            continue;
+        }
+
+        // Cut at z = 0 into a triangle or a quad
+        float polygon[4][4];
+        int count = 0;
+        for (int k = 0; k < 3; ++k) {
+            const float* a = clip[k];
+            const float* b = clip[(k + 1) % 3];
+            if (a[2] >= 0.0f) std::copy(a, a + 4, polygon[count++]);
+            if ((a[2] >= 0.0f) != (b[2] >= 0.0f)) {
+                const float s = a[2] / (a[2] - b[2]);
+                for (int c = 0; c < 4; ++c) polygon[count][c] = a[c] + (b[c] - a[c]) * s;
+                ++count;
+            }
+        }
+        for (int k = 1; k + 1 < count; ++k) {
+            const float fan[3][4] = {
+                { polygon[0][0], polygon[0][1], polygon[0][2], polygon[0][3] },
+                { polygon[k][0], polygon[k][1], polygon[k][2], polygon[k][3] },
+                { polygon[k + 1][0], polygon[k + 1][1], polygon[k + 1][2], polygon[k + 1][3] },
+            };
+            emitTriangle(fan, out);
+        }
+    }
+}
+
+void OcclusionCuller::emitTriangle(const float (*clip)[4], std::vector<RasterTriangle>& out) const
+{
+    float x[3], y[3], z[3];
+    for (int k = 0; k < 3; ++k) {
+        const float invW = 1.0f / clip[k][3];
+        x[k] = (clip[k][0] * invW * 0.5f + 0.5f) * Width;
+        y[k] = (0.5f - clip[k][1] * invW * 0.5f) * Height;
+        z[k] = clip[k][2] * invW;
+    }
+
+    // Both windings are drawn; flip the back-facing ones so edges agree
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (std::abs(area) < 1e-8f) return;
+    if (area < 0.0f) {
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    // Pixels whose centers can be inside, clamped before converting to int
+    const float minX = std::clamp(std::min({ x[0], x[1], x[2] }), 0.0f, Width - 1.0f);
+    const float maxX = std::clamp(std::max({ x[0], x[1], x[2] }), 0.0f, Width - 1.0f);
+    const float minY = std::clamp(std::min({ y[0], y[1], y[2] }), 0.0f, Height - 1.0f);
+    const float maxY = std::clamp(std::max({ y[0], y[1], y[2] }), 0.0f, Height - 1.0f);
+    if (std::max({ x[0], x[1], x[2] }) < 0.0f || std::min({ x[0], x[1], x[2] }) > Width
+        || std::max({ y[0], y[1], y[2] }) < 0.0f || std::min({ y[0], y[1], y[2] }) > Height) return;
+
+    RasterTriangle triangle;
+    for (int k = 0; k < 3; ++k) {
+        const int j = (k + 1) % 3;
+        triangle.a[k] = -(y[j] - y[k]);
+        triangle.b[k] = x[j] - x[k];
+        triangle.c[k] = -(triangle.a[k] * x[k] + triangle.b[k] * y[k]);
+    }
+
+    const float invArea = 1.0f / area;
+    triangle.za = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) * invArea;
+    triangle.zb = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) * invArea;
+    triangle.zc = z[0] - triangle.za * x[0] - triangle.zb * y[0];
+
+    triangle.minX = static_cast<int>(minX);
+    triangle.maxX = static_cast<int>(maxX);
+    triangle.minY = static_cast<int>(minY);
+    triangle.maxY = static_cast<int>(maxY);
+    out.push_back(triangle);
+}
+
+// Keeps the nearest depth per pixel, tested at pixel centers
+void OcclusionCuller::rasterizeTile(int tile)
+{
+    const int tileX0 = (tile % TilesX) * TileWidth;
+    const int tileY0 = (tile / TilesX) * TileHeight;
+    const int tileX1 = tileX0 + TileWidth - 1;
+    const int tileY1 = tileY0 + TileHeight - 1;
+
+    const Float4 zero = simdSplat(0.0f);
+    const Float4 farDepth = simdSplat(1.0f);
+    const Float4 laneOffsets = simdSet(0.5f, 1.5f, 2.5f, 3.5f);
+    float* depth = pyramid.data();
+
+    for (const RasterTriangle* triangle : bins[tile]) {
+        const int x0 = std::max(triangle->minX, tileX0) & ~3;
+        const int x1 = std::min(triangle->maxX, tileX1);
+        const int y0 = std::max(triangle->minY, tileY0);
+        const int y1 = std::min(triangle->maxY, tileY1);
+
+        const Float4 a0 = simdSplat(triangle->a[0]), a1 = simdSplat(triangle->a[1]), a2 = simdSplat(triangle->a[2]);
+        const Float4 za = simdSplat(triangle->za);
+
+        for (int y = y0; y <= y1; ++y) {
+            const float py = y + 0.5f;
+            const Float4 row0 = simdSplat(triangle->b[0] * py + triangle->c[0]);
+            const Float4 row1 = simdSplat(triangle->b[1] * py + triangle->c[1]);
+            const Float4 row2 = simdSplat(triangle->b[2] * py + triangle->c[2]);
+            const Float4 rowZ = simdSplat(triangle->zb * py + triangle->zc);
+            float* line = depth + y * Width;
+
+            for (int x = x0; x <= x1; x += 4) {
+                const Float4 px = simdAdd(simdSplat(static_cast<float>(x)), laneOffsets);
+                const Float4 e0 = simdMadd(a0, px, row0);
+                const Float4 e1 = simdMadd(a1, px, row1);
+                const Float4 e2 = simdMadd(a2, px, row2);
+                const Float4 inside = simdMin(e0, simdMin(e1, e2));
+                if (simdLessMask(inside, zero) == 0xF) continue;
+
+                const Float4 z = simdSelectLess(inside, zero, farDepth, simdMadd(za, px, rowZ));
+                simdStore(line + x, simdMin(simdLoad(line + x), z));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::buildPyramid()
+{
+    int width = Width;
+    int height = Height;
+    for (size_t level = 1; level < levelOffsets.size(); ++level) {
+        const float* src = pyramid.data() + levelOffsets[level - 1];
+        float* dst = pyramid.data() + levelOffsets[level];
+        const int srcWidth = width;
+        width /= 2;
+        height /= 2;
+
+        for (int y = 0; y < height; ++y) {
+            const float* top = src + (y * 2) * srcWidth;
+            const float* bottom = top + srcWidth;
+            for (int x = 0; x < width; ++x) {
+                dst[y * width + x] = std::max(std::max(top[x * 2], top[x * 2 + 1]), std::max(bottom[x * 2], bottom[x * 2 + 1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isOccluded(const Aabb& box) const
+{
+    if (!ready) return false;
+
+    // Corners four at a time, once for each z face
+    const float* m = viewProjection.data();
+    const Float4 xs = simdSet(box.min[0], box.max[0], box.min[0], box.max[0]);
+    const Float4 ys = simdSet(box.min[1], box.min[1], box.max[1], box.max[1]);
+
+    float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+    for (const float zValue : { box.min[2], box.max[2] }) {
+        const Float4 zs = simdSplat(zValue);
+        float clip[4][4];
+        for (int c = 0; c < 4; ++c) {
+            simdStore(clip[c], simdMadd(xs, simdSplat(m[c]), simdMadd(ys, simdSplat(m[4 + c]),
+                simdMadd(zs, simdSplat(m[8 + c]), simdSplat(m[12 + c])))));
+        }
+        for (int corner = 0; corner < 4; ++corner) {
+            if (clip[2][corner] < 0.0f) return false;
+            const float invW = 1.0f / clip[3][corner];
+            minX = std::min(minX, clip[0][corner] * invW);
+            maxX = std::max(maxX, clip[0][corner] * invW);
+            minY = std::min(minY, clip[1][corner] * invW);
+            maxY = std::max(maxY, clip[1][corner] * invW);
+            minZ = std::min(minZ, clip[2][corner] * invW);
+        }
+    }
+
+    const float left = (minX * 0.5f + 0.5f) * Width;
+    const float right = (maxX * 0.5f + 0.5f) * Width;
+    const float top = (0.5f - maxY * 0.5f) * Height;
+    const float bottom = (0.5f - minY * 0.5f) * Height;
+    if (right < 0.0f || left > Width || bottom < 0.0f || top > Height) return false;
+
+    int x0 = static_cast<int>(std::clamp(left, 0.0f, Width - 1.0f));
+    int x1 = static_cast<int>(std::clamp(right, 0.0f, Width - 1.0f));
+    int y0 = static_cast<int>(std::clamp(top, 0.0f, Height - 1.0f));
+    int y1 = static_cast<int>(std::clamp(bottom, 0.0f, Height - 1.0f));
+
+    int level = 0;
+    while (level + 1 < getLevelCount() && (x1 - x0 > 1 || y1 - y0 > 1)) {
+        x0 >>= 1; x1 >>= 1; y0 >>= 1; y1 >>= 1;
+        ++level;
+    }
+
+    const float* depth = getDepth(level);
+    const int levelWidth = Width >> level;
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (depth[y * levelWidth + x] >= minZ) return false;
+        }
+    }
+    return true;
+}
+
+void OcclusionCuller::cull(std::vector<uint32_t>& values, const std::vector<Aabb>& boxes, JobSystem& jobs)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    keep.resize(values.size());
+    jobs.parallelFor(values.size(), 256, [this, &boxes](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) keep[i] = !isOccluded(boxes[i]);
+    });
+
+    size_t written = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[written] = values[i];
+        written += keep[i];
+    }
+    stats.tested += static_cast<uint32_t>(values.size());
+    stats.occluded += static_cast<uint32_t>(values.size() - written);
+    values.resize(written);
+
+    stats.testMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
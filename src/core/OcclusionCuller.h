@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Bounds.h"
+#include "Mat4.h"
+#include "VertexLayout.h"
+#include <vector>
+#include <cstdint>
+
+class JobSystem;
+
+struct OcclusionStats {
+    uint32_t occluders = 0;
+    uint32_t occluderTriangles = 0;     // drawn, after near-plane clipping and rejection
+    uint32_t tested = 0;
+    uint32_t occluded = 0;
+    double rasterMilliseconds = 0.0;    // transform, binning, rasterization and the pyramid
+    double testMilliseconds = 0.0;
+};
+
+// Software occlusion culling. Designated occluders are rasterized into a small
+// depth buffer on the CPU each frame, which is then reduced to a hierarchical-Z
+// pyramid holding the farthest depth of each block. A box is occluded when its
+// nearest point lies behind every texel its screen rectangle touches, read on
+// the pyramid level where that rectangle spans at most two by two texels.
+//
+// Depth is clip z / w, 0 at the near plane and 1 at the far one. Occluders are
+// clipped against the near plane and drawn from both sides, so single-sided
+// walls work too. Occluders are transformed in parallel, then screen tiles are
+// rasterized in parallel, four pixels at a time.
+class OcclusionCuller {
+public:
+    static constexpr int Width = 256;
+    static constexpr int Height = 128;
+
+    // Clears the depth buffer and the occluder list for a new frame
+    void begin(const Mat4& viewProjection);
+
+    // The geometry is only read by rasterize(), so it has to live until then
+    void addOccluder(const Vertex* vertices, const uint32_t* indices, uint32_t triangleCount, const Mat4& world);
+    void rasterize(JobSystem& jobs);
+
+    bool hasOccluders() const { return !occluders.empty(); }
+
+    // False for boxes that touch the near plane or leave the screen entirely;
+    // those are left to the frustum test
+    bool isOccluded(const Aabb& box) const;
+
+    // Removes the values whose box is occluded, keeping the others in order
+    void cull(std::vector<uint32_t>& values, const std::vector<Aabb>& boxes, JobSystem& jobs);
+
+    int getLevelCount() const { return static_cast<int>(levelOffsets.size()); }
+    const float* getDepth(int level) const { return pyramid.data() + levelOffsets[level]; }
+
+    const OcclusionStats& getStats() const { return stats; }
+
+private:
+    static constexpr int TileWidth = 64;    // a multiple of four, so blocks never straddle tiles
+    static constexpr int TileHeight = 32;
+    static constexpr int TilesX = Width / TileWidth;
+    static constexpr int TilesY = Height / TileHeight;
+
+    struct Occluder {
+        const Vertex* vertices;
+        const uint32_t* indices;
+        uint32_t triangleCount;
+        Mat4 world;
+    };
+
+    // Edge functions e(x, y) = a * x + b * y + c, non-negative inside, and the
+    // depth plane z = za * x + zb * y + zc; bounds are inclusive pixels
+    struct RasterTriangle {
+        float a[3], b[3], c[3];
+        float za, zb, zc;
+        int minX, minY, maxX, maxY;
+    };
+
+    void transformOccluder(size_t index);
+    void emitTriangle(const float (*clip)[4], std::vector<RasterTriangle>& out) const;
+    void rasterizeTile(int tile);
+    void buildPyramid();
+
+    Mat4 viewProjection;
+    std::vector<Occluder> occluders;
+    std::vector<std::vector<RasterTriangle>> triangles;     // per occluder
+    std::vector<const RasterTriangle*> bins[TilesX * TilesY];
+
+    // Level 0 is the depth buffer; level k is half the size of level k - 1
+    std::vector<float> pyramid;
+    std::vector<size_t> levelOffsets;
+    bool ready = false;
+
+    std::vector<uint8_t> keep;
+    OcclusionStats stats;
+};
@@ -14,45 +14,47 @@ void PhysicsSystem::initialize(Scene* scene) {
     this->scene = scene;
 }
 
-void PhysicsSystem::simulate(float deltaTime) {
-    if (!simulationEnabled || !scene) return;
+ComponentMask PhysicsSystem::getReadMask() const {
+    return componentMask<Transform>() | componentMask<ColliderComponent>() | componentMask<RigidBodyComponent>();
+}
 
-    std::lock_guard<std::mutex> lock(objectsMutex);
+ComponentMask PhysicsSystem::getWriteMask() const {
+    return componentMask<Transform>() | componentMask<RigidBodyComponent>();
+}
 
-    for (auto& objPtr : scene->getObjects()) {
-        auto* rb = objPtr->getComponent<RigidBodyComponent>();
-        if (rb) {
-            rb->update(deltaTime);
-        }
-    }
+void PhysicsSystem::update(float deltaTime, JobSystem& jobs) {
+    if (!simulationEnabled || !scene) return;
 
-    for (size_t i = 0; i < scene->getObjects().size(); ++i) {
-        auto& obj1 = scene->getObjects()[i];
-        auto* transform1 = obj1->getComponent<Transform>();
-        auto* collider1 = obj1->getComponent<ColliderComponent>();
-        auto* rb1 = obj1->getComponent<RigidBodyComponent>();
+    // Bodies integrate independently, so they are split across the pool
+    scene->view<RigidBodyComponent>().parallelEach(jobs, [deltaTime](SceneObject&, RigidBodyComponent& rb) {
+        rb.update(deltaTime);
+    }, 128);
 
-        if (!transform1 || !collider1) continue;
+    // Gather every collider into one dense array before the pair loop. Positions come
+    // from the hierarchy's world matrices, so parented colliders collide where they are drawn.
+    // Each collider keeps its last position until the transform version moves on.
+    colliders.clear();
+    scene->view<Transform, ColliderComponent>().each([this](SceneObject& obj, Transform& transform, ColliderComponent& collider) {
+        colliders.push_back({ collider.getWorldPosition(transform), &collider, obj.getComponent<RigidBodyComponent>() });
+    });
 
-        for (size_t j = i + 1; j < scene->getObjects().size(); ++j) {
-            auto& obj2 = scene->getObjects()[j];
-            auto* transform2 = obj2->getComponent<Transform>();
-            auto* collider2 = obj2->getComponent<ColliderComponent>();
-            auto* rb2 = obj2->getComponent<RigidBodyComponent>();
+    for (size_t i = 0; i < colliders.size(); ++i) {
+        const ColliderEntry& a = colliders[i];
 
-            if (!transform2 || !collider2) continue;
+        for (size_t j = i + 1; j < colliders.size(); ++j) {
+            const ColliderEntry& b = colliders[j];
 
-            if (collider1->checkCollision(transform1->getPosition(), collider2, transform2->getPosition())) {
-                if (rb1) {
-                    D3DXVECTOR3 velocity = rb1->getVelocity();
+            if (a.collider->checkCollision(a.position, b.collider, b.position)) {
+                if (a.rigidBody) {
+                    Vec3 velocity = a.rigidBody->getVelocity();
                     velocity.y = std::abs(velocity.y) * 0.8f;
-                    rb1->setVelocity(velocity);
+                    a.rigidBody->setVelocity(velocity);
                 }
 
-                if (rb2) {
-                    D3DXVECTOR3 velocity = rb2->getVelocity();
+                if (b.rigidBody) {
+                    Vec3 velocity = b.rigidBody->getVelocity();
                     velocity.y = std::abs(velocity.y) * 0.8f;
-                    rb2->setVelocity(velocity);
+                    b.rigidBody->setVelocity(velocity);
                 }
             }
         }
@@ -63,27 +65,26 @@ void PhysicsSystem::saveState() {
     savedStates.clear();
     if (!scene) return;
 
-    for (auto& objPtr : scene->getObjects()) {
-        auto* transform = objPtr->getComponent<Transform>();
-        auto* rb = objPtr->getComponent<RigidBodyComponent>();
-
-        if (transform) {
-            ObjectState state;
-            state.position = transform->getPosition();
-            state.rotation = transform->getRotation();
-
-            if (rb) {
-                state.velocity = rb->getVelocity();
-            }
+    scene->view<Transform>().each([this](SceneObject& obj, Transform& transform) {
+        ObjectState& state = savedStates[obj.getHandle()];
+        state.position = transform.getPosition();
+        state.eulerAngles = transform.getEulerAngles();
+        state.velocity = Vec3(0, 0, 0);
+    });
 
-            savedStates[objPtr.get()] = state;
-        }
-    }
+    scene->view<RigidBodyComponent>().each([this](SceneObject& obj, RigidBodyComponent& rb) {
+        savedStates[obj.getHandle()].velocity = rb.getVelocity();
+    });
 }
 
 void PhysicsSystem::restoreState() {
+    if (!scene) return;
+
     for (auto& pair : savedStates) {
-        SceneObject* obj = pair.first;
+        // Objects deleted while the simulation ran leave stale handles behind
+        SceneObject* obj = scene->getObject(pair.first);
+        if (!obj) continue;
+
         const ObjectState& state = pair.second;
 
         auto* transform = obj->getComponent<Transform>();
@@ -91,7 +92,7 @@ void PhysicsSystem::restoreState() {
 
         if (transform) {
             transform->setPosition(state.position);
-            transform->setRotation(state.rotation);
+            transform->setEulerAngles(state.eulerAngles);
 
             if (rb) {
                 rb->setVelocity(state.velocity);
@@ -1,19 +1,28 @@
 #pragma once
 
 #include <vector>
-#include <mutex>
 #include <unordered_map>
-#include <d3dx9.h>
+#include "Vec.h"
+#include "SlotMap.h"
+#include "SystemScheduler.h"
 
 class Scene;
 class SceneObject;
+class Transform;
+class ColliderComponent;
+class RigidBodyComponent;
 
-class PhysicsSystem {
+class PhysicsSystem : public System {
 public:
     static PhysicsSystem& getInstance();
 
     void initialize(Scene* scene);
-    void simulate(float deltaTime);
+
+    const char* getName() const override { return "Physics"; }
+    ComponentMask getReadMask() const override;
+    ComponentMask getWriteMask() const override;
+    void update(float deltaTime, JobSystem& jobs) override;
+
     void setSimulationEnabled(bool enabled) { simulationEnabled = enabled; }
     bool isSimulationEnabled() const { return simulationEnabled; }
 
@@ -24,13 +33,19 @@ private:
     PhysicsSystem() = default;
 
     struct ObjectState {
-        D3DXVECTOR3 position;
-        D3DXVECTOR3 rotation;
-        D3DXVECTOR3 velocity;
+        Vec3 position;
+        Vec3 eulerAngles;      // editor view, so restoring does not rewrite what was typed
+        Vec3 velocity;
+    };
+
+    struct ColliderEntry {
+        Vec3 position;
+        ColliderComponent* collider;
+        RigidBodyComponent* rigidBody;
     };
 
     bool simulationEnabled = false;
     Scene* scene = nullptr;
-    std::mutex objectsMutex;
-    std::unordered_map<SceneObject*, ObjectState> savedStates;
+    std::unordered_map<EntityHandle, ObjectState> savedStates;
+    std::vector<ColliderEntry> colliders;
 };
\ No newline at end of file
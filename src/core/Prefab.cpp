@@ -0,0 +1,118 @@
+#include "Prefab.h"
+#include "Scene.h"
+#include "SceneObject.h"
+
+#include <QJsonArray>
+#include <QSet>
+
+std::shared_ptr<const Prefab> Prefab::create(const QString& name, const QJsonObject& prototype)
+{
+    std::shared_ptr<Prefab> prefab(new Prefab());
+    prefab->name = name;
+    prefab->prototype = prototype;
+
+    for (const auto& value : prototype["components"].toArray()) {
+        const QJsonObject component = value.toObject();
+        prefab->componentsByType[component["type"].toString()] = component["data"];
+    }
+    return prefab;
+}
+
+std::unique_ptr<SceneObject> Prefab::instantiate(const QJsonObject& overrides) const
+{
+    auto object = Scene::instantiate(overrides.isEmpty() ? prototype : apply(overrides));
+    object->setPrefab(shared_from_this());
+    return object;
+}
+
+QJsonObject Prefab::diff(const QJsonObject& instance) const
+{
+    QJsonObject overrides;
+    if (instance["name"] != prototype["name"]) {
+        overrides["name"] = instance["name"];
+    }
+
+    QJsonObject changed;
+    QSet<QString> present;
+    for (const auto& value : instance["components"].toArray()) {
+        const QJsonObject component = value.toObject();
+        const QString type = component["type"].toString();
+        const QJsonObject data = component["data"].toObject();
+        present.insert(type);
+
+        if (!componentsByType.contains(type)) {
+            changed[type] = data;
+            continue;
+        }
+
+        const QJsonObject base = componentsByType[type].toObject();
+        QJsonObject delta;
+        for (auto it = data.begin(); it != data.end(); ++it) {
+            if (base[it.key()] != it.value()) delta[it.key()] = it.value();
+        }
+        if (!delta.isEmpty()) changed[type] = delta;
+    }
+    if (!changed.isEmpty()) overrides["components"] = changed;
+
+    QJsonArray removed;
+    for (auto it = componentsByType.begin(); it != componentsByType.end(); ++it) {
+        if (!present.contains(it.key())) removed.append(it.key());
+    }
+    if (!removed.isEmpty()) overrides["removed"] = removed;
+
+    return overrides;
+}
+
+QJsonObject Prefab::apply(const QJsonObject& overrides) const
+{
+    const QJsonObject changed = overrides["components"].toObject();
+    QSet<QString> removed;
+    for (const auto& value : overrides["removed"].toArray()) {
+        removed.insert(value.toString());
+    }
+
+    // Prototype components keep their order; added ones go after them
+    QJsonArray components;
+    for (const auto& value : prototype["components"].toArray()) {
+        QJsonObject component = value.toObject();
+        const QString type = component["type"].toString();
+        if (removed.contains(type)) continue;
+
+        if (changed.contains(type)) {
+            QJsonObject data = component["data"].toObject();
+            const QJsonObject delta = changed[type].toObject();
+            for (auto it = delta.begin(); it != delta.end(); ++it) {
+                data[it.key()] = it.value();
+            }
+            component["data"] = data;
+        }
+        components.append(component);
+    }
+
+    for (auto it = changed.begin(); it != changed.end(); ++it) {
+        if (componentsByType.contains(it.key())) continue;
+
+        QJsonObject component;
+        component["type"] = it.key();
+        component["data"] = it.value();
+        components.append(component);
+    }
+
+    QJsonObject result;
+    result["name"] = overrides.contains("name") ? overrides["name"] : prototype["name"];
+    result["components"] = components;
+    return result;
+}
+
+QJsonObject Prefab::toJson() const
+{
+    QJsonObject data;
+    data["name"] = name;
+    data["prototype"] = prototype;
+    return data;
+}
+
+std::shared_ptr<const Prefab> Prefab::fromJson(const QJsonObject& data)
+{
+    return create(data["name"].toString(), data["prototype"].toObject());
+}
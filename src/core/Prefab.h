@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <memory>
+
+class SceneObject;
+
+// Shared, immutable template for objects that are placed many times. Instances
+// point at it instead of owning a copy, and scene files store the prototype once
+// plus, per instance, only the fields that differ from it.
+class Prefab : public std::enable_shared_from_this<Prefab> {
+public:
+    // prototype uses the SceneObject::serialize() layout
+    static std::shared_ptr<const Prefab> create(const QString& name, const QJsonObject& prototype);
+
+    const QString& getName() const { return name; }
+    const QJsonObject& getPrototype() const { return prototype; }
+
+    // Detached object linked to this prefab, built from the prototype with overrides applied
+    std::unique_ptr<SceneObject> instantiate(const QJsonObject& overrides = QJsonObject()) const;
+
+    // Overrides hold the name if it changed, the changed fields of each component
+    // under "components" (all fields for components the prototype lacks), and the
+    // types of prototype components the instance removed under "removed".
+    QJsonObject diff(const QJsonObject& instance) const;
+    QJsonObject apply(const QJsonObject& overrides) const;
+
+    QJsonObject toJson() const;
+    static std::shared_ptr<const Prefab> fromJson(const QJsonObject& data);
+
+private:
+    Prefab() = default;
+
+    QString name;
+    QJsonObject prototype;
+    QJsonObject componentsByType;   // type name to component data
+};
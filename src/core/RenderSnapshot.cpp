@@ -0,0 +1,34 @@
+#include "RenderSnapshot.h"
+#include "TransformHierarchy.h"
+#include "Transform.h"
+#include "SceneObject.h"
+#include <algorithm>
+
+const Mat4* RenderSnapshot::findWorld(EntityHandle handle) const
+{
+    if (handle.index() >= nodeOfSlot.size()) return nullptr;
+
+    const uint32_t node = nodeOfSlot[handle.index()];
+    if (node == NoNode || handles[node] != handle) return nullptr;
+    return &worlds[node];
+}
+
+void RenderSnapshot::capture(const TransformHierarchy& hierarchy, uint64_t step)
+{
+    this->step = step;
+
+    // The world array is contiguous, so the bulk of the copy is one memcpy
+    const std::vector<Transform*>& nodes = hierarchy.getNodes();
+    worlds = hierarchy.getWorlds();
+    handles.resize(nodes.size());
+    std::fill(nodeOfSlot.begin(), nodeOfSlot.end(), NoNode);
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const EntityHandle handle = nodes[i] ? nodes[i]->getOwner()->getHandle() : EntityHandle();
+        handles[i] = handle;
+        if (!handle) continue;
+
+        if (handle.index() >= nodeOfSlot.size()) nodeOfSlot.resize(handle.index() + 1, NoNode);
+        nodeOfSlot[handle.index()] = static_cast<uint32_t>(i);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SlotMap.h"
+#include <vector>
+#include <cstdint>
+#include "Mat4.h"
+
+class TransformHierarchy;
+
+// Copy of every world matrix at the end of one simulation step. The scene keeps
+// two: a step writes the back one while the renderer reads the front one, and
+// they swap when the step is joined, so the renderer never sees a half-written
+// frame and never needs a lock.
+class RenderSnapshot {
+public:
+    // World matrix of the object when the snapshot was taken; nullptr if it
+    // did not exist yet
+    const Mat4* findWorld(EntityHandle handle) const;
+
+    size_t size() const { return handles.size(); }
+    uint64_t getStep() const { return step; }
+
+    void capture(const TransformHierarchy& hierarchy, uint64_t step);
+
+private:
+    static constexpr uint32_t NoNode = UINT32_MAX;
+
+    std::vector<EntityHandle> handles;
+    std::vector<Mat4> worlds;
+    std::vector<uint32_t> nodeOfSlot;   // handle index to position in the arrays above
+    uint64_t step = 0;
+};
@@ -1,12 +1,19 @@
 #include "ResourceManager.h"
 #include "ConsolePanel.h"
+#include "MeshOptimizer.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <stdexcept>
 #include <algorithm>
 #include <cfloat>
-#include <d3dx9.h>
 
 std::unordered_map<QString, std::weak_ptr<Mesh>> ResourceManager::meshCache;
 
@@ -18,6 +25,15 @@ std::shared_ptr<Mesh> ResourceManager::loadMesh(const QString& path) {
         }
     }
 
+    auto newMesh = std::make_shared<Mesh>();
+    bool hasTexCoords = false;
+    if (readOptimizedMesh(path, *newMesh, hasTexCoords)) {
+        newMesh->buildClusters();
+        newMesh->layout = chooseLayout(*newMesh, hasTexCoords);
+        meshCache[path] = newMesh;
+        return newMesh;
+    }
+
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(path.toStdString(),
         aiProcess_Triangulate |
@@ -35,7 +51,6 @@ std::shared_ptr<Mesh> ResourceManager::loadMesh(const QString& path) {
         throw std::runtime_error("No meshes found in the file");
     }
 
-    auto newMesh = std::make_shared<Mesh>();
     aiVector3D sceneMin(FLT_MAX, FLT_MAX, FLT_MAX);
     aiVector3D sceneMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 
@@ -88,6 +103,7 @@ std::shared_ptr<Mesh> ResourceManager::loadMesh(const QString& path) {
             }
 
             if (aiMesh->HasTextureCoords(0)) {
+                hasTexCoords = true;
                 v.u = aiMesh->mTextureCoords[0][i].x;
                 v.v = aiMesh->mTextureCoords[0][i].y;
             }
@@ -96,7 +112,7 @@ std::shared_ptr<Mesh> ResourceManager::loadMesh(const QString& path) {
                 v.v = 0;
             }
 
-            v.color = D3DCOLOR_XRGB(255, 255, 255);
+            v.color = 0xFFFFFFFF;
             newMesh->vertices.push_back(v);
         }
 
@@ -110,22 +126,207 @@ std::shared_ptr<Mesh> ResourceManager::loadMesh(const QString& path) {
         }
     }
 
-    newMesh->minBounds = D3DXVECTOR3(
+    newMesh->minBounds = Vec3(
         (sceneMin.x - centerX) * targetScale,
         -(sceneMax.y - centerY) * targetScale,
         (sceneMin.z - centerZ) * targetScale
     );
 
-    newMesh->maxBounds = D3DXVECTOR3(
+    newMesh->maxBounds = Vec3(
         (sceneMax.x - centerX) * targetScale,
         -(sceneMin.y - centerY) * targetScale,
         (sceneMax.z - centerZ) * targetScale
     );
 
+    const VertexCacheStats before = analyzeVertexCache(newMesh->indices, newMesh->vertices.size());
+    newMesh->optimize();
+    const VertexCacheStats after = analyzeVertexCache(newMesh->indices, newMesh->vertices.size());
+    ConsolePanel::sInfo(QString("Optimized %1: ACMR %2 -> %3, ATVR %4 -> %5")
+        .arg(QFileInfo(path).fileName())
+        .arg(before.acmr, 0, 'f', 3).arg(after.acmr, 0, 'f', 3)
+        .arg(before.atvr, 0, 'f', 3).arg(after.atvr, 0, 'f', 3));
+
+    newMesh->buildClusters();
+    newMesh->buildLods();
+    newMesh->layout = chooseLayout(*newMesh, hasTexCoords);
+    writeOptimizedMesh(path, *newMesh, hasTexCoords);
+
     meshCache[path] = newMesh;
     return newMesh;
 }
 
+// Positions take 16 bits per axis across the bounds unless that would merge two
+// corners of a triangle; normals are octahedral; UVs are half floats while that
+// stays within 1/4096; colors are only kept when some vertex is not white.
+VertexLayout ResourceManager::chooseLayout(const Mesh& mesh, bool hasTexCoords) {
+    VertexLayout quantized;
+    quantized.set(VertexAttribute::Position, VertexElementFormat::Short4N);
+    quantized.setPositionRange(mesh.minBounds, mesh.maxBounds);
+
+    std::vector<int16_t> positions(mesh.vertices.size() * 4);
+    packVertices(mesh.vertices.data(), mesh.vertices.size(), quantized, positions.data());
+
+    bool positionsFit = true;
+    for (size_t i = 0; i + 2 < mesh.indices.size() && positionsFit; i += 3) {
+        for (int edge = 0; edge < 3; ++edge) {
+            const uint32_t a = mesh.indices[i + edge];
+            const uint32_t b = mesh.indices[i + (edge + 1) % 3];
+            const Vertex& va = mesh.vertices[a];
+            const Vertex& vb = mesh.vertices[b];
+            const bool distinct = va.x != vb.x || va.y != vb.y || va.z != vb.z;
+            if (distinct && std::equal(&positions[a * 4], &positions[a * 4 + 3], &positions[b * 4])) {
+                positionsFit = false;
+                break;
+            }
+        }
+    }
+
+    bool coloured = false;
+    float texCoordError = 0.0f;
+    for (const Vertex& v : mesh.vertices) {
+        coloured |= v.color != 0xFFFFFFFF;
+        texCoordError = std::max({ texCoordError,
+            std::abs(halfToFloat(floatToHalf(v.u)) - v.u),
+            std::abs(halfToFloat(floatToHalf(v.v)) - v.v) });
+    }
+
+    VertexLayout layout;
+    layout.set(VertexAttribute::Position, positionsFit ? VertexElementFormat::Short4N : VertexElementFormat::Float3);
+    layout.set(VertexAttribute::Normal, VertexElementFormat::Octahedral);
+    if (coloured) layout.set(VertexAttribute::Color, VertexElementFormat::Color);
+    if (hasTexCoords) {
+        layout.set(VertexAttribute::TexCoord,
+            texCoordError <= 1.0f / 4096.0f ? VertexElementFormat::Half2 : VertexElementFormat::Float2);
+    }
+    if (positionsFit) {
+        layout.positionScale = quantized.positionScale;
+        layout.positionBias = quantized.positionBias;
+    }
+    return layout;
+}
+
+static constexpr quint32 OptimizedMeshMagic = 0x48534D41;    // "AMSH"
+static constexpr quint32 OptimizedMeshVersion = 4;    // 1 could lose triangles in optimizeOverdraw, 3 understated LOD errors
+
+// Everything besides the code that shapes the cached data; a file written with
+// other values is rebuilt
+static void writeOptimizedMeshSettings(QDataStream& out) {
+    out << static_cast<quint32>(VertexCacheSize) << OverdrawThreshold
+        << static_cast<quint32>(Mesh::MaxLods) << Mesh::MinLodTriangles << Mesh::MaxLodError;
+}
+
+static bool readOptimizedMeshSettings(QDataStream& in) {
+    quint32 cacheSize = 0, maxLods = 0, minLodTriangles = 0;
+    float threshold = 0.0f, maxLodError = 0.0f;
+    in >> cacheSize >> threshold >> maxLods >> minLodTriangles >> maxLodError;
+    return cacheSize == VertexCacheSize && threshold == OverdrawThreshold
+        && maxLods == Mesh::MaxLods && minLodTriangles == Mesh::MinLodTriangles && maxLodError == Mesh::MaxLodError;
+}
+
+// Level 0 is the whole index list and the others lie within the simplified ones
+static bool validLods(const Mesh& mesh) {
+    const std::vector<MeshLod>& lods = mesh.lods;
+    if (lods.empty() || lods.size() > Mesh::MaxLods || mesh.indices.size() % 3 != 0) return false;
+    if (lods[0].firstIndex != 0 || static_cast<uint64_t>(lods[0].triangleCount) * 3 != mesh.indices.size()) return false;
+
+    const uint64_t end = mesh.indices.size() + mesh.lodIndices.size();
+    for (size_t level = 1; level < lods.size(); ++level) {
+        const uint64_t first = lods[level].firstIndex;
+        if (lods[level].triangleCount == 0 || first < mesh.indices.size()
+            || first + static_cast<uint64_t>(lods[level].triangleCount) * 3 > end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// One file per source path under the user's cache directory
+static QString optimizedMeshPath(const QString& path) {
+    const QByteArray key = QCryptographicHash::hash(QFileInfo(path).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + "/meshes/" + QString::fromLatin1(key.toHex()) + ".mesh";
+}
+
+template<typename T>
+static bool readArray(QDataStream& in, std::vector<T>& values) {
+    quint32 count = 0;
+    in >> count;
+    if (static_cast<qint64>(count) * static_cast<qint64>(sizeof(T)) > in.device()->bytesAvailable()) return false;
+    values.resize(count);
+    const int bytes = static_cast<int>(count * sizeof(T));
+    return in.readRawData(reinterpret_cast<char*>(values.data()), bytes) == bytes;
+}
+
+template<typename T>
+static void writeArray(QDataStream& out, const std::vector<T>& values) {
+    out << static_cast<quint32>(values.size());
+    out.writeRawData(reinterpret_cast<const char*>(values.data()), static_cast<int>(values.size() * sizeof(T)));
+}
+
+bool ResourceManager::readOptimizedMesh(const QString& path, Mesh& mesh, bool& hasTexCoords) {
+    const QFileInfo source(path);
+    QFile file(optimizedMeshPath(path));
+    if (!source.exists() || !file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0, vertexSize = 0;
+    qint64 sourceSize = 0, sourceModified = 0;
+    in >> magic >> version >> vertexSize >> sourceSize >> sourceModified;
+    if (magic != OptimizedMeshMagic || version != OptimizedMeshVersion || vertexSize != sizeof(Vertex)
+        || sourceSize != source.size() || sourceModified != source.lastModified().toMSecsSinceEpoch()
+        || !readOptimizedMeshSettings(in)) {
+        return false;
+    }
+
+    float bounds[6] = {};
+    in >> hasTexCoords;
+    for (float& value : bounds) in >> value;
+
+    // A damaged file must not reach the GPU with indices or levels out of range
+    const auto inRange = [&mesh](uint32_t index) { return index < mesh.vertices.size(); };
+    const bool ok = readArray(in, mesh.vertices) && readArray(in, mesh.indices)
+        && readArray(in, mesh.lodIndices) && readArray(in, mesh.lods)
+        && in.status() == QDataStream::Ok
+        && std::all_of(mesh.indices.begin(), mesh.indices.end(), inRange)
+        && std::all_of(mesh.lodIndices.begin(), mesh.lodIndices.end(), inRange)
+        && validLods(mesh);
+    if (!ok) {
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        mesh.lodIndices.clear();
+        mesh.lods.clear();
+        return false;
+    }
+
+    mesh.minBounds = Vec3(bounds[0], bounds[1], bounds[2]);
+    mesh.maxBounds = Vec3(bounds[3], bounds[4], bounds[5]);
+    return true;
+}
+
+void ResourceManager::writeOptimizedMesh(const QString& path, const Mesh& mesh, bool hasTexCoords) {
+    const QFileInfo source(path);
+    const QString cachePath = optimizedMeshPath(path);
+    QSaveFile file(cachePath);
+    if (!QDir().mkpath(QFileInfo(cachePath).absolutePath()) || !file.open(QIODevice::WriteOnly)) {
+        ConsolePanel::sWarning(QString("Could not cache optimized mesh %1").arg(cachePath));
+        return;
+    }
+
+    QDataStream out(&file);
+    out << OptimizedMeshMagic << OptimizedMeshVersion << static_cast<quint32>(sizeof(Vertex))
+        << static_cast<qint64>(source.size()) << static_cast<qint64>(source.lastModified().toMSecsSinceEpoch());
+    writeOptimizedMeshSettings(out);
+    out << hasTexCoords;
+    for (float value : { mesh.minBounds.x, mesh.minBounds.y, mesh.minBounds.z, mesh.maxBounds.x, mesh.maxBounds.y, mesh.maxBounds.z }) {
+        out << value;
+    }
+    writeArray(out, mesh.vertices);
+    writeArray(out, mesh.indices);
+    writeArray(out, mesh.lodIndices);
+    writeArray(out, mesh.lods);
+    file.commit();
+}
+
 void ResourceManager::clearUnusedResources() {
     for (auto it = meshCache.begin(); it != meshCache.end(); ) {
         if (it->second.expired()) {
@@ -135,4 +336,16 @@ void ResourceManager::clearUnusedResources() {
             ++it;
         }
     }
+}
+
+void ResourceManager::releaseDeviceObjects() {
+    for (const auto& entry : meshCache) {
+        if (auto mesh = entry.second.lock()) mesh->releaseBuffers();
+    }
+}
+
+void ResourceManager::restoreDeviceObjects(RenderDevice& device) {
+    for (const auto& entry : meshCache) {
+        if (auto mesh = entry.second.lock()) mesh->ensureBuffers(device);
+    }
 }
\ No newline at end of file
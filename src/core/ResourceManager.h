@@ -10,6 +10,18 @@ public:
     static std::shared_ptr<Mesh> loadMesh(const QString& path);
     static void clearUnusedResources();
 
+    // GPU copies of every loaded mesh, once per mesh rather than per renderer
+    static void releaseDeviceObjects();
+    static void restoreDeviceObjects(RenderDevice& device);
+
 private:
+    // Smallest layout that keeps the loaded data intact, see loadMesh()
+    static VertexLayout chooseLayout(const Mesh& mesh, bool hasTexCoords);
+
+    // On-disk copy of an imported, optimized and simplified mesh, valid while
+    // the source file keeps its size and modification time
+    static bool readOptimizedMesh(const QString& path, Mesh& mesh, bool& hasTexCoords);
+    static void writeOptimizedMesh(const QString& path, const Mesh& mesh, bool hasTexCoords);
+
     static std::unordered_map<QString, std::weak_ptr<Mesh>> meshCache;
 };
\ No newline at end of file
@@ -1,16 +1,31 @@
 #include "Scene.h"
 #include "Light.h"
 #include "MeshRenderer.h"
+#include "RigidBodyComponent.h"
+#include "BoxColliderComponent.h"
+#include "SphereColliderComponent.h"
 #include "ConsolePanel.h"
+#include "Prefab.h"
+#include "RenderQueue.h"
+#include "ResourceManager.h"
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QDebug>
 #include <QFile>
 #include <QApplication>
+#include <unordered_map>
+#include <cassert>
 
 Scene::Scene(QObject* parent) : QObject(parent)
 {
     PhysicsSystem::getInstance().initialize(this);
+
+    // Registration order decides which of two conflicting systems runs first
+    scheduler.addSystem(&updateSystem);
+    scheduler.addSystem(&PhysicsSystem::getInstance());
+    scheduler.addSystem(&transformSystem);
+    scheduler.addSystem(&boundsSystem);
+
     ambientColor.r = 0.2f;
     ambientColor.g = 0.2f;
     ambientColor.b = 0.2f;
@@ -18,46 +33,346 @@ Scene::Scene(QObject* parent) : QObject(parent)
 }
 
 Scene::~Scene() {
+    endUpdate();
     invalidateDeviceObjects();
 }
 
-void Scene::addObject(std::unique_ptr<SceneObject> object) {
-    std::lock_guard<std::mutex> lock(sceneMutex);
-    SceneObject* raw = object.get();
-    connect(raw, &SceneObject::propertiesChanged,
-        this, &Scene::objectPropertiesChanged);
-    objects.push_back(std::move(object));
-    emit objectAdded(raw);
+void Scene::beginUpdate(float deltaTime) {
+    endUpdate();
+
+    // The back snapshot is not read until endUpdate swaps it to the front
+    RenderSnapshot& back = snapshots[1 - frontSnapshot];
+    const uint64_t step = ++stepCount;
+    updating = true;
+    JobSystem::getInstance().submit([this, &back, deltaTime, step]() {
+        scheduler.run(deltaTime);
+        back.capture(hierarchy, step);
+    }, stepCounter);
+}
+
+void Scene::endUpdate() {
+    if (!updating) return;
+
+    JobSystem::getInstance().wait(stepCounter);
+    updating = false;
+    frontSnapshot = 1 - frontSnapshot;
+}
+
+void Scene::beginBatch() {
+    ++batchDepth;
+}
+
+void Scene::addObjects(std::vector<std::unique_ptr<SceneObject>> newObjects) {
+    beginBatch();
+    pendingAdds.reserve(pendingAdds.size() + newObjects.size());
+    for (auto& object : newObjects) {
+        if (object) pendingAdds.push_back(std::move(object));
+    }
+    commit();
+}
+
+void Scene::removeObjects(const std::vector<EntityHandle>& handles) {
+    beginBatch();
+    pendingRemoves.insert(pendingRemoves.end(), handles.begin(), handles.end());
+    commit();
+}
+
+void Scene::setParent(EntityHandle child, EntityHandle parent) {
+    beginBatch();
+    pendingParents.emplace_back(child, parent);
+    commit();
+}
+
+void Scene::commit() {
+    if (batchDepth == 0 || --batchDepth > 0) return;
+    if (pendingAdds.empty() && pendingRemoves.empty() && pendingParents.empty() && !pendingClear) return;
+
+    SceneChangeSet changes;
+    std::vector<std::unique_ptr<SceneObject>> removed;
+    {
+        // Systems hold raw pointers into the tables while a step runs
+        assert(!updating);
+
+        // Take queued objects off the bus while they are all still alive
+        changeBus.collect(pendingModifications);
+
+        if (pendingClear) {
+            changes.cleared = true;
+            changes.removed.reserve(objects.size());
+            removed.reserve(objects.size());
+            while (!objects.empty()) {
+                EntityHandle handle = objects.handleAt(objects.size() - 1);
+                changes.removed.push_back(handle);
+                removed.push_back(objects.take(handle));
+                hierarchy.remove(removed.back()->getComponent<Transform>());
+            }
+        }
+        else {
+            std::vector<Transform*> roots;
+            roots.reserve(pendingRemoves.size());
+            for (EntityHandle handle : pendingRemoves) {
+                if (auto* object = getObject(handle)) {
+                    roots.push_back(object->getComponent<Transform>());
+                }
+            }
+
+            // Parents come before their children, so descendants go with them
+            std::vector<Transform*> subtree;
+            hierarchy.collectSubtrees(roots, subtree);
+
+            removed.reserve(subtree.size());
+            for (Transform* transform : subtree) {
+                EntityHandle handle = transform->getOwner()->getHandle();
+                changes.removed.push_back(handle);
+                removed.push_back(objects.take(handle));
+                hierarchy.remove(transform);
+            }
+        }
+
+        changes.added.reserve(pendingAdds.size());
+        for (auto& object : pendingAdds) {
+            SceneObject* raw = object.get();
+            storage.adopt(raw);
+            raw->changeBus = &changeBus;
+            raw->handle = objects.insert(std::move(object));
+            hierarchy.insert(raw->getComponent<Transform>());
+            changes.added.push_back(raw->handle);
+        }
+
+        for (const auto& link : pendingParents) {
+            SceneObject* child = getObject(link.first);
+            SceneObject* parent = getObject(link.second);
+            if (!child || (!parent && !link.second.isNull())) continue;
+
+            Transform* parentTransform = parent ? parent->getComponent<Transform>() : nullptr;
+            if (hierarchy.setParent(child->getComponent<Transform>(), parentTransform)) {
+                changes.reparented.push_back(link.first);
+            }
+        }
+
+        for (auto& object : removed) {
+            object->changeBus = nullptr;
+        }
+
+        pendingAdds.clear();
+        pendingRemoves.clear();
+        pendingParents.clear();
+        pendingClear = false;
+    }
+
+    emit objectsChanged(changes);
     emit objectPropertiesChanged();
+
+    // Removed objects are destroyed only after listeners dropped their references
+}
+
+EntityHandle Scene::addObject(std::unique_ptr<SceneObject> object) {
+    SceneObject* raw = object.get();
+    std::vector<std::unique_ptr<SceneObject>> single;
+    single.push_back(std::move(object));
+    addObjects(std::move(single));
+    return isBatching() ? EntityHandle() : raw->getHandle();
+}
+
+void Scene::removeObject(EntityHandle handle) {
+    removeObjects({ handle });
 }
 
 void Scene::removeObject(SceneObject* object) {
-    std::lock_guard<std::mutex> lock(sceneMutex);
-    auto it = std::find_if(objects.begin(), objects.end(),
-        [&](const std::unique_ptr<SceneObject>& ptr) {
-            return ptr.get() == object;
-        });
-    if (it != objects.end()) {
-        objects.erase(it);
-        emit objectRemoved(object);
+    if (object) removeObject(object->getHandle());
+}
+
+void Scene::clear() {
+    beginBatch();
+    pendingClear = true;
+    pendingAdds.clear();
+    pendingRemoves.clear();
+    pendingParents.clear();
+    commit();
+}
+
+std::unique_ptr<SceneObject> Scene::instantiate(const QJsonObject& data) {
+    std::string name = data["name"].toString().toStdString();
+    auto newObj = std::make_unique<SceneObject>(name);
+
+    QJsonArray components = data["components"].toArray();
+    for (const auto& compValue : components) {
+        QJsonObject compObj = compValue.toObject();
+        QString type = compObj["type"].toString();
+        QJsonObject compData = compObj["data"].toObject();
+
+        if (type == "Transform") {
+            if (auto* tr = newObj->getComponent<Transform>()) {
+                tr->deserialize(compData);
+            }
+        }
+        else if (type == "MeshRenderer") {
+            if (auto* mr = newObj->addComponent<MeshRenderer>()) {
+                mr->deserialize(compData);
+            }
+        }
+        else if (type == "Light") {
+            if (auto* light = newObj->addComponent<Light>()) {
+                light->deserialize(compData);
+            }
+        }
+        else if (type == "RigidBody") {
+            newObj->addComponent<RigidBodyComponent>()->deserialize(compData);
+        }
+        else if (type == "BoxCollider") {
+            newObj->addComponent<BoxColliderComponent>()->deserialize(compData);
+        }
+        else if (type == "SphereCollider") {
+            newObj->addComponent<SphereColliderComponent>()->deserialize(compData);
+        }
+    }
+
+    return newObj;
+}
+
+SceneObject* Scene::getObject(EntityHandle handle) const {
+    auto* slot = objects.get(handle);
+    return slot ? slot->get() : nullptr;
+}
+
+void Scene::flushChanges() {
+    assert(!updating);
+    changeBus.collect(pendingModifications);
+    if (pendingModifications.empty()) return;
+
+    // Entries for objects removed since they were queued resolve to nothing
+    std::vector<ObjectModification> delivered;
+    delivered.reserve(pendingModifications.size());
+    for (const auto& modification : pendingModifications) {
+        SceneObject* object = getObject(modification.handle);
+        if (!object) continue;
+
+        // A new mesh or an added renderer changes bounds without moving the transform
+        if (modification.changes & (ObjectChangeProperties | ObjectChangeComponents)) {
+            boundsSystem.sync(*object);
+        }
+        delivered.push_back(modification);
+    }
+    pendingModifications.clear();
+
+    if (!delivered.empty()) {
+        emit objectsModified(delivered);
         emit objectPropertiesChanged();
     }
 }
 
-void Scene::render(LPDIRECT3DDEVICE9 device) {
-    std::lock_guard<std::mutex> lock(sceneMutex);
-    for (const auto& obj : objects) {
-        obj->render(device);
+EntityHandle Scene::getParent(EntityHandle handle) const {
+    SceneObject* object = getObject(handle);
+    if (!object) return EntityHandle();
+
+    Transform* parent = object->getComponent<Transform>()->getParent();
+    return parent ? parent->getOwner()->getHandle() : EntityHandle();
+}
+
+// Objects removed by a commit keep their entry until they are destroyed, so every
+// query skips handles that no longer resolve
+std::vector<EntityHandle> Scene::queryFrustum(const Mat4& viewProjection) const {
+    const Frustum frustum = Frustum::fromViewProjection(viewProjection.data());
+
+    std::vector<EntityHandle> result;
+    spatialIndex.queryFrustum(frustum, [this, &result](uint32_t value) {
+        if (objects.contains(EntityHandle{ value })) result.push_back(EntityHandle{ value });
+    });
+    return result;
+}
+
+std::vector<EntityHandle> Scene::cullVisible(const Mat4& viewProjection, float minScreenSize) {
+    JobSystem& jobs = JobSystem::getInstance();
+    const bool occlusionCulling = occlusionCullingEnabled && rasterizeOccluders(viewProjection);
+
+    std::vector<uint32_t> values;
+    std::vector<uint32_t> boxSlots;
+    values.reserve(culler.size());
+    culler.cull(viewProjection, minScreenSize, jobs, values, occlusionCulling ? &boxSlots : nullptr);
+
+    if (occlusionCulling) {
+        std::vector<Aabb> boxes(boxSlots.size());
+        for (size_t i = 0; i < boxSlots.size(); ++i) boxes[i] = culler.getBounds(boxSlots[i]);
+        occlusion.cull(values, boxes, jobs);
+    }
+
+    std::vector<EntityHandle> result;
+    result.reserve(values.size());
+    for (uint32_t value : values) {
+        if (objects.contains(EntityHandle{ value })) result.push_back(EntityHandle{ value });
     }
+    return result;
 }
 
-const std::vector<std::unique_ptr<SceneObject>>& Scene::getObjects() const {
-    return objects;
+// Returns false when nothing is marked as an occluder, leaving occlusion culling off
+bool Scene::rasterizeOccluders(const Mat4& viewProjection) {
+    const RenderSnapshot& snapshot = getSnapshot();
+
+    occlusion.begin(viewProjection);
+    view<MeshRenderer>().each([this, &snapshot](SceneObject& object, MeshRenderer& renderer) {
+        if (!renderer.isOccluder()) return;
+        if (const Mat4* world = snapshot.findWorld(object.getHandle())) renderer.addOccluder(occlusion, *world);
+    });
+    if (!occlusion.hasOccluders()) return false;
+
+    occlusion.rasterize(JobSystem::getInstance());
+    return true;
 }
 
-void Scene::physicsUpdate(float deltaTime)
-{
-    PhysicsSystem::getInstance().simulate(deltaTime);
+std::vector<EntityHandle> Scene::queryAabb(const Aabb& box) const {
+    std::vector<EntityHandle> result;
+    spatialIndex.queryAabb(box, [this, &result](uint32_t value) {
+        if (objects.contains(EntityHandle{ value })) result.push_back(EntityHandle{ value });
+    });
+    return result;
+}
+
+std::vector<EntityHandle> Scene::querySphere(const Vec3& center, float radius) const {
+    const float c[3] = { center.x, center.y, center.z };
+
+    std::vector<EntityHandle> result;
+    spatialIndex.querySphere(c, radius, [this, &result](uint32_t value) {
+        if (objects.contains(EntityHandle{ value })) result.push_back(EntityHandle{ value });
+    });
+    return result;
+}
+
+EntityHandle Scene::raycast(const Vec3& origin, const Vec3& direction,
+    float maxDistance, float* hitDistance) const {
+    const float o[3] = { origin.x, origin.y, origin.z };
+    const float d[3] = { direction.x, direction.y, direction.z };
+
+    EntityHandle closest;
+    float closestDistance = maxDistance;
+    spatialIndex.raycast(o, d, maxDistance, [&](uint32_t value, float distance) {
+        if (!objects.contains(EntityHandle{ value })) return closestDistance;
+
+        closest = EntityHandle{ value };
+        closestDistance = distance;
+        return distance;
+    });
+
+    if (closest && hitDistance) *hitDistance = closestDistance;
+    return closest;
+}
+
+// Unculled draw of the front snapshot; safe while a step is running
+void Scene::render(RenderDevice& device, RenderQueue& queue) {
+    const RenderSnapshot& snapshot = getSnapshot();
+
+    view<Light>().each([&device, &snapshot](SceneObject& object, Light& light) {
+        if (const Mat4* world = snapshot.findWorld(object.getHandle())) light.apply(device, *world);
+    });
+
+    queue.begin(device);
+    view<MeshRenderer>().each([&device, &queue, &snapshot](SceneObject& object, MeshRenderer& renderer) {
+        if (const Mat4* world = snapshot.findWorld(object.getHandle())) renderer.enqueue(queue, device, *world);
+    });
+    queue.submit(device);
+}
+
+const std::vector<std::unique_ptr<SceneObject>>& Scene::getObjects() const {
+    return objects.values();
 }
 
 void Scene::setPhysicsEnabled(bool enabled)
@@ -69,6 +384,7 @@ void Scene::setPhysicsEnabled(bool enabled)
         PhysicsSystem::getInstance().restoreState();
     }
     PhysicsSystem::getInstance().setSimulationEnabled(enabled);
+    updateSystem.setEnabled(enabled);
 }
 
 void Scene::invalidateDeviceObjects() {
@@ -77,20 +393,22 @@ void Scene::invalidateDeviceObjects() {
         skybox.reset();
     }
 
-    for (const auto& obj : objects) {
+    for (const auto& obj : objects.values()) {
         obj->invalidateDeviceObjects();
     }
+    ResourceManager::releaseDeviceObjects();
 
     skyboxInitialized = false;
 }
 
-void Scene::restoreDeviceObjects(LPDIRECT3DDEVICE9 device) {
+void Scene::restoreDeviceObjects(RenderDevice& device) {
     // Skybox will be reloaded in updateSkybox()
     skyboxDirty = true;
 
-    for (const auto& obj : objects) {
+    for (const auto& obj : objects.values()) {
         obj->restoreDeviceObjects(device);
     }
+    ResourceManager::restoreDeviceObjects(device);
 }
 
 void Scene::saveToFile(const QString& filePath) {
@@ -106,10 +424,36 @@ void Scene::saveToFile(const QString& filePath) {
     root["lightingEnabled"] = lightingEnabled;
     root["skyboxPath"] = QString::fromStdString(skyboxPath);
 
+    // Parents are stored as indices into the objects array
+    const auto& values = objects.values();
+    std::unordered_map<EntityHandle, int> indexOf;
+    for (size_t i = 0; i < values.size(); ++i) {
+        indexOf[values[i]->getHandle()] = static_cast<int>(i);
+    }
+
+    // Prefab instances store an index into the prefabs array and their overrides
+    std::unordered_map<const Prefab*, int> prefabIndex;
+    QJsonArray prefabArray;
+
     QJsonArray objArray;
-    for (const auto& objPtr : objects) {
-        objArray.append(objPtr->serialize());
+    for (const auto& objPtr : values) {
+        QJsonObject o;
+        if (const Prefab* prefab = objPtr->getPrefab().get()) {
+            auto inserted = prefabIndex.emplace(prefab, prefabArray.size());
+            if (inserted.second) prefabArray.append(prefab->toJson());
+
+            o["prefab"] = inserted.first->second;
+            o["overrides"] = prefab->diff(objPtr->serialize());
+        }
+        else {
+            o = objPtr->serialize();
+        }
+
+        auto parent = indexOf.find(getParent(objPtr->getHandle()));
+        o["parent"] = parent != indexOf.end() ? parent->second : -1;
+        objArray.append(o);
     }
+    root["prefabs"] = prefabArray;
     root["objects"] = objArray;
 
     QFile f(filePath);
@@ -146,40 +490,42 @@ void Scene::loadFromFile(const QString& filePath) {
     lightingEnabled = root["lightingEnabled"].toBool();
     skyboxPath = root["skyboxPath"].toString().toStdString();
 
-    objects.clear();
+    std::vector<std::shared_ptr<const Prefab>> prefabs;
+    for (const auto& prefabValue : root["prefabs"].toArray()) {
+        prefabs.push_back(Prefab::fromJson(prefabValue.toObject()));
+    }
 
     QJsonArray objArray = root["objects"].toArray();
+    std::vector<std::unique_ptr<SceneObject>> loaded;
+    std::vector<SceneObject*> loadedRaw;
+    loaded.reserve(objArray.size());
+    loadedRaw.reserve(objArray.size());
     for (const auto& objValue : objArray) {
-        QJsonObject jsObj = objValue.toObject();
-
-        std::string name = jsObj["name"].toString().toStdString();
-        auto newObj = std::make_unique<SceneObject>(name);
-
-        QJsonArray components = jsObj["components"].toArray();
-        for (const auto& compValue : components) {
-            QJsonObject compObj = compValue.toObject();
-            QString type = compObj["type"].toString();
-            QJsonObject data = compObj["data"].toObject();
-
-            if (type == "Transform") {
-                if (auto* tr = newObj->getComponent<Transform>()) {
-                    tr->deserialize(data);
-                }
-            }
-            else if (type == "MeshRenderer") {
-                if (auto* mr = newObj->addComponent<MeshRenderer>()) {
-                    mr->deserialize(data);
-                }
-            }
-            else if (type == "Light") {
-                if (auto* light = newObj->addComponent<Light>()) {
-                    light->deserialize(data);
-                }
-            }
+        const QJsonObject o = objValue.toObject();
+        const int prefabIndex = o["prefab"].toInt(-1);
+        if (prefabIndex >= 0 && prefabIndex < static_cast<int>(prefabs.size())) {
+            loaded.push_back(prefabs[prefabIndex]->instantiate(o["overrides"].toObject()));
         }
+        else {
+            loaded.push_back(instantiate(o));
+        }
+        loadedRaw.push_back(loaded.back().get());
+    }
 
-        addObject(std::move(newObj));
+    beginBatch();
+    clear();
+    addObjects(std::move(loaded));
+    commit();
+
+    // Handles only exist once the objects are in the scene, so links go in a second batch
+    beginBatch();
+    for (int i = 0; i < objArray.size(); ++i) {
+        int parentIndex = objArray[i].toObject()["parent"].toInt(-1);
+        if (parentIndex >= 0 && parentIndex < objArray.size()) {
+            setParent(loadedRaw[i]->getHandle(), loadedRaw[parentIndex]->getHandle());
+        }
     }
+    commit();
 
     skyboxDirty = true;
     lightingDirty = true;
@@ -187,7 +533,7 @@ void Scene::loadFromFile(const QString& filePath) {
     ConsolePanel::sInfo("Scene loaded from: " + filePath);
 }
 
-void Scene::updateSkybox(LPDIRECT3DDEVICE9 device) {
+void Scene::updateSkybox(RenderDevice& device) {
     if (skyboxDirty) {
         // Release old skybox
         if (skybox) {
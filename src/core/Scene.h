@@ -3,14 +3,36 @@
 #include "PhysicsSystem.h"
 #include "MeshRenderer.h"
 #include "SceneObject.h"
+#include "ArchetypeStorage.h"
+#include "SceneView.h"
+#include "SlotMap.h"
+#include "ChangeBus.h"
+#include "TransformHierarchy.h"
+#include "SystemScheduler.h"
+#include "ComponentUpdateSystem.h"
+#include "TransformSystem.h"
+#include "BoundsSystem.h"
+#include "RenderSnapshot.h"
+#include "DynamicAabbTree.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
 #include "Skybox.h"
 #include <QObject>
 #include <vector>
 #include <memory>
 #include <mutex>
-#include <d3d9.h>
+#include <cstring>
 #include <QJsonObject>
 
+class RenderQueue;
+
+// Structural changes applied by one Scene::commit()
+struct SceneChangeSet {
+    std::vector<EntityHandle> added;
+    std::vector<EntityHandle> removed;   // already stale when the notification fires
+    std::vector<EntityHandle> reparented;
+    bool cleared = false;                 // every object that existed before the commit was removed
+};
 
 class Scene : public QObject {
     Q_OBJECT
@@ -18,17 +40,94 @@ public:
     Scene(QObject* parent = nullptr);
     ~Scene();
 
-    void updateSkybox(LPDIRECT3DDEVICE9 device);
+    void updateSkybox(RenderDevice& device);
     Skybox* getSkybox() const { return skybox.get(); }
 
-    void addObject(std::unique_ptr<SceneObject> object);
+    // Structural changes between beginBatch() and the matching commit() are queued
+    // and applied in one pass with a single objectsChanged notification. Batches nest;
+    // only the outermost commit applies them.
+    void beginBatch();
+    void addObjects(std::vector<std::unique_ptr<SceneObject>> newObjects);
+    void removeObjects(const std::vector<EntityHandle>& handles);
+    void setParent(EntityHandle child, EntityHandle parent);
+    void commit();
+    bool isBatching() const { return batchDepth > 0; }
+
+    // Removing an object also removes its descendants. Reparenting keeps local
+    // values; a null parent handle makes the child a root.
+
+    // Single-object shorthands. addObject returns a null handle when called inside
+    // an open batch, since handles are only issued on commit.
+    EntityHandle addObject(std::unique_ptr<SceneObject> object);
+    void removeObject(EntityHandle handle);
     void removeObject(SceneObject* object);
-
-    void render(LPDIRECT3DDEVICE9 device);
+    void clear();
+
+    // Builds a detached object from SceneObject::serialize() output
+    static std::unique_ptr<SceneObject> instantiate(const QJsonObject& data);
+
+    // Resolves a handle, returning nullptr once the object has been removed
+    SceneObject* getObject(EntityHandle handle) const;
+    bool isValid(EntityHandle handle) const { return objects.contains(handle); }
+    EntityHandle getParent(EntityHandle handle) const;
+
+    // Runs one frame of every registered system on the job pool. Needs no device,
+    // so it can be driven headless.
+    void update(float deltaTime) { beginUpdate(deltaTime); endUpdate(); }
+
+    // Starts a step on the job pool and returns at once. Until endUpdate() the
+    // caller may read getSnapshot() and the components in FrameOwnedMask, but must
+    // not change the scene or read transforms.
+    void beginUpdate(float deltaTime);
+
+    // Waits for the running step and makes its snapshot the front one
+    void endUpdate();
+    bool isUpdating() const { return updating; }
+
+    // World matrices as of the last finished step
+    const RenderSnapshot& getSnapshot() const { return snapshots[frontSnapshot]; }
+    SystemScheduler& getScheduler() { return scheduler; }
+
+    // Delivers everything published on the change bus since the last call as one
+    // objectsModified notification. Main thread, once per frame.
+    void flushChanges();
+
+    // Recomputes world matrices of everything that moved since the last call
+    void updateTransforms() { hierarchy.update(); }
+    TransformHierarchy& getHierarchy() { return hierarchy; }
+
+    // Spatial queries over mesh world bounds as of the last update() or flushChanges().
+    // The frustum takes a row-vector view * projection matrix.
+    std::vector<EntityHandle> queryFrustum(const Mat4& viewProjection) const;
+    std::vector<EntityHandle> queryAabb(const Aabb& box) const;
+    std::vector<EntityHandle> querySphere(const Vec3& center, float radius) const;
+
+    // Closest mesh whose bounds the ray enters within maxDistance; null handle on a miss
+    EntityHandle raycast(const Vec3& origin, const Vec3& direction,
+        float maxDistance, float* hitDistance = nullptr) const;
+    const DynamicAabbTree& getSpatialIndex() const { return spatialIndex; }
+
+    // Frame culling: every mesh tested flat against the frustum on the job pool,
+    // also dropping those covering less than minScreenSize of the viewport height,
+    // then those hidden behind the renderers marked as occluders.
+    // Call outside a running step.
+    std::vector<EntityHandle> cullVisible(const Mat4& viewProjection, float minScreenSize);
+    const CullStats& getCullStats() const { return culler.getStats(); }
+    const OcclusionStats& getOcclusionStats() const { return occlusion.getStats(); }
+
+    void setOcclusionCullingEnabled(bool enabled) { occlusionCullingEnabled = enabled; }
+    bool getOcclusionCullingEnabled() const { return occlusionCullingEnabled; }
+
+    void render(RenderDevice& device, RenderQueue& queue);
     const std::vector<std::unique_ptr<SceneObject>>& getObjects() const;
+    ArchetypeStorage& getStorage() { return storage; }
+
+    // Only the objects having all of Ts, e.g. scene.view<Transform, MeshRenderer>()
+    template<typename... Ts>
+    SceneView<Ts...> view() { return SceneView<Ts...>(storage); }
 
     void invalidateDeviceObjects();
-    void restoreDeviceObjects(LPDIRECT3DDEVICE9 device);
+    void restoreDeviceObjects(RenderDevice& device);
 
     void saveToFile(const QString& filePath);
     void loadFromFile(const QString& filePath);
@@ -41,13 +140,13 @@ public:
     }
     const std::string& getSkyboxPath() const { return skyboxPath; }
 
-    void setAmbientColor(const D3DCOLORVALUE& color) {
-        if (memcmp(&ambientColor, &color, sizeof(D3DCOLORVALUE)) != 0) {
+    void setAmbientColor(const Color& color) {
+        if (memcmp(&ambientColor, &color, sizeof(Color)) != 0) {
             ambientColor = color;
             lightingDirty = true;
         }
     }
-    const D3DCOLORVALUE& getAmbientColor() const { return ambientColor; }
+    const Color& getAmbientColor() const { return ambientColor; }
 
     void setLightIntensity(float intensity) {
         if (lightIntensity != intensity) {
@@ -79,21 +178,51 @@ public:
     void clearSkyboxDirty() { skyboxDirty = false; }
 
     bool isPhysicsEnabled() const { return PhysicsSystem::getInstance().isSimulationEnabled(); }
-    void physicsUpdate(float deltaTime);
     void setPhysicsEnabled(bool enabled);
 
 signals:
-    void objectAdded(SceneObject* object);
-    void objectRemoved(SceneObject* object);
+    void objectsChanged(const SceneChangeSet& changes);
+    void objectsModified(const std::vector<ObjectModification>& modifications);
     void objectPropertiesChanged();
 
 private:
-    std::vector<std::unique_ptr<SceneObject>> objects;
+    // Declared before objects so they outlive them during destruction
+    ArchetypeStorage storage;
+    TransformHierarchy hierarchy;
+    DynamicAabbTree spatialIndex;
+    FrustumCuller culler;
+    SlotMap<std::unique_ptr<SceneObject>> objects;
+
+    ChangeBus changeBus;
+    std::vector<ObjectModification> pendingModifications;
+
+    SystemScheduler scheduler;
+    ComponentUpdateSystem updateSystem{ storage };
+    TransformSystem transformSystem{ hierarchy };
+    BoundsSystem boundsSystem{ *this, spatialIndex, culler };
+
+    RenderSnapshot snapshots[2];
+    int frontSnapshot = 0;
+
+    // Fed from the front snapshot's worlds, which match the culler's bounds
+    OcclusionCuller occlusion;
+    bool occlusionCullingEnabled = true;
+    bool rasterizeOccluders(const Mat4& viewProjection);
+
+    uint64_t stepCount = 0;
+    JobCounter stepCounter;
+    bool updating = false;
     std::unique_ptr<Skybox> skybox;
     std::string skyboxPath;
-    std::mutex sceneMutex;
 
-    D3DCOLORVALUE ambientColor{};
+    // Pending structural commands for the open batch
+    int batchDepth = 0;
+    std::vector<std::unique_ptr<SceneObject>> pendingAdds;
+    std::vector<EntityHandle> pendingRemoves;
+    std::vector<std::pair<EntityHandle, EntityHandle>> pendingParents;
+    bool pendingClear = false;
+
+    Color ambientColor{};
     float lightIntensity = 1.0f;
     bool shadowsEnabled = true;
     bool lightingEnabled = false;
@@ -1,34 +1,42 @@
 #pragma once
 
-#include <QObject>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <vector>
 #include <memory>
-#include <typeindex>
-#include <unordered_map>
 #include <algorithm>
 #include <cassert>
-#include <d3d9.h>
+#include <atomic>
 
 #include "Component.h"
+#include "ArchetypeStorage.h"
+#include "SlotMap.h"
+#include "ChangeBus.h"
 #include "Transform.h"
 class Transform;
+class Prefab;
 
-class SceneObject : public QObject {
-    Q_OBJECT
+class SceneObject {
 public:
-    explicit SceneObject(const std::string& name = "Entity", QObject* parent = nullptr) : QObject(parent), name(name)
+    explicit SceneObject(const std::string& name = "Entity") : name(name)
     {
-        this->addComponent<Transform>(this);
+        ArchetypeStorage::detached().insert(this);
+        this->addComponent<Transform>();
     }
 
+    ~SceneObject() {
+        if (storage) storage->destroy(this);
+    }
+
+    SceneObject(const SceneObject&) = delete;
+    SceneObject& operator=(const SceneObject&) = delete;
+
     QJsonObject SceneObject::serialize() const {
         QJsonObject o;
         o["name"] = QString::fromStdString(name);
 
         QJsonArray componentsArray;
-        for (const auto& comp : orderedComponents) {
+        for (const auto& comp : getAllComponents()) {
             QJsonObject compObj;
             compObj["type"] = QString::fromStdString(comp->getTypeName());
             compObj["data"] = comp->serialize();
@@ -42,73 +50,103 @@ public:
     void setName(std::string value) {
         if (name != value) {
             name = value;
-            emit nameChanged(name);
+            notifyChanged(ObjectChangeName);
         }
     }
     const std::string& getName() const { return name; }
 
-    const std::vector<Component*>& getAllComponents() const { return orderedComponents; }
+    // Components in ascending type id order, so Transform is always first
+    std::vector<Component*> getAllComponents() const {
+        std::vector<Component*> result;
+        result.reserve(archetype->columnCount());
+        for (size_t i = 0; i < archetype->columnCount(); ++i) {
+            result.push_back(archetype->get(static_cast<int>(i), row));
+        }
+        return result;
+    }
 
     template<typename T, typename... Args>
     T* addComponent(Args&&... args) {
-        auto idx = std::type_index(typeid(T));
-        assert(components.find(idx) == components.end());
-        auto comp = std::make_unique<T>(std::forward<Args>(args)...);
-        comp->setOwner(this);
-        T* ptr = comp.get();
-        components[idx] = std::move(comp);
-        orderedComponents.push_back(ptr);
+        static_assert(ComponentTraits<T>::concrete, "Only registered concrete components can be added");
+        T* ptr = storage->addComponent<T>(this, std::forward<Args>(args)...);
+        ptr->setOwner(this);
         ptr->onAttach();
-        connect(this, &SceneObject::propertiesChanged, ptr, &Component::onPropertiesChanged);
+        notifyChanged(ObjectChangeComponents);
         return ptr;
     }
 
     template<typename T>
-    T* getComponent() {
-        auto it = components.find(std::type_index(typeid(T)));
-        return it != components.end() ? static_cast<T*>(it->second.get()) : nullptr;
+    bool hasComponent() const { return (mask & componentMask<T>()) != 0; }
+
+    // Components live in their archetype's columns, so the pointer only holds until
+    // the next structural change of the storage; look it up again after that
+    template<typename T>
+    T* getComponent() const {
+        int column = archetype->findColumn<T>();
+        return column >= 0 ? static_cast<T*>(archetype->get(column, row)) : nullptr;
     }
 
     template<typename T>
     void removeComponent() {
-        auto idx = std::type_index(typeid(T));
-        auto it = components.find(idx);
-        if (it != components.end()) {
-            it->second->onDetach();
-            components.erase(it);
-            orderedComponents.erase(
-                std::remove_if(orderedComponents.begin(), orderedComponents.end(),
-                    [](Component* c) { return dynamic_cast<T*>(c) != nullptr; }),
-                orderedComponents.end());
-        }
+        static_assert(ComponentTraits<T>::concrete, "Only registered concrete components can be removed");
+        storage->removeComponent(this, ComponentTraits<T>::id);
+        notifyChanged(ObjectChangeComponents);
     }
 
+    // Handle issued by the owning Scene; null while the object is detached
+    EntityHandle getHandle() const { return handle; }
+
+    // Prefab this object was placed from; null for standalone objects
+    const std::shared_ptr<const Prefab>& getPrefab() const { return prefab; }
+    void setPrefab(std::shared_ptr<const Prefab> value) { prefab = std::move(value); }
+
+    ComponentMask getComponentMask() const { return mask; }
+    ArchetypeStorage* getStorage() const { return storage; }
+    Archetype* getArchetype() const { return archetype; }
+    size_t getRow() const { return row; }
+
     void update(float dt) {
-        for (auto* c : orderedComponents) c->update(dt);
+        for (auto* c : getAllComponents()) c->update(dt);
     }
 
-    void render(LPDIRECT3DDEVICE9 device) {
-        for (auto* c : orderedComponents) c->render(device);
+    void render(RenderDevice& device) {
+        for (auto* c : getAllComponents()) c->render(device);
     }
 
     void invalidateDeviceObjects() {
-        for (auto* c : orderedComponents)
+        for (auto* c : getAllComponents())
             c->invalidateDeviceObjects();
     }
 
-    bool restoreDeviceObjects(LPDIRECT3DDEVICE9 device) {
+    bool restoreDeviceObjects(RenderDevice& device) {
         bool ok = true;
-        for (auto* c : orderedComponents)
+        for (auto* c : getAllComponents())
             ok &= c->restoreDeviceObjects(device);
         return ok;
     }
 
-signals:
-    void propertiesChanged();
-    void nameChanged(const std::string& newName);
+    // Queues the object on its scene's change bus; dropped while detached
+    void notifyChanged(uint32_t changes) {
+        if (changeBus) changeBus->publish(this, changes);
+    }
 
 private:
+    friend class ArchetypeStorage;
+    friend class ChangeBus;
+    friend class Scene;
+
     std::string name;
-    std::unordered_map<std::type_index, std::unique_ptr<Component>> components;
-    std::vector<Component*> orderedComponents;
+    EntityHandle handle;
+    std::shared_ptr<const Prefab> prefab;
+
+    // Location of this object's components inside its storage
+    ArchetypeStorage* storage = nullptr;
+    Archetype* archetype = nullptr;
+    size_t row = 0;
+    ComponentMask mask = 0;
+
+    // Change bus bookkeeping, see ChangeBus
+    ChangeBus* changeBus = nullptr;
+    std::atomic<uint32_t> pendingChanges{ 0 };
+    SceneObject* nextPending = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ArchetypeStorage.h"
+#include "JobSystem.h"
+#include <vector>
+#include <tuple>
+#include <utility>
+
+// Objects that have every one of Ts, obtained from Scene::view<Ts...>(). The view
+// holds the matching archetypes at the time it was made; structural changes made
+// afterwards are picked up by the next view.
+template<typename... Ts>
+class SceneView {
+public:
+    explicit SceneView(ArchetypeStorage& storage) : archetypes(storage.template match<Ts...>()) {}
+
+    size_t size() const {
+        size_t count = 0;
+        for (Archetype* archetype : archetypes) count += archetype->size();
+        return count;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Calls fn(SceneObject&, Ts&...) for every matching object. fn must not add or
+    // remove components or objects, which would move rows under the walk.
+    template<typename Fn>
+    void each(Fn&& fn) const {
+        for (Archetype* archetype : archetypes) {
+            eachRow(*archetype, 0, archetype->size(), fn, std::index_sequence_for<Ts...>{});
+        }
+    }
+
+    // Same as each(), with every archetype's rows split into chunks across the pool.
+    // fn runs concurrently and must only touch the components it is handed.
+    template<typename Fn>
+    void parallelEach(JobSystem& jobs, Fn&& fn, size_t minChunk = 64) const {
+        for (Archetype* archetype : archetypes) {
+            const Archetype& table = *archetype;
+            jobs.parallelFor(table.size(), minChunk, [&table, &fn](size_t begin, size_t end) {
+                eachRow(table, begin, end, fn, std::index_sequence_for<Ts...>{});
+            });
+        }
+    }
+
+    template<typename Fn>
+    void parallelEach(Fn&& fn) const {
+        parallelEach(JobSystem::getInstance(), std::forward<Fn>(fn));
+    }
+
+private:
+    // Concrete types are read straight from their column; a family base goes
+    // through the column's own type, which differs between archetypes
+    template<typename T, bool Concrete = ComponentTraits<T>::concrete>
+    struct Column {
+        T* data;
+        Column(const Archetype& archetype, int column) : data(archetype.template columnData<T>(column)) {}
+        T& operator[](size_t row) const { return data[row]; }
+    };
+
+    template<typename T>
+    struct Column<T, false> {
+        const Archetype& archetype;
+        int column;
+        Column(const Archetype& archetype, int column) : archetype(archetype), column(column) {}
+        T& operator[](size_t row) const { return static_cast<T&>(*archetype.get(column, row)); }
+    };
+
+    template<typename Fn, size_t... Is>
+    static void eachRow(const Archetype& archetype, size_t begin, size_t end, Fn& fn, std::index_sequence<Is...>) {
+        if (begin >= end) return;
+
+        const std::tuple<Column<Ts>...> columns(Column<Ts>(archetype, archetype.template findColumn<Ts>())...);
+        SceneObject* const* objects = archetype.objectData();
+        for (size_t row = begin; row < end; ++row) {
+            fn(*objects[row], std::get<Is>(columns)[row]...);
+        }
+    }
+
+    std::vector<Archetype*> archetypes;
+};
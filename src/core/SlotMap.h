@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <utility>
+#include <functional>
+
+// 32-bit generational handle: low bits index a slot, high bits hold the slot's
+// generation at the time the handle was issued. Generation 0 is never issued,
+// so a default-constructed handle is always invalid.
+struct EntityHandle {
+    static constexpr uint32_t IndexBits = 20;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+    static constexpr uint32_t MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+    uint32_t value = 0;
+
+    static EntityHandle make(uint32_t index, uint32_t generation) {
+        return EntityHandle{ (generation << IndexBits) | (index & IndexMask) };
+    }
+
+    uint32_t index() const { return value & IndexMask; }
+    uint32_t generation() const { return value >> IndexBits; }
+    bool isNull() const { return value == 0; }
+    explicit operator bool() const { return value != 0; }
+
+    bool operator==(const EntityHandle& other) const { return value == other.value; }
+    bool operator!=(const EntityHandle& other) const { return value != other.value; }
+    bool operator<(const EntityHandle& other) const { return value < other.value; }
+};
+
+namespace std {
+    template<> struct hash<EntityHandle> {
+        size_t operator()(const EntityHandle& h) const { return std::hash<uint32_t>()(h.value); }
+    };
+}
+
+// Dense storage addressed through generational handles. Insert, erase and lookup
+// are O(1); values stay packed in one array because erase swaps the last value
+// into the hole. Slots whose generation would wrap are retired instead of reused.
+template<typename T>
+class SlotMap {
+public:
+    EntityHandle insert(T value) {
+        uint32_t index;
+        if (freeHead != NoSlot) {
+            index = freeHead;
+            freeHead = sparse[index].dense;
+        }
+        else {
+            assert(sparse.size() <= EntityHandle::IndexMask && "SlotMap is full");
+            index = static_cast<uint32_t>(sparse.size());
+            sparse.push_back({ NoSlot, 1 });
+        }
+
+        sparse[index].dense = static_cast<uint32_t>(dense.size());
+        dense.push_back(std::move(value));
+        denseToSlot.push_back(index);
+        return EntityHandle::make(index, sparse[index].generation);
+    }
+
+    bool contains(EntityHandle handle) const {
+        const uint32_t index = handle.index();
+        return !handle.isNull()
+            && index < sparse.size()
+            && sparse[index].generation == handle.generation()
+            && sparse[index].dense != NoSlot;
+    }
+
+    T* get(EntityHandle handle) {
+        return contains(handle) ? &dense[sparse[handle.index()].dense] : nullptr;
+    }
+
+    const T* get(EntityHandle handle) const {
+        return contains(handle) ? &dense[sparse[handle.index()].dense] : nullptr;
+    }
+
+    // Removes and returns the value; the handle must be valid
+    T take(EntityHandle handle) {
+        assert(contains(handle));
+
+        Slot& slot = sparse[handle.index()];
+        const uint32_t hole = slot.dense;
+        const uint32_t last = static_cast<uint32_t>(dense.size() - 1);
+
+        T value = std::move(dense[hole]);
+        if (hole != last) {
+            dense[hole] = std::move(dense[last]);
+            denseToSlot[hole] = denseToSlot[last];
+            sparse[denseToSlot[hole]].dense = hole;
+        }
+        dense.pop_back();
+        denseToSlot.pop_back();
+
+        release(handle.index());
+        return value;
+    }
+
+    bool erase(EntityHandle handle) {
+        if (!contains(handle)) return false;
+        take(handle);
+        return true;
+    }
+
+    void clear() {
+        for (uint32_t index : denseToSlot) {
+            release(index);
+        }
+        dense.clear();
+        denseToSlot.clear();
+    }
+
+    size_t size() const { return dense.size(); }
+    bool empty() const { return dense.empty(); }
+
+    std::vector<T>& values() { return dense; }
+    const std::vector<T>& values() const { return dense; }
+
+    EntityHandle handleAt(size_t denseIndex) const {
+        const uint32_t index = denseToSlot[denseIndex];
+        return EntityHandle::make(index, sparse[index].generation);
+    }
+
+private:
+    static constexpr uint32_t NoSlot = 0xFFFFFFFFu;
+
+    struct Slot {
+        uint32_t dense;       // index into dense while alive, next free slot while free
+        uint32_t generation;
+    };
+
+    void release(uint32_t index) {
+        Slot& slot = sparse[index];
+        if (slot.generation == EntityHandle::MaxGeneration) {
+            // Retire the slot; reusing it would let stale handles alias new objects
+            slot.dense = NoSlot;
+            slot.generation = 0;
+            return;
+        }
+        ++slot.generation;
+        slot.dense = freeHead;
+        freeHead = index;
+    }
+
+    std::vector<Slot> sparse;
+    std::vector<T> dense;
+    std::vector<uint32_t> denseToSlot;
+    uint32_t freeHead = NoSlot;
+};
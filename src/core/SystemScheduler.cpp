@@ -0,0 +1,79 @@
+#include "SystemScheduler.h"
+#include <algorithm>
+
+SystemScheduler::SystemScheduler(JobSystem& jobs) : jobs(jobs)
+{
+}
+
+void SystemScheduler::addSystem(System* system)
+{
+    if (!system) return;
+    nodes.push_back({ system, {}, 0 });
+    graphDirty = true;
+}
+
+void SystemScheduler::removeSystem(System* system)
+{
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
+        [system](const Node& node) { return node.system == system; }), nodes.end());
+    graphDirty = true;
+}
+
+void SystemScheduler::rebuildGraph()
+{
+    for (auto& node : nodes) {
+        node.dependents.clear();
+        node.dependencyCount = 0;
+    }
+
+    for (size_t later = 0; later < nodes.size(); ++later) {
+        const ComponentMask reads = nodes[later].system->getReadMask();
+        const ComponentMask writes = nodes[later].system->getWriteMask();
+
+        for (size_t earlier = 0; earlier < later; ++earlier) {
+            const ComponentMask earlierReads = nodes[earlier].system->getReadMask();
+            const ComponentMask earlierWrites = nodes[earlier].system->getWriteMask();
+
+            if ((earlierWrites & (reads | writes)) || (writes & earlierReads)) {
+                nodes[earlier].dependents.push_back(later);
+                ++nodes[later].dependencyCount;
+            }
+        }
+    }
+
+    remaining.reset(new std::atomic<int>[nodes.size()]);
+    graphDirty = false;
+}
+
+void SystemScheduler::run(float deltaTime)
+{
+    if (nodes.empty()) return;
+    if (graphDirty) rebuildGraph();
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        remaining[i].store(nodes[i].dependencyCount, std::memory_order_relaxed);
+    }
+
+    JobCounter counter;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].dependencyCount == 0) {
+            schedule(i, deltaTime, counter);
+        }
+    }
+    jobs.wait(counter);
+}
+
+void SystemScheduler::schedule(size_t index, float deltaTime, JobCounter& counter)
+{
+    jobs.submit([this, index, deltaTime, &counter]() {
+        nodes[index].system->update(deltaTime, jobs);
+
+        // Dependents are queued before this job counts as done, so the counter
+        // cannot reach zero while work is still pending
+        for (size_t dependent : nodes[index].dependents) {
+            if (remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                schedule(dependent, deltaTime, counter);
+            }
+        }
+    }, counter);
+}
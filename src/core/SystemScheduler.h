@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ComponentTypeId.h"
+#include "JobSystem.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+
+// Read on the main thread by the frame drawn while a step runs (Light::apply,
+// MeshRenderer::enqueue, which also keeps the LOD it picked), so no system may
+// write these types. BoundsSystem is the one exception: it only writes the bounds
+// entries of MeshRenderer, which the frame never touches.
+constexpr ComponentMask FrameOwnedMask = componentMask<Light>() | componentMask<MeshRenderer>();
+
+// Per-frame work over a set of component types. The masks drive scheduling:
+// two systems may run at the same time unless one writes a type the other touches.
+class System {
+public:
+    virtual ~System() = default;
+
+    virtual const char* getName() const = 0;
+    virtual ComponentMask getReadMask() const { return 0; }
+    virtual ComponentMask getWriteMask() const { return 0; }
+
+    // Runs on a pool thread; large loops can be split further with jobs.parallelFor
+    virtual void update(float deltaTime, JobSystem& jobs) = 0;
+};
+
+// Runs registered systems once per frame as a dependency graph on the job pool.
+// A system that conflicts with one registered before it waits for it; everything
+// else runs in parallel. Systems are not owned.
+class SystemScheduler {
+public:
+    explicit SystemScheduler(JobSystem& jobs = JobSystem::getInstance());
+
+    void addSystem(System* system);
+    void removeSystem(System* system);
+
+    // Blocks until every system has run, helping the pool in the meantime
+    void run(float deltaTime);
+
+    size_t getSystemCount() const { return nodes.size(); }
+
+private:
+    struct Node {
+        System* system;
+        std::vector<size_t> dependents;
+        int dependencyCount = 0;
+    };
+
+    void rebuildGraph();
+    void schedule(size_t index, float deltaTime, JobCounter& counter);
+
+    JobSystem& jobs;
+    std::vector<Node> nodes;
+    std::unique_ptr<std::atomic<int>[]> remaining;
+    bool graphDirty = true;
+};
@@ -0,0 +1,260 @@
+#include "TransformHierarchy.h"
+#include "Transform.h"
+#include "TransformBatch.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+
+TransformHierarchy::~TransformHierarchy()
+{
+    for (Transform* transform : nodes) {
+        if (transform) {
+            transform->hierarchy = nullptr;
+            transform->node = NoNode;
+        }
+    }
+}
+
+void TransformHierarchy::insert(Transform* transform)
+{
+    assert(transform && !transform->hierarchy);
+
+
+    transform->hierarchy = this;
+    transform->node = static_cast<int32_t>(nodes.size());
+
+    // A root may go anywhere, so appending keeps parents ahead of children
+    nodes.push_back(transform);
+    parents.push_back(NoNode);
+    worlds.push_back(Mat4::identity());
+    dirty.push_back(1);
+    for (std::vector<float>& channel : channels) {
+        channel.push_back(0.0f);
+    }
+    storeLocal(transform->node, transform);
+}
+
+void TransformHierarchy::remove(Transform* transform)
+{
+    if (!transform || transform->hierarchy != this) return;
+
+    nodes[transform->node] = nullptr;
+    transform->hierarchy = nullptr;
+    transform->node = NoNode;
+
+    ++removedCount;
+    orderDirty = true;
+}
+
+void TransformHierarchy::relocate(Transform* transform)
+{
+    if (transform->hierarchy == this) nodes[transform->node] = transform;
+}
+
+bool TransformHierarchy::setParent(Transform* child, Transform* parent)
+{
+    if (!child || child->hierarchy != this) return false;
+    if (parent && parent->hierarchy != this) return false;
+
+    const int32_t childNode = child->node;
+    const int32_t parentNode = parent ? parent->node : NoNode;
+
+    for (int32_t p = parentNode; p != NoNode; p = parents[p]) {
+        if (p == childNode) return false;
+    }
+
+    parents[childNode] = parentNode;
+    dirty[childNode] = 1;
+
+    // Children already sit after this node, so only a later parent breaks the order
+    if (parentNode > childNode) {
+        orderDirty = true;
+    }
+    return true;
+}
+
+Transform* TransformHierarchy::getParent(const Transform* transform) const
+{
+    if (!transform || transform->hierarchy != this) return nullptr;
+
+    const int32_t p = parents[transform->node];
+    return p == NoNode ? nullptr : nodes[p];
+}
+
+void TransformHierarchy::collectSubtrees(const std::vector<Transform*>& roots, std::vector<Transform*>& out)
+{
+    if (orderDirty) rebuildOrder();
+
+    std::vector<uint8_t> marked(nodes.size(), 0);
+    for (Transform* root : roots) {
+        if (root && root->hierarchy == this) {
+            marked[root->node] = 1;
+        }
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const int32_t p = parents[i];
+        if (p != NoNode && marked[p]) marked[i] = 1;
+        if (marked[i]) out.push_back(nodes[i]);
+    }
+}
+
+void TransformHierarchy::markDirty(const Transform* transform)
+{
+    if (transform && transform->hierarchy == this) {
+        dirty[transform->node] = 1;
+        storeLocal(transform->node, transform);
+    }
+}
+
+void TransformHierarchy::storeLocal(int32_t node, const Transform* transform)
+{
+    const Quat& rotation = transform->rotation;
+    channels[PositionX][node] = transform->position.x;
+    channels[PositionY][node] = transform->position.y;
+    channels[PositionZ][node] = transform->position.z;
+    channels[RotationX][node] = rotation.x;
+    channels[RotationY][node] = rotation.y;
+    channels[RotationZ][node] = rotation.z;
+    channels[RotationW][node] = rotation.w;
+    channels[ScaleX][node] = transform->scale.x;
+    channels[ScaleY][node] = transform->scale.y;
+    channels[ScaleZ][node] = transform->scale.z;
+}
+
+void TransformHierarchy::update(JobSystem* jobs)
+{
+    if (orderDirty) rebuildOrder();
+    dirtyNodes.clear();
+
+    const size_t count = nodes.size();
+    const int32_t* parentData = parents.data();
+    uint8_t* dirtyData = dirty.data();
+
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t p = parentData[i];
+        if (p != NoNode) dirtyData[i] |= dirtyData[p];
+        if (dirtyData[i]) dirtyNodes.push_back(static_cast<int32_t>(i));
+    }
+    if (dirtyNodes.empty()) return;
+
+    // Local matrices of every dirty node land in worlds first
+    const TransformSoA soa = {
+        channels[PositionX].data(), channels[PositionY].data(), channels[PositionZ].data(),
+        channels[RotationX].data(), channels[RotationY].data(), channels[RotationZ].data(), channels[RotationW].data(),
+        channels[ScaleX].data(), channels[ScaleY].data(), channels[ScaleZ].data()
+    };
+    Mat4* worldData = worlds.data();
+    const int32_t* dirtyList = dirtyNodes.data();
+
+    if (jobs && dirtyNodes.size() >= ParallelThreshold) {
+        jobs->parallelFor(dirtyNodes.size(), ParallelThreshold / 4, [&soa, dirtyList, worldData](size_t begin, size_t end) {
+            composeTransforms(soa, dirtyList + begin, end - begin, worldData);
+        });
+    }
+    else {
+        composeTransforms(soa, dirtyList, dirtyNodes.size(), worldData);
+    }
+
+    // Parents precede children, so each parent is final by the time its children read it
+    for (int32_t i : dirtyNodes) {
+        const int32_t p = parentData[i];
+        if (p != NoNode) {
+            worldData[i] *= worldData[p];
+        }
+        ++nodes[i]->version;
+    }
+
+    std::fill(dirty.begin(), dirty.end(), 0);
+}
+
+const Mat4& TransformHierarchy::getWorldMatrix(const Transform* transform) const
+{
+    assert(transform && transform->hierarchy == this);
+    return worlds[transform->node];
+}
+
+void TransformHierarchy::rebuildOrder()
+{
+    const size_t count = nodes.size();
+
+    // Depth of every live node; children of removed nodes become roots
+    std::vector<int32_t> depth(count, -1);
+    std::vector<int32_t> chain;
+    int32_t maxDepth = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!nodes[i] || depth[i] >= 0) continue;
+
+        int32_t j = static_cast<int32_t>(i);
+        while (depth[j] < 0) {
+            const int32_t p = parents[j];
+            if (p == NoNode || !nodes[p]) {
+                if (p != NoNode) {
+                    parents[j] = NoNode;
+                    dirty[j] = 1;
+                }
+                depth[j] = 0;
+                break;
+            }
+            chain.push_back(j);
+            j = p;
+        }
+
+        while (!chain.empty()) {
+            const int32_t k = chain.back();
+            chain.pop_back();
+            depth[k] = depth[parents[k]] + 1;
+            maxDepth = std::max(maxDepth, depth[k]);
+        }
+    }
+
+    // Stable counting sort by depth
+    std::vector<uint32_t> offsets(maxDepth + 2, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (nodes[i]) ++offsets[depth[i] + 1];
+    }
+    for (size_t d = 1; d < offsets.size(); ++d) {
+        offsets[d] += offsets[d - 1];
+    }
+
+    std::vector<int32_t> remap(count, NoNode);
+    for (size_t i = 0; i < count; ++i) {
+        if (nodes[i]) remap[i] = static_cast<int32_t>(offsets[depth[i]]++);
+    }
+
+    const size_t liveCount = count - removedCount;
+    std::vector<Transform*> newNodes(liveCount);
+    std::vector<int32_t> newParents(liveCount);
+    std::vector<Mat4> newWorlds(liveCount);
+    std::vector<uint8_t> newDirty(liveCount);
+    std::vector<float> newChannels[ChannelCount];
+    for (std::vector<float>& channel : newChannels) {
+        channel.resize(liveCount);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!nodes[i]) continue;
+
+        const int32_t target = remap[i];
+        newNodes[target] = nodes[i];
+        newParents[target] = parents[i] == NoNode ? NoNode : remap[parents[i]];
+        newWorlds[target] = worlds[i];
+        newDirty[target] = dirty[i];
+        for (int c = 0; c < ChannelCount; ++c) {
+            newChannels[c][target] = channels[c][i];
+        }
+        nodes[i]->node = target;
+    }
+
+    nodes.swap(newNodes);
+    parents.swap(newParents);
+    worlds.swap(newWorlds);
+    dirty.swap(newDirty);
+    for (int c = 0; c < ChannelCount; ++c) {
+        channels[c].swap(newChannels[c]);
+    }
+
+    removedCount = 0;
+    orderDirty = false;
+}
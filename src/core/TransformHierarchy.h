@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Mat4.h"
+
+class Transform;
+class JobSystem;
+
+// Parent/child links, local values and world matrices for every Transform in a
+// scene, kept in flat arrays sorted by depth so each node comes after its parent.
+// A node is dirty if its own local values changed or its parent was dirty, which
+// pushes dirtiness down the subtree without recursion. update() composes the local
+// matrices of all dirty nodes in one batched SIMD pass over structure-of-arrays
+// copies of position, rotation and scale, then concatenates parents in order.
+// Structural edits only flag the order as stale; it is rebuilt once, lazily,
+// before the next pass.
+class TransformHierarchy {
+public:
+    static constexpr int32_t NoNode = -1;
+
+    TransformHierarchy() = default;
+    ~TransformHierarchy();
+
+    TransformHierarchy(const TransformHierarchy&) = delete;
+    TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+    // New nodes start as roots
+    void insert(Transform* transform);
+    void remove(Transform* transform);
+
+    // Points the transform's node at its new address after it was moved
+    void relocate(Transform* transform);
+
+    // Passing nullptr makes the transform a root. Local values are kept, so the
+    // world placement follows the new parent. Returns false if it would create a cycle.
+    bool setParent(Transform* child, Transform* parent);
+    Transform* getParent(const Transform* transform) const;
+
+    // Appends the given transforms and all their descendants, parents first
+    void collectSubtrees(const std::vector<Transform*>& roots, std::vector<Transform*>& out);
+
+    // Copies the transform's local values into the hierarchy for the next update()
+    void markDirty(const Transform* transform);
+
+    // Bumps the version of every transform whose world matrix it recomputes.
+    // Large batches are split across the pool when one is given
+    void update(JobSystem* jobs = nullptr);
+
+    const Mat4& getWorldMatrix(const Transform* transform) const;
+
+    size_t size() const { return nodes.size() - removedCount; }
+
+    // Raw node order used by update(); entries may be null until the next update()
+    const std::vector<Transform*>& getNodes() const { return nodes; }
+    const std::vector<Mat4>& getWorlds() const { return worlds; }
+
+private:
+    enum Channel {
+        PositionX, PositionY, PositionZ,
+        RotationX, RotationY, RotationZ, RotationW,
+        ScaleX, ScaleY, ScaleZ,
+        ChannelCount
+    };
+
+    // Below this many dirty nodes the compose pass is not worth splitting
+    static constexpr size_t ParallelThreshold = 4096;
+
+    void storeLocal(int32_t node, const Transform* transform);
+    void rebuildOrder();
+
+    // Parallel arrays indexed by node; removed nodes stay as holes until the next rebuild
+    std::vector<Transform*> nodes;
+    std::vector<int32_t> parents;
+    std::vector<Mat4> worlds;
+    std::vector<uint8_t> dirty;
+    std::vector<float> channels[ChannelCount];
+    std::vector<int32_t> dirtyNodes;
+
+    size_t removedCount = 0;
+    bool orderDirty = false;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "SystemScheduler.h"
+#include "TransformHierarchy.h"
+
+// Refreshes world matrices once everything that moves transforms has run
+class TransformSystem : public System {
+public:
+    explicit TransformSystem(TransformHierarchy& hierarchy) : hierarchy(hierarchy) {}
+
+    const char* getName() const override { return "Transforms"; }
+    ComponentMask getReadMask() const override { return componentMask<Transform>(); }
+    ComponentMask getWriteMask() const override { return componentMask<Transform>(); }
+
+    void update(float, JobSystem& jobs) override { hierarchy.update(&jobs); }
+
+private:
+    TransformHierarchy& hierarchy;
+};
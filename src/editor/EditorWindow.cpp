@@ -83,6 +83,9 @@ EditorWindow::EditorWindow(const QString& projectPath, QWidget* parent)
     connect(sceneHierarchyPanel, &SceneHierarchyPanel::objectSelected,
         viewport, &Viewport::onObjectSelected);
 
+    connect(viewport, &Viewport::objectPicked,
+        sceneHierarchyPanel, &SceneHierarchyPanel::selectObject);
+
     auto* bottomSplitter = new QSplitter(Qt::Horizontal);
     verticalSplitter->addWidget(bottomSplitter);
     verticalSplitter->setStretchFactor(1, 2);
@@ -92,8 +95,6 @@ EditorWindow::EditorWindow(const QString& projectPath, QWidget* parent)
 
     auto& consolePanel = ConsolePanel::instance(this);
     bottomSplitter->addWidget(&consolePanel);
-
-    connect(scene, &Scene::objectAdded, sceneHierarchyPanel, &SceneHierarchyPanel::updateHierarchy);
 }
 
 void EditorWindow::openEnvironmentSettings() {
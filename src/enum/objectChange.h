@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Bits carried by the scene's change bus; several can be pending for one object
+enum ObjectChange : uint32_t {
+    ObjectChangeTransform  = 1u << 0,
+    ObjectChangeProperties = 1u << 1,
+    ObjectChangeName       = 1u << 2,
+    ObjectChangeComponents = 1u << 3,
+};
@@ -100,7 +100,7 @@ void EnvironmentSettingsWindow::loadCurrentSettings() {
     skyboxPathEdit->setText(QString::fromStdString(scene->getSkyboxPath()));
 
     // Loading lighting settings
-    const D3DCOLORVALUE& ambient = scene->getAmbientColor();
+    const Color& ambient = scene->getAmbientColor();
     ambientColor = QColor::fromRgbF(ambient.r, ambient.g, ambient.b);
     ambientColorButton->setStyleSheet(QString("background-color: %1").arg(ambientColor.name()));
 
@@ -141,7 +141,7 @@ void EnvironmentSettingsWindow::applySettings() {
         scene->setSkyboxPath(newPath);
     }
 
-    D3DCOLORVALUE ambient;
+    Color ambient;
     ambient.r = ambientColor.redF();
     ambient.g = ambientColor.greenF();
     ambient.b = ambientColor.blueF();
@@ -1,5 +1,7 @@
 ﻿#include "Viewport.h"
 #include "ConsolePanel.h"
+#include "Light.h"
+#include "D3DConvert.h"
 #include <QKeyEvent>
 #include <QMouseEvent>
 #include <algorithm>
@@ -35,8 +37,12 @@ Viewport::~Viewport() {
     cleanup();
 }
 
-void Viewport::onObjectSelected(SceneObject* obj) {
-    selectedObject = obj;
+void Viewport::onObjectSelected(EntityHandle handle) {
+    selectedHandle = handle;
+}
+
+SceneObject* Viewport::getSelectedObject() const {
+    return scene ? scene->getObject(selectedHandle) : nullptr;
 }
 
 bool Viewport::initD3D() {
@@ -68,21 +74,17 @@ bool Viewport::initD3D() {
         return false;
     }
 
+    renderDevice = std::make_unique<D3D9RenderDevice>(device);
+
     if (cameraInitialized) {
-        D3DXMATRIX view;
-        D3DXVECTOR3 lookAt = cameraPos + cameraDir;
-        D3DXMatrixLookAtLH(&view, &cameraPos, &lookAt, &cameraUp);
-        device->SetTransform(D3DTS_VIEW, &view);
+        applyViewMatrix();
     }
     else {
         cameraPos = { 0,0,-5 };
         cameraDir = { 0,0,1 };
         cameraUp = { 0,1,0 };
 
-        D3DXMATRIX view;
-        D3DXVECTOR3 lookAt = cameraPos + cameraDir;
-        D3DXMatrixLookAtLH(&view, &cameraPos, &lookAt, &cameraUp);
-        device->SetTransform(D3DTS_VIEW, &view);
+        applyViewMatrix();
 
         cameraInitialized = true;
     }
@@ -91,21 +93,14 @@ bool Viewport::initD3D() {
     device->SetRenderState(D3DRS_CULLMODE, D3DCULL_CCW);
     device->SetRenderState(D3DRS_LIGHTING, scene->getLightingEnabled() ? TRUE : FALSE);
 
-    float aspect = width() / static_cast<float>(height());
-    D3DXMATRIX proj;
-    D3DXMatrixPerspectiveFovLH(&proj, D3DXToRadian(90.0f), aspect, 0.1f, 100.0f);
-    device->SetTransform(D3DTS_PROJECTION, &proj);
-
-    D3DXMATRIX view;
-    D3DXVECTOR3 lookAt = cameraPos + cameraDir;
-    D3DXMatrixLookAtLH(&view, &cameraPos, &lookAt, &cameraUp);
-    device->SetTransform(D3DTS_VIEW, &view);
+    device->SetTransform(D3DTS_PROJECTION, toD3D(getProjectionMatrix()));
+    applyViewMatrix();
 
     if (scene) {
-        scene->restoreDeviceObjects(device);
-        scene->updateSkybox(device);
+        scene->restoreDeviceObjects(*renderDevice);
+        scene->updateSkybox(*renderDevice);
 
-        D3DCOLORVALUE ambient = scene->getAmbientColor();
+        const Color& ambient = scene->getAmbientColor();
         device->SetRenderState(D3DRS_AMBIENT, D3DCOLOR_COLORVALUE(
             ambient.r, ambient.g, ambient.b, ambient.a));
         device->SetRenderState(D3DRS_SHADEMODE, D3DSHADE_GOURAUD);
@@ -124,6 +119,11 @@ bool Viewport::initD3D() {
 }
 
 void Viewport::cleanup() {
+    // Scene resources belong to the render device, so they go before it does
+    if (scene) scene->invalidateDeviceObjects();
+    renderQueue.releaseDeviceObjects();
+    renderDevice.reset();
+
     if (device) { device->Release(); device = nullptr; }
     if (d3d) { d3d->Release(); d3d = nullptr; }
     if (gizmoLine) { gizmoLine->Release(); gizmoLine = nullptr; }
@@ -171,9 +171,9 @@ void Viewport::resizeEvent(QResizeEvent* event) {
     if (!device) return;
 
     bool wasCameraInitialized = cameraInitialized;
-    D3DXVECTOR3 savedCameraPos = cameraPos;
-    D3DXVECTOR3 savedCameraDir = cameraDir;
-    D3DXVECTOR3 savedCameraUp = cameraUp;
+    Vec3 savedCameraPos = cameraPos;
+    Vec3 savedCameraDir = cameraDir;
+    Vec3 savedCameraUp = cameraUp;
     float savedYaw = yaw;
     float savedPitch = pitch;
 
@@ -207,16 +207,13 @@ void Viewport::resizeEvent(QResizeEvent* event) {
         yaw = savedYaw;
         pitch = savedPitch;
 
-        D3DXMATRIX view;
-        D3DXVECTOR3 lookAt = cameraPos + cameraDir;
-        D3DXMatrixLookAtLH(&view, &cameraPos, &lookAt, &cameraUp);
-        device->SetTransform(D3DTS_VIEW, &view);
+        applyViewMatrix();
     }
 
     applyCommonRenderStates();
     if (scene) {
-        scene->restoreDeviceObjects(device);
-        scene->updateSkybox(device);
+        scene->restoreDeviceObjects(*renderDevice);
+        scene->updateSkybox(*renderDevice);
     }
 
     if (FAILED(D3DXCreateLine(device, &gizmoLine))) {
@@ -230,13 +227,15 @@ void Viewport::keyPressEvent(QKeyEvent* ev) { pressedKeys.insert(ev->key()); }
 void Viewport::keyReleaseEvent(QKeyEvent* ev) { pressedKeys.remove(ev->key()); }
 
 void Viewport::mousePressEvent(QMouseEvent* ev) {
+    SceneObject* selectedObject = getSelectedObject();
     if (ev->button() == Qt::LeftButton && selectedObject) {
         auto* tr = selectedObject->getComponent<Transform>();
         if (!tr) return;
 
-        const auto& position = tr->getPosition();
+        // The gizmo sits at the world position, whatever the parent
+        const Vec3 position = tr->getWorldMatrix().getTranslation();
 
-        struct Axe { D3DXVECTOR3 dir; DragAxis axis; };
+        struct Axe { Vec3 dir; DragAxis axis; };
         Axe axes[3] = {
             {{1,0,0}, DragAxis::X},
             {{0,1,0}, DragAxis::Y},
@@ -245,13 +244,11 @@ void Viewport::mousePressEvent(QMouseEvent* ev) {
         QPoint mouse = ev->pos();
         float bestDist = GIZMO_PICK_THRESHOLD;
         DragAxis bestAxis = DragAxis::None;
-        D3DXVECTOR3 bestDir;
+        Vec3 bestDir;
 
         for (auto& ax : axes) {
-            D3DXVECTOR3 p0 = position;
-            D3DXVECTOR3 p1 = position + ax.dir * GIZMO_LENGTH;
-            QPoint s0 = projectToScreen(p0, device);
-            QPoint s1 = projectToScreen(p1, device);
+            QPoint s0 = projectToScreen(position);
+            QPoint s1 = projectToScreen(position + ax.dir * GIZMO_LENGTH);
 
             float t;
             QPointF diff = s1 - s0;
@@ -272,14 +269,21 @@ void Viewport::mousePressEvent(QMouseEvent* ev) {
             dragging = bestAxis;
             dragAxisDir = bestDir;
             objStartPos = position;
-            D3DXVECTOR3 rayO, rayD;
-            BuildPickingRay(ev->pos(), rayO, rayD);
-            dragStartWorld = ProjectPointOnLine(rayO, rayD, objStartPos, dragAxisDir);
+            dragStartWorld = closestPointOnLine(buildPickingRay(ev->pos()), objStartPos, dragAxisDir);
             setCursor(Qt::SizeAllCursor);
             return;
         }
     }
 
+    if (ev->button() == Qt::LeftButton && scene && device) {
+        const Ray ray = buildPickingRay(ev->pos());
+        EntityHandle picked = scene->raycast(ray.origin, ray.direction, PICK_DISTANCE);
+        if (picked) {
+            emit objectPicked(picked);
+            return;
+        }
+    }
+
     if (ev->button() == Qt::RightButton) {
         rightMouseHeld = true;
         cursorLocked = true;
@@ -312,15 +316,17 @@ void Viewport::mouseReleaseEvent(QMouseEvent* ev) {
 }
 
 void Viewport::mouseMoveEvent(QMouseEvent* ev) {
+    SceneObject* selectedObject = getSelectedObject();
     if (dragging != DragAxis::None && selectedObject) {
-        D3DXVECTOR3 rayO, rayD;
-        BuildPickingRay(ev->pos(), rayO, rayD);
-        D3DXVECTOR3 currentProj = ProjectPointOnLine(rayO, rayD, objStartPos, dragAxisDir);
-        D3DXVECTOR3 delta = currentProj - dragStartWorld;
-        float offset = D3DXVec3Dot(&delta, &dragAxisDir);
-        D3DXVECTOR3 newPos = objStartPos + dragAxisDir * offset;
+        Vec3 currentProj = closestPointOnLine(buildPickingRay(ev->pos()), objStartPos, dragAxisDir);
+        float offset = dot(currentProj - dragStartWorld, dragAxisDir);
+        Vec3 newPos = objStartPos + dragAxisDir * offset;
         auto* tr = selectedObject->getComponent<Transform>();
         if (tr) {
+            // The drag happens in world space; the position is stored in the parent's
+            if (Transform* parent = tr->getParent()) {
+                newPos = transformPoint(newPos, inverse(parent->getWorldMatrix()));
+            }
             tr->setPosition(newPos);
         }
     }
@@ -343,18 +349,15 @@ void Viewport::mouseMoveEvent(QMouseEvent* ev) {
     const float sensitivity = 0.002f;
     yaw += delta.x() * sensitivity;
     pitch -= delta.y() * sensitivity;
-    pitch = std::clamp(pitch, -D3DX_PI / 2 + 0.01f, D3DX_PI / 2 - 0.01f);
+    pitch = std::clamp(pitch, -Pi / 2 + 0.01f, Pi / 2 - 0.01f);
 
-    D3DXVECTOR3 forward;
-    forward.x = std::sin(yaw) * std::cos(pitch);
-    forward.y = std::sin(pitch);
-    forward.z = std::cos(yaw) * std::cos(pitch);
-    D3DXVec3Normalize(&cameraDir, &forward);
+    Vec3 forward(
+        std::sin(yaw) * std::cos(pitch),
+        std::sin(pitch),
+        std::cos(yaw) * std::cos(pitch));
+    cameraDir = normalize(forward);
 
-    D3DXMATRIX view;
-    D3DXVECTOR3 lookAt = cameraPos + cameraDir;
-    D3DXMatrixLookAtLH(&view, &cameraPos, &lookAt, &cameraUp);
-    device->SetTransform(D3DTS_VIEW, &view);
+    applyViewMatrix();
 
     QCursor::setPos(globalCenter);
     ignoreNextMouseMove = true;
@@ -362,9 +365,7 @@ void Viewport::mouseMoveEvent(QMouseEvent* ev) {
 
 
 void Viewport::updateCamera(float deltaTime) {
-    D3DXVECTOR3 right;
-    D3DXVec3Cross(&right, &cameraUp, &cameraDir);
-    D3DXVec3Normalize(&right, &right);
+    Vec3 right = normalize(cross(cameraUp, cameraDir));
 
     const float moveSpeed = 10.0f * deltaTime;
     if (pressedKeys.contains(Qt::Key_W)) {
@@ -386,15 +387,12 @@ void Viewport::updateCamera(float deltaTime) {
         cameraPos += cameraUp * moveSpeed;
     }
 
-    D3DXMATRIX view;
-    D3DXVECTOR3 lookAt = cameraPos + cameraDir;
-    D3DXMatrixLookAtLH(&view, &cameraPos, &lookAt, &cameraUp);
-    device->SetTransform(D3DTS_VIEW, &view);
+    applyViewMatrix();
 }
 
 void Viewport::syncYawPitchWithCameraDir()
 {
-    D3DXVec3Normalize(&cameraDir, &cameraDir);
+    cameraDir = normalize(cameraDir);
     pitch = asinf(cameraDir.y);
     yaw = atan2f(cameraDir.x, cameraDir.z);
 }
@@ -404,52 +402,63 @@ void Viewport::applyCommonRenderStates() {
     device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
     device->SetRenderState(D3DRS_LIGHTING, scene->getLightingEnabled() ? TRUE : FALSE);
 
-    D3DCOLORVALUE ambient = scene->getAmbientColor();
+    const Color& ambient = scene->getAmbientColor();
     device->SetRenderState(D3DRS_AMBIENT, D3DCOLOR_COLORVALUE(
         ambient.r, ambient.g, ambient.b, ambient.a));
 
-    float aspect = width() / float(height());
-    D3DXMATRIX proj;
-    D3DXMatrixPerspectiveFovLH(&proj, D3DXToRadian(90), aspect, 0.1f, 100.0f);
-    device->SetTransform(D3DTS_PROJECTION, &proj);
+    device->SetTransform(D3DTS_PROJECTION, toD3D(getProjectionMatrix()));
 }
 
-void Viewport::BuildPickingRay(const QPoint& mousePos, D3DXVECTOR3& outOrigin, D3DXVECTOR3& outDir)
-{
-    D3DVIEWPORT9 vp; device->GetViewport(&vp);
-    D3DXMATRIX view, proj, world;
+Mat4 Viewport::getViewMatrix() const {
+    return Mat4::lookAtLH(cameraPos, cameraPos + cameraDir, cameraUp);
+}
+
+Mat4 Viewport::getProjectionMatrix() const {
+    float aspect = width() / static_cast<float>(height());
+    return Mat4::perspectiveFovLH(toRadians(90.0f), aspect, 0.1f, 100.0f);
+}
+
+void Viewport::applyViewMatrix() {
+    device->SetTransform(D3DTS_VIEW, toD3D(getViewMatrix()));
+}
+
+Mat4 Viewport::getViewProjection() const {
+    D3DMATRIX view, proj;
     device->GetTransform(D3DTS_VIEW, &view);
     device->GetTransform(D3DTS_PROJECTION, &proj);
-    D3DXMatrixIdentity(&world);
-
-    D3DXVECTOR3 pN, pF;
-    D3DXVec3Unproject(&pN,
-        &D3DXVECTOR3(mousePos.x(), mousePos.y(), 0.0f),
-        &vp, &proj, &view, &world);
-    D3DXVec3Unproject(&pF,
-        &D3DXVECTOR3(mousePos.x(), mousePos.y(), 1.0f),
-        &vp, &proj, &view, &world);
-
-    outOrigin = pN;
-    D3DXVec3Normalize(&outDir, &(pF - pN));
+    return fromD3D(view) * fromD3D(proj);
+}
+
+ViewRect Viewport::getViewRect() const {
+    D3DVIEWPORT9 vp;
+    device->GetViewport(&vp);
+    ViewRect rect;
+    rect.x = static_cast<float>(vp.X);
+    rect.y = static_cast<float>(vp.Y);
+    rect.width = static_cast<float>(vp.Width);
+    rect.height = static_cast<float>(vp.Height);
+    rect.minZ = vp.MinZ;
+    rect.maxZ = vp.MaxZ;
+    return rect;
 }
 
-void Viewport::drawGizmoArrow(const D3DXVECTOR3& start, const D3DXVECTOR3& direction, D3DCOLOR color, float length)
+Ray Viewport::buildPickingRay(const QPoint& mousePos) const
+{
+    return pickingRay(static_cast<float>(mousePos.x()), static_cast<float>(mousePos.y()),
+        getViewProjection(), getViewRect());
+}
+
+void Viewport::drawGizmoArrow(const Vec3& start, const Vec3& direction, D3DCOLOR color, float length)
 {
     if (!gizmoLine) return;
 
-    D3DXMATRIX view, proj, world;
-    D3DVIEWPORT9 vp;
-    device->GetTransform(D3DTS_VIEW, &view);
-    device->GetTransform(D3DTS_PROJECTION, &proj);
-    D3DXMatrixIdentity(&world);
-    device->GetViewport(&vp);
+    const Mat4 viewProj = getViewProjection();
+    const ViewRect rect = getViewRect();
 
-    D3DXVECTOR3 end = start + direction * length;
+    Vec3 end = start + direction * length;
     
-    D3DXVECTOR3 screenStart, screenEnd;
-    D3DXVec3Project(&screenStart, &start, &vp, &proj, &view, &world);
-    D3DXVec3Project(&screenEnd, &end, &vp, &proj, &view, &world);
+    Vec3 screenStart = project(start, viewProj, rect);
+    Vec3 screenEnd = project(end, viewProj, rect);
 
     D3DXVECTOR2 linePoints[] = {
         D3DXVECTOR2(screenStart.x, screenStart.y),
@@ -460,14 +469,11 @@ void Viewport::drawGizmoArrow(const D3DXVECTOR3& start, const D3DXVECTOR3& direc
     const float coneLength = length * 0.2f;
     const float coneRadius = coneLength * 0.4f;
 
-    D3DXVECTOR3 coneBase = end - direction * coneLength;
-    D3DXVECTOR3 perp1, perp2;
-    D3DXVec3Cross(&perp1, &direction, &cameraUp);
-    D3DXVec3Normalize(&perp1, &perp1);
-    D3DXVec3Cross(&perp2, &direction, &perp1);
-    D3DXVec3Normalize(&perp2, &perp2);
+    Vec3 coneBase = end - direction * coneLength;
+    Vec3 perp1 = normalize(cross(direction, cameraUp));
+    Vec3 perp2 = normalize(cross(direction, perp1));
 
-    D3DXVECTOR3 conePoints3D[5] = {
+    Vec3 conePoints3D[5] = {
         end,
         coneBase + perp1 * coneRadius,
         coneBase + perp2 * coneRadius,
@@ -477,27 +483,24 @@ void Viewport::drawGizmoArrow(const D3DXVECTOR3& start, const D3DXVECTOR3& direc
 
     D3DXVECTOR2 conePoints2D[5];
     for (int i = 0; i < 5; i++) {
-        D3DXVECTOR3 screenPoint;
-        D3DXVec3Project(&screenPoint, &conePoints3D[i], &vp, &proj, &view, &world);
+        Vec3 screenPoint = project(conePoints3D[i], viewProj, rect);
         conePoints2D[i] = D3DXVECTOR2(screenPoint.x, screenPoint.y);
     }
 
     gizmoLine->Draw(conePoints2D, 5, color);
 }
 
-void Viewport::drawGizmo()
+void Viewport::drawGizmo(const RenderSnapshot& snapshot)
 {
+    SceneObject* selectedObject = getSelectedObject();
     if (!selectedObject || !gizmoLine) return;
 
-    auto* tr = selectedObject->getComponent<Transform>();
-    if (!tr) return;
+    // Transforms may be changing on the job pool; draw where the snapshot has it
+    const Mat4* world = snapshot.findWorld(selectedObject->getHandle());
+    if (!world) return;
 
-    const auto& position = tr->getPosition();
-
-    QPoint center = projectToScreen(position, device);
-
-    D3DXVECTOR3 origin = position;
-    struct AxeDraw { D3DXVECTOR3 dir; D3DCOLOR color; };
+    const Vec3 origin = world->getTranslation();
+    struct AxeDraw { Vec3 dir; D3DCOLOR color; };
     AxeDraw axes[3] = {
         {{1,0,0}, D3DCOLOR_XRGB(255, 0, 0)},
         {{0,1,0}, D3DCOLOR_XRGB(0, 255, 0)},
@@ -506,12 +509,10 @@ void Viewport::drawGizmo()
 
     struct DepthAxis { float depth; AxeDraw ad; };
     std::vector<DepthAxis> list;
+    const Mat4 view = getViewMatrix();
     for (auto& a : axes) {
-        D3DXVECTOR3 mid = origin + a.dir * (GIZMO_LENGTH * 0.5f);
-        D3DXVECTOR3 viewPt;
-        D3DXMATRIX view; device->GetTransform(D3DTS_VIEW, &view);
-        D3DXVec3TransformCoord(&viewPt, &mid, &view);
-        list.push_back({ viewPt.z, a });
+        Vec3 mid = origin + a.dir * (GIZMO_LENGTH * 0.5f);
+        list.push_back({ transformPoint(mid, view).z, a });
     }
     std::sort(list.begin(), list.end(),
         [](auto& a, auto& b) { return a.depth < b.depth; });
@@ -519,10 +520,8 @@ void Viewport::drawGizmo()
     for (int i = 0; i < 3; ++i) {
         float width = (i == 0 ? 3.0f : 1.5f);
         gizmoLine->SetWidth(width);
-        D3DXVECTOR3 p0 = origin;
-        D3DXVECTOR3 p1 = origin + list[i].ad.dir * GIZMO_LENGTH;
-        QPoint s0 = projectToScreen(p0, device);
-        QPoint s1 = projectToScreen(p1, device);
+        QPoint s0 = projectToScreen(origin);
+        QPoint s1 = projectToScreen(origin + list[i].ad.dir * GIZMO_LENGTH);
         D3DXVECTOR2 pts[2] = {
             D3DXVECTOR2(s0.x(), s0.y()),
             D3DXVECTOR2(s1.x(), s1.y())
@@ -531,49 +530,24 @@ void Viewport::drawGizmo()
     }
 }
 
-QPoint Viewport::projectToScreen(const D3DXVECTOR3& p, IDirect3DDevice9* dev)
+QPoint Viewport::projectToScreen(const Vec3& p) const
 {
-    D3DVIEWPORT9 vp; dev->GetViewport(&vp);
-    D3DXMATRIX view, proj, world;
-    dev->GetTransform(D3DTS_VIEW, &view);
-    dev->GetTransform(D3DTS_PROJECTION, &proj);
-    D3DXMatrixIdentity(&world);
-
-    D3DXVECTOR3 sp;
-    D3DXVec3Project(&sp, &p, &vp, &proj, &view, &world);
+    Vec3 sp = project(p, getViewProjection(), getViewRect());
     return QPoint(int(sp.x), int(sp.y));
 }
 
-float Viewport::DistanceRayToLine(const D3DXVECTOR3& rayO, const D3DXVECTOR3& rayD, const D3DXVECTOR3& lineP, const D3DXVECTOR3& lineDir)
-{
-    D3DXVECTOR3 cross;
-    D3DXVec3Cross(&cross, &rayD, &lineDir);
-    float denom = D3DXVec3Length(&cross);
-    if (denom < 1e-6f) return FLT_MAX;
-    D3DXVECTOR3 diff = lineP - rayO;
-    return fabsf(D3DXVec3Dot(&diff, &cross)) / denom;
-}
-
-D3DXVECTOR3 Viewport::ProjectPointOnLine(const D3DXVECTOR3& rayO, const D3DXVECTOR3& rayD, const D3DXVECTOR3& lineP, const D3DXVECTOR3& lineDir)
-{
-    float t = D3DXVec3Dot(&(lineP - rayO), &rayD);
-    D3DXVECTOR3 p = rayO + rayD * t;
-    float u = D3DXVec3Dot(&(p - lineP), &lineDir);
-    return lineP + lineDir * u;
-}
-
 void Viewport::render() {
     if (!device || !scene) return;
 
     if (scene->isSkyboxDirty()) {
-        scene->updateSkybox(device);
+        scene->updateSkybox(*renderDevice);
         scene->clearSkyboxDirty();
     }
 
     if (scene->isLightingDirty()) {
         device->SetRenderState(D3DRS_LIGHTING, scene->getLightingEnabled() ? TRUE : FALSE);
 
-        D3DCOLORVALUE ambient = scene->getAmbientColor();
+        const Color& ambient = scene->getAmbientColor();
         device->SetRenderState(D3DRS_AMBIENT, D3DCOLOR_COLORVALUE(
             ambient.r, ambient.g, ambient.b, ambient.a));
 
@@ -597,18 +571,23 @@ void Viewport::render() {
     float deltaTime = lastTime > 0 ? (currentTime - lastTime) / 1000.0f : 0.016f;
     lastTime = currentTime;
 
-    if (scene && scene->isPhysicsEnabled()) {
-        scene->physicsUpdate(deltaTime);
-    }
-
     if (deltaTime > 0.1f) deltaTime = 0.016f;
 
+    scene->flushChanges();
     updateCamera(deltaTime);
+
+    // Cull against the bounds of the last finished step before the next one starts
+    const std::vector<EntityHandle> visible = scene->cullVisible(getViewProjection(), MIN_SCREEN_SIZE);
+
+    // The step runs on the job pool while this frame draws the front snapshot.
+    // It is joined before returning, so UI events never overlap it.
+    scene->beginUpdate(deltaTime);
+    const RenderSnapshot& snapshot = scene->getSnapshot();
     device->Clear(0, nullptr, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, D3DCOLOR_XRGB(30, 30, 30), 1.0f, 0);
 
     if (SUCCEEDED(device->BeginScene())) {
         if (scene->getSkybox()) {
-            D3DXMATRIX savedView, savedProj;
+            D3DMATRIX savedView, savedProj;
             device->GetTransform(D3DTS_VIEW, &savedView);
             device->GetTransform(D3DTS_PROJECTION, &savedProj);
 
@@ -619,41 +598,46 @@ void Viewport::render() {
             device->SetRenderState(D3DRS_ZENABLE, FALSE);
             device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
 
-            D3DXMATRIX skyboxView;
-            D3DXVECTOR3 eye(0, 0, 0);
-            D3DXVECTOR3 at = eye + cameraDir;
-            D3DXMatrixLookAtLH(&skyboxView, &eye, &at, &cameraUp);
-            device->SetTransform(D3DTS_VIEW, &skyboxView);
+            const Mat4 skyboxView = Mat4::lookAtLH(Vec3(0, 0, 0), cameraDir, cameraUp);
+            device->SetTransform(D3DTS_VIEW, toD3D(skyboxView));
+            device->SetTransform(D3DTS_PROJECTION, toD3D(getProjectionMatrix()));
 
-            float aspect = width() / static_cast<float>(height());
-            D3DXMATRIX skyboxProj;
-            D3DXMatrixPerspectiveFovLH(&skyboxProj, D3DXToRadian(90), aspect, 0.1f, 100.0f);
-            device->SetTransform(D3DTS_PROJECTION, &skyboxProj);
-
-            scene->getSkybox()->draw(device);
+            scene->getSkybox()->draw(*renderDevice);
 
             device->SetTransform(D3DTS_VIEW, &savedView);
             device->SetTransform(D3DTS_PROJECTION, &savedProj);
             device->SetRenderState(D3DRS_ZENABLE, zEnable);
             device->SetRenderState(D3DRS_CULLMODE, cullMode);
         }
-        for (const auto& obj : scene->getObjects()) {
-            obj->render(device);
+        // Lights and renderers are in FrameOwnedMask, so the running step leaves them alone.
+        // Lights first so meshes in the same frame see them
+        scene->view<Light>().each([this, &snapshot](SceneObject& object, Light& light) {
+            if (const Mat4* world = snapshot.findWorld(object.getHandle())) {
+                light.apply(*renderDevice, *world);
+            }
+        });
+
+        renderQueue.begin(*renderDevice);
+        for (EntityHandle handle : visible) {
+            if (const Mat4* world = snapshot.findWorld(handle)) {
+                scene->getObject(handle)->getComponent<MeshRenderer>()->enqueue(renderQueue, *renderDevice, *world);
+            }
         }
+        renderQueue.submit(*renderDevice);
 
-        if (selectedObject && gizmoLine) {
-            D3DXMATRIX identity;
-            D3DXMatrixIdentity(&identity);
-            device->SetTransform(D3DTS_WORLD, &identity);
+        if (getSelectedObject() && gizmoLine) {
+            device->SetTransform(D3DTS_WORLD, toD3D(Mat4::identity()));
 
             device->SetRenderState(D3DRS_ZENABLE, TRUE);
             device->SetRenderState(D3DRS_ZFUNC, D3DCMP_LESSEQUAL);
 
-            drawGizmo();
+            drawGizmo(snapshot);
         }
 
         device->EndScene();
     }
 
+    scene->endUpdate();
+
     device->Present(nullptr, nullptr, nullptr, nullptr);
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "Skybox.h"
 #include "Scene.h"
 #include "dragAxis.h"
+#include "Projection.h"
+#include "D3D9RenderDevice.h"
+#include "RenderQueue.h"
 #include <QWidget>
 #include <QTimer>
 #include <QPoint>
@@ -10,6 +13,7 @@
 #include <QElapsedTimer>
 #include <d3d9.h>
 #include <d3dx9.h>
+#include <memory>
 
 class Scene;
 
@@ -18,13 +22,22 @@ class Viewport : public QWidget {
 
 public:
     void setScene(Scene* scene) { this->scene = scene; }
-    void setSelectedObject(SceneObject* obj) { selectedObject = obj; }
+
+    // Draws, state changes and sort time of the last frame's mesh pass
+    const RenderQueueStats& getRenderStats() const { return renderQueue.getStats(); }
+    const CullStats& getCullStats() const { return scene->getCullStats(); }
+    const OcclusionStats& getOcclusionStats() const { return scene->getOcclusionStats(); }
+    void setSelectedObject(EntityHandle handle) { selectedHandle = handle; }
 
     explicit Viewport(QWidget* parent = nullptr);
     ~Viewport();
 
 public slots:
-    void onObjectSelected(SceneObject* obj);
+    void onObjectSelected(EntityHandle handle);
+
+signals:
+    // Left click on a mesh that did not grab the gizmo
+    void objectPicked(EntityHandle handle);
 
 protected:
     QPaintEngine* paintEngine() const override { return nullptr; }
@@ -50,27 +63,35 @@ private:
     void updateCamera(float deltaTime);
     void syncYawPitchWithCameraDir();
     void applyCommonRenderStates();
-    void BuildPickingRay(const QPoint& mousePos, D3DXVECTOR3& outOrigin, D3DXVECTOR3& outDir);
-    void drawGizmoArrow(const D3DXVECTOR3& start, const D3DXVECTOR3& direction, D3DCOLOR color, float length);
-    void drawGizmo();
-    static QPoint projectToScreen(const D3DXVECTOR3& p, IDirect3DDevice9* dev);
+    Mat4 getViewMatrix() const;
+    Mat4 getProjectionMatrix() const;
+    void applyViewMatrix();
+
+    // Camera state as currently set on the device
+    Mat4 getViewProjection() const;
+    ViewRect getViewRect() const;
 
-    float DistanceRayToLine(const D3DXVECTOR3& rayO, const D3DXVECTOR3& rayD, const D3DXVECTOR3& lineP, const D3DXVECTOR3& lineDir);
-    D3DXVECTOR3 ProjectPointOnLine(const D3DXVECTOR3& rayO, const D3DXVECTOR3& rayD, const D3DXVECTOR3& lineP, const D3DXVECTOR3& lineDir);
+    Ray buildPickingRay(const QPoint& mousePos) const;
+    void drawGizmoArrow(const Vec3& start, const Vec3& direction, D3DCOLOR color, float length);
+    void drawGizmo(const RenderSnapshot& snapshot);
+    SceneObject* getSelectedObject() const;
+    QPoint projectToScreen(const Vec3& p) const;
 
     Scene* scene = nullptr;
 
-    SceneObject* selectedObject = nullptr;
+    EntityHandle selectedHandle;
     ID3DXLine* gizmoLine = nullptr;
 
     LPDIRECT3D9 d3d = nullptr;
     LPDIRECT3DDEVICE9 device = nullptr;
+    std::unique_ptr<D3D9RenderDevice> renderDevice;
+    RenderQueue renderQueue;
     QTimer* renderTimer = nullptr;
 
     // Camera
-    D3DXVECTOR3 cameraPos;
-    D3DXVECTOR3 cameraDir;
-    D3DXVECTOR3 cameraUp;
+    Vec3 cameraPos;
+    Vec3 cameraDir;
+    Vec3 cameraUp;
     float yaw = 0.0f, pitch = 0.0f;
     bool cameraInitialized = false;
 
@@ -89,9 +110,11 @@ private:
 
     // Gizmo settings
     DragAxis dragging = DragAxis::None;
-    D3DXVECTOR3 dragStartWorld;
-    D3DXVECTOR3 dragAxisDir;
-    D3DXVECTOR3 objStartPos;
+    Vec3 dragStartWorld;
+    Vec3 dragAxisDir;
+    Vec3 objStartPos;
     float GIZMO_LENGTH = 1.0f;
     float GIZMO_PICK_THRESHOLD = 6.0f;
+    float PICK_DISTANCE = 100.0f;       // matches the far plane
+    float MIN_SCREEN_SIZE = 0.002f;     // fraction of the viewport height below which meshes are skipped
 };
\ No newline at end of file
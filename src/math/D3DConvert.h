@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Mat4.h"
+#include <d3d9.h>
+#include <cstring>
+
+// The only bridge between engine math and Direct3D; use it at device calls.
+// Mat4 and D3DMATRIX share one layout, so matrices pass by pointer without a copy.
+static_assert(sizeof(Mat4) == sizeof(D3DMATRIX), "Mat4 must match D3DMATRIX");
+static_assert(sizeof(Vec3) == sizeof(D3DVECTOR), "Vec3 must match D3DVECTOR");
+
+inline const D3DMATRIX* toD3D(const Mat4& m) { return reinterpret_cast<const D3DMATRIX*>(&m); }
+
+inline Mat4 fromD3D(const D3DMATRIX& m) {
+    Mat4 r;
+    std::memcpy(&r, &m, sizeof(Mat4));
+    return r;
+}
+
+inline D3DVECTOR toD3D(const Vec3& v) { return { v.x, v.y, v.z }; }
+inline Vec3 fromD3D(const D3DVECTOR& v) { return { v.x, v.y, v.z }; }
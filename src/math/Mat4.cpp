@@ -0,0 +1,88 @@
+#include "Mat4.h"
+
+Mat4 Mat4::lookAtLH(const Vec3& eye, const Vec3& at, const Vec3& up)
+{
+    const Vec3 zAxis = normalize(at - eye);
+    const Vec3 xAxis = normalize(cross(up, zAxis));
+    const Vec3 yAxis = cross(zAxis, xAxis);
+
+    return { {
+        { xAxis.x, yAxis.x, zAxis.x, 0 },
+        { xAxis.y, yAxis.y, zAxis.y, 0 },
+        { xAxis.z, yAxis.z, zAxis.z, 0 },
+        { -dot(xAxis, eye), -dot(yAxis, eye), -dot(zAxis, eye), 1 }
+    } };
+}
+
+Mat4 Mat4::perspectiveFovLH(float fovY, float aspect, float zNear, float zFar)
+{
+    const float yScale = 1.0f / std::tan(fovY * 0.5f);
+    const float xScale = yScale / aspect;
+    const float depth = zFar / (zFar - zNear);
+
+    return { {
+        { xScale, 0, 0, 0 },
+        { 0, yScale, 0, 0 },
+        { 0, 0, depth, 1 },
+        { 0, 0, -zNear * depth, 0 }
+    } };
+}
+
+Mat4 transpose(const Mat4& m)
+{
+    Mat4 r;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            r.m[i][j] = m.m[j][i];
+        }
+    }
+    return r;
+}
+
+Mat4 inverse(const Mat4& m, float* determinant)
+{
+    const float* a = m.data();
+
+    // 2x2 sub-determinants of the bottom two rows and the top two rows
+    const float s0 = a[0] * a[5] - a[4] * a[1];
+    const float s1 = a[0] * a[6] - a[4] * a[2];
+    const float s2 = a[0] * a[7] - a[4] * a[3];
+    const float s3 = a[1] * a[6] - a[5] * a[2];
+    const float s4 = a[1] * a[7] - a[5] * a[3];
+    const float s5 = a[2] * a[7] - a[6] * a[3];
+
+    const float c5 = a[10] * a[15] - a[14] * a[11];
+    const float c4 = a[9] * a[15] - a[13] * a[11];
+    const float c3 = a[9] * a[14] - a[13] * a[10];
+    const float c2 = a[8] * a[15] - a[12] * a[11];
+    const float c1 = a[8] * a[14] - a[12] * a[10];
+    const float c0 = a[8] * a[13] - a[12] * a[9];
+
+    const float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (determinant) *determinant = det;
+    if (det == 0.0f) return Mat4::identity();
+
+    const float inv = 1.0f / det;
+    Mat4 r;
+    float* b = r.data();
+    b[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * inv;
+    b[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * inv;
+    b[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * inv;
+    b[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * inv;
+
+    b[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * inv;
+    b[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * inv;
+    b[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * inv;
+    b[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * inv;
+
+    b[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * inv;
+    b[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * inv;
+    b[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * inv;
+    b[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * inv;
+
+    b[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * inv;
+    b[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * inv;
+    b[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * inv;
+    b[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * inv;
+    return r;
+}
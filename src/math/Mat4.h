@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Simd.h"
+#include "Vec.h"
+#include "Quat.h"
+
+// Row-major 4x4 matrix for row vectors (v' = v * M), with translation in the last
+// row. This is the memory layout of D3DMATRIX, so device calls take it as is
+// (see D3DConvert.h). Products read left to right: S * R * T scales first.
+struct alignas(16) Mat4 {
+    float m[4][4];
+
+    static Mat4 identity() {
+        return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+    }
+
+    static Mat4 scaling(const Vec3& s) {
+        return { { { s.x, 0, 0, 0 }, { 0, s.y, 0, 0 }, { 0, 0, s.z, 0 }, { 0, 0, 0, 1 } } };
+    }
+
+    static Mat4 translation(const Vec3& t) {
+        return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { t.x, t.y, t.z, 1 } } };
+    }
+
+    static Mat4 rotation(const Quat& q) {
+        const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+        return { {
+            { 1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy), 0 },
+            { 2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx), 0 },
+            { 2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy), 0 },
+            { 0, 0, 0, 1 }
+        } };
+    }
+
+    static Mat4 rotationYawPitchRoll(float yaw, float pitch, float roll) {
+        return rotation(Quat::fromYawPitchRoll(yaw, pitch, roll));
+    }
+
+    // Same result as scaling(s) * rotation(r) * translation(t) without the two products
+    static Mat4 compose(const Vec3& s, const Quat& r, const Vec3& t) {
+        Mat4 result = rotation(r);
+        for (int i = 0; i < 3; ++i) {
+            result.m[0][i] *= s.x;
+            result.m[1][i] *= s.y;
+            result.m[2][i] *= s.z;
+        }
+        result.m[3][0] = t.x;
+        result.m[3][1] = t.y;
+        result.m[3][2] = t.z;
+        return result;
+    }
+
+    // Left-handed camera and projection matching the fixed-function pipeline;
+    // depth maps to [0, 1]
+    static Mat4 lookAtLH(const Vec3& eye, const Vec3& at, const Vec3& up);
+    static Mat4 perspectiveFovLH(float fovY, float aspect, float zNear, float zFar);
+
+    const float* data() const { return &m[0][0]; }
+    float* data() { return &m[0][0]; }
+
+    Vec3 getTranslation() const { return { m[3][0], m[3][1], m[3][2] }; }
+    Vec3 getRow(int i) const { return { m[i][0], m[i][1], m[i][2] }; }
+};
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b) {
+    Mat4 r;
+#if defined(ADSK_SIMD_AVX2)
+    // Two rows of a per 256-bit register, each half against the same rows of b
+    const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.m[0]));
+    const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.m[1]));
+    const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.m[2]));
+    const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b.m[3]));
+    for (int i = 0; i < 4; i += 2) {
+        const __m256 rows = _mm256_loadu_ps(a.m[i]);
+        __m256 acc = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), b0);
+        acc = simdMadd8(_mm256_shuffle_ps(rows, rows, 0x55), b1, acc);
+        acc = simdMadd8(_mm256_shuffle_ps(rows, rows, 0xAA), b2, acc);
+        acc = simdMadd8(_mm256_shuffle_ps(rows, rows, 0xFF), b3, acc);
+        _mm256_storeu_ps(r.m[i], acc);
+    }
+#else
+    const Float4 b0 = simdLoad(b.m[0]);
+    const Float4 b1 = simdLoad(b.m[1]);
+    const Float4 b2 = simdLoad(b.m[2]);
+    const Float4 b3 = simdLoad(b.m[3]);
+    for (int i = 0; i < 4; ++i) {
+        const Float4 row = simdLoad(a.m[i]);
+        Float4 acc = simdMul(simdBroadcast<0>(row), b0);
+        acc = simdMadd(simdBroadcast<1>(row), b1, acc);
+        acc = simdMadd(simdBroadcast<2>(row), b2, acc);
+        acc = simdMadd(simdBroadcast<3>(row), b3, acc);
+        simdStore(r.m[i], acc);
+    }
+#endif
+    return r;
+}
+
+inline Mat4& operator*=(Mat4& a, const Mat4& b) { return a = a * b; }
+
+inline Vec4 transform(const Vec4& v, const Mat4& m) {
+    Float4 acc = simdMul(simdSplat(v.x), simdLoad(m.m[0]));
+    acc = simdMadd(simdSplat(v.y), simdLoad(m.m[1]), acc);
+    acc = simdMadd(simdSplat(v.z), simdLoad(m.m[2]), acc);
+    acc = simdMadd(simdSplat(v.w), simdLoad(m.m[3]), acc);
+    Vec4 r;
+    simdStore(&r.x, acc);
+    return r;
+}
+
+// Point with w = 1, divided by the resulting w so projections come out in clip space
+inline Vec3 transformPoint(const Vec3& p, const Mat4& m) {
+    const Vec4 r = transform(Vec4(p, 1.0f), m);
+    return r.w != 0.0f && r.w != 1.0f ? r.xyz() / r.w : r.xyz();
+}
+
+// Direction with w = 0; ignores translation
+inline Vec3 transformNormal(const Vec3& n, const Mat4& m) {
+    return transform(Vec4(n, 0.0f), m).xyz();
+}
+
+Mat4 transpose(const Mat4& m);
+
+// General inverse; returns identity and sets *determinant to 0 when m is singular
+Mat4 inverse(const Mat4& m, float* determinant = nullptr);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Mat4.h"
+#include <cfloat>
+
+// Pixel rectangle and depth range that normalized device coordinates map onto
+struct ViewRect {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 1.0f;
+    float height = 1.0f;
+    float minZ = 0.0f;
+    float maxZ = 1.0f;
+};
+
+struct Ray {
+    Vec3 origin;
+    Vec3 direction;     // unit length
+};
+
+// World point to window coordinates; z is the depth in [minZ, maxZ]
+inline Vec3 project(const Vec3& point, const Mat4& viewProjection, const ViewRect& rect) {
+    const Vec3 ndc = transformPoint(point, viewProjection);
+    return {
+        rect.x + (1.0f + ndc.x) * rect.width * 0.5f,
+        rect.y + (1.0f - ndc.y) * rect.height * 0.5f,
+        rect.minZ + ndc.z * (rect.maxZ - rect.minZ)
+    };
+}
+
+// Window coordinates back to world space, given the inverse of view * projection
+inline Vec3 unproject(const Vec3& screen, const Mat4& inverseViewProjection, const ViewRect& rect) {
+    const Vec3 ndc(
+        (screen.x - rect.x) / rect.width * 2.0f - 1.0f,
+        1.0f - (screen.y - rect.y) / rect.height * 2.0f,
+        (screen.z - rect.minZ) / (rect.maxZ - rect.minZ));
+    return transformPoint(ndc, inverseViewProjection);
+}
+
+// Ray from the near plane through the given pixel
+inline Ray pickingRay(float screenX, float screenY, const Mat4& viewProjection, const ViewRect& rect) {
+    const Mat4 inv = inverse(viewProjection);
+    const Vec3 nearPoint = unproject({ screenX, screenY, rect.minZ }, inv, rect);
+    const Vec3 farPoint = unproject({ screenX, screenY, rect.maxZ }, inv, rect);
+    return { nearPoint, normalize(farPoint - nearPoint) };
+}
+
+// Point on the infinite line through linePoint along lineDir (unit) closest to the ray
+inline Vec3 closestPointOnLine(const Ray& ray, const Vec3& linePoint, const Vec3& lineDir) {
+    const float t = dot(linePoint - ray.origin, ray.direction);
+    const Vec3 p = ray.origin + ray.direction * t;
+    const float u = dot(p - linePoint, lineDir);
+    return linePoint + lineDir * u;
+}
+
+inline float distanceRayToLine(const Ray& ray, const Vec3& linePoint, const Vec3& lineDir) {
+    const Vec3 c = cross(ray.direction, lineDir);
+    const float denom = length(c);
+    if (denom < 1e-6f) return FLT_MAX;
+    return std::abs(dot(linePoint - ray.origin, c)) / denom;
+}
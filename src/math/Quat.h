@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Vec.h"
+
+// Unit quaternion rotation. Products read left to right like the engine's row-vector
+// matrices: a * b rotates by a first, then by b, matching Mat4::rotation(a) * Mat4::rotation(b).
+struct alignas(16) Quat {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 1.0f;
+
+    constexpr Quat() = default;
+    constexpr Quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+    static Quat fromAxisAngle(const Vec3& axis, float radians) {
+        const Vec3 n = normalize(axis);
+        const float s = std::sin(radians * 0.5f);
+        return { n.x * s, n.y * s, n.z * s, std::cos(radians * 0.5f) };
+    }
+
+    // Roll about Z, then pitch about X, then yaw about Y; the order the editor's
+    // Euler angles have always used
+    static Quat fromYawPitchRoll(float yaw, float pitch, float roll) {
+        const float sy = std::sin(yaw * 0.5f), cy = std::cos(yaw * 0.5f);
+        const float sp = std::sin(pitch * 0.5f), cp = std::cos(pitch * 0.5f);
+        const float sr = std::sin(roll * 0.5f), cr = std::cos(roll * 0.5f);
+        return {
+            cy * sp * cr + sy * cp * sr,
+            sy * cp * cr - cy * sp * sr,
+            cy * cp * sr - sy * sp * cr,
+            cy * cp * cr + sy * sp * sr
+        };
+    }
+
+    constexpr bool operator==(const Quat& o) const { return x == o.x && y == o.y && z == o.z && w == o.w; }
+    constexpr bool operator!=(const Quat& o) const { return !(*this == o); }
+};
+
+constexpr Quat operator*(const Quat& a, const Quat& b) {
+    // Hamilton product b * a, so that a is applied first
+    return {
+        b.w * a.x + b.x * a.w + b.y * a.z - b.z * a.y,
+        b.w * a.y - b.x * a.z + b.y * a.w + b.z * a.x,
+        b.w * a.z + b.x * a.y - b.y * a.x + b.z * a.w,
+        b.w * a.w - b.x * a.x - b.y * a.y - b.z * a.z
+    };
+}
+
+constexpr float dot(const Quat& a, const Quat& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+constexpr Quat conjugate(const Quat& q) { return { -q.x, -q.y, -q.z, q.w }; }
+
+inline Quat normalize(const Quat& q) {
+    const float len = std::sqrt(dot(q, q));
+    if (len <= 0.0f) return Quat();
+    const float inv = 1.0f / len;
+    return { q.x * inv, q.y * inv, q.z * inv, q.w * inv };
+}
+
+inline Vec3 rotate(const Quat& q, const Vec3& v) {
+    const Vec3 u(q.x, q.y, q.z);
+    const Vec3 t = cross(u, v) * 2.0f;
+    return v + t * q.w + cross(u, t);
+}
+
+// Shortest-arc interpolation; falls back to a normalized lerp when nearly parallel
+inline Quat slerp(const Quat& a, const Quat& b, float t) {
+    float cosTheta = dot(a, b);
+    Quat end = b;
+    if (cosTheta < 0.0f) {
+        cosTheta = -cosTheta;
+        end = { -b.x, -b.y, -b.z, -b.w };
+    }
+
+    float wa = 1.0f - t;
+    float wb = t;
+    if (cosTheta < 0.9995f) {
+        const float theta = std::acos(cosTheta);
+        const float invSin = 1.0f / std::sin(theta);
+        wa = std::sin(wa * theta) * invSin;
+        wb = std::sin(wb * theta) * invSin;
+    }
+
+    return normalize(Quat(
+        a.x * wa + end.x * wb,
+        a.y * wa + end.y * wb,
+        a.z * wa + end.z * wb,
+        a.w * wa + end.w * wb));
+}
+
+// Cheaper than slerp and close enough for small steps or when re-normalized every frame
+inline Quat nlerp(const Quat& a, const Quat& b, float t) {
+    const float sign = dot(a, b) < 0.0f ? -1.0f : 1.0f;
+    const float wa = 1.0f - t;
+    const float wb = t * sign;
+    return normalize(Quat(
+        a.x * wa + b.x * wb,
+        a.y * wa + b.y * wb,
+        a.z * wa + b.z * wb,
+        a.w * wa + b.w * wb));
+}
+
+// Inverse of Quat::fromYawPitchRoll, in radians as { yaw, pitch, roll }. Near
+// +-90 degrees pitch the roll is folded into yaw.
+inline Vec3 toYawPitchRoll(const Quat& q) {
+    const float m20 = 2.0f * (q.x * q.z + q.w * q.y);
+    const float m21 = 2.0f * (q.y * q.z - q.w * q.x);
+    const float m22 = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+    const float pitch = std::asin(std::clamp(-m21, -1.0f, 1.0f));
+
+    if (std::abs(m21) > 0.9999f) {
+        const float m00 = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
+        const float m02 = 2.0f * (q.x * q.z - q.w * q.y);
+        return { std::atan2(-m02, m00), pitch, 0.0f };
+    }
+
+    const float m01 = 2.0f * (q.x * q.y + q.w * q.z);
+    const float m11 = 1.0f - 2.0f * (q.x * q.x + q.z * q.z);
+    return { std::atan2(m20, m22), pitch, std::atan2(m01, m11) };
+}
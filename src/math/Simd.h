@@ -0,0 +1,213 @@
+#pragma once
+
+// Four-lane float register used by the math library. The backend is picked at
+// compile time: SSE on x86/x64 (with AVX2 extras when the compiler targets it),
+// NEON on ARM, plain arrays everywhere else. Fused multiply-add needs FMA on top
+// of AVX2, which GCC and Clang enable separately. Defining ADSK_MATH_SCALAR forces
+// the plain path, which is also the reference the SIMD paths are checked against.
+
+#if !defined(ADSK_MATH_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define ADSK_SIMD_SSE 1
+    #include <immintrin.h>
+    #if defined(__AVX2__)
+        #define ADSK_SIMD_AVX2 1
+    #endif
+    // MSVC has no __FMA__; its /arch:AVX2 turns FMA on too
+    #if defined(__FMA__) || (defined(__AVX2__) && defined(_MSC_VER) && !defined(__clang__))
+        #define ADSK_SIMD_FMA 1
+    #endif
+#elif !defined(ADSK_MATH_SCALAR) && (defined(__ARM_NEON) || defined(_M_ARM64))
+    #define ADSK_SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#if defined(ADSK_SIMD_SSE)
+using Float4 = __m128;
+#elif defined(ADSK_SIMD_NEON)
+using Float4 = float32x4_t;
+#else
+struct Float4 { float v[4]; };
+#endif
+
+inline Float4 simdLoad(const float* p) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_loadu_ps(p);
+#elif defined(ADSK_SIMD_NEON)
+    return vld1q_f32(p);
+#else
+    return { { p[0], p[1], p[2], p[3] } };
+#endif
+}
+
+inline void simdStore(float* p, Float4 a) {
+#if defined(ADSK_SIMD_SSE)
+    _mm_storeu_ps(p, a);
+#elif defined(ADSK_SIMD_NEON)
+    vst1q_f32(p, a);
+#else
+    for (int i = 0; i < 4; ++i) p[i] = a.v[i];
+#endif
+}
+
+inline Float4 simdSplat(float s) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_set1_ps(s);
+#elif defined(ADSK_SIMD_NEON)
+    return vdupq_n_f32(s);
+#else
+    return { { s, s, s, s } };
+#endif
+}
+
+inline Float4 simdSet(float x, float y, float z, float w) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_setr_ps(x, y, z, w);
+#elif defined(ADSK_SIMD_NEON)
+    const float values[4] = { x, y, z, w };
+    return vld1q_f32(values);
+#else
+    return { { x, y, z, w } };
+#endif
+}
+
+inline Float4 simdAdd(Float4 a, Float4 b) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_add_ps(a, b);
+#elif defined(ADSK_SIMD_NEON)
+    return vaddq_f32(a, b);
+#else
+    return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+#endif
+}
+
+inline Float4 simdSub(Float4 a, Float4 b) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_sub_ps(a, b);
+#elif defined(ADSK_SIMD_NEON)
+    return vsubq_f32(a, b);
+#else
+    return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+#endif
+}
+
+inline Float4 simdMul(Float4 a, Float4 b) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_mul_ps(a, b);
+#elif defined(ADSK_SIMD_NEON)
+    return vmulq_f32(a, b);
+#else
+    return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+#endif
+}
+
+// a * b + c
+inline Float4 simdMadd(Float4 a, Float4 b, Float4 c) {
+#if defined(ADSK_SIMD_FMA)
+    return _mm_fmadd_ps(a, b, c);
+#elif defined(ADSK_SIMD_SSE)
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#elif defined(ADSK_SIMD_NEON)
+    return vmlaq_f32(c, a, b);
+#else
+    return { { a.v[0] * b.v[0] + c.v[0], a.v[1] * b.v[1] + c.v[1], a.v[2] * b.v[2] + c.v[2], a.v[3] * b.v[3] + c.v[3] } };
+#endif
+}
+
+#if defined(ADSK_SIMD_AVX2)
+// a * b + c on eight lanes, fused where the target allows
+inline __m256 simdMadd8(__m256 a, __m256 b, __m256 c) {
+#if defined(ADSK_SIMD_FMA)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+#endif
+
+inline Float4 simdMin(Float4 a, Float4 b) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_min_ps(a, b);
+#elif defined(ADSK_SIMD_NEON)
+    return vminq_f32(a, b);
+#else
+    Float4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+    return r;
+#endif
+}
+
+inline Float4 simdMax(Float4 a, Float4 b) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_max_ps(a, b);
+#elif defined(ADSK_SIMD_NEON)
+    return vmaxq_f32(a, b);
+#else
+    Float4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+    return r;
+#endif
+}
+
+// Bit i is set when lane i of a is less than lane i of b
+inline int simdLessMask(Float4 a, Float4 b) {
+#if defined(ADSK_SIMD_SSE)
+    return _mm_movemask_ps(_mm_cmplt_ps(a, b));
+#elif defined(ADSK_SIMD_NEON)
+    const uint32x4_t m = vcltq_f32(a, b);
+    return (vgetq_lane_u32(m, 0) & 1) | (vgetq_lane_u32(m, 1) & 2) | (vgetq_lane_u32(m, 2) & 4) | (vgetq_lane_u32(m, 3) & 8);
+#else
+    int mask = 0;
+    for (int i = 0; i < 4; ++i) mask |= (a.v[i] < b.v[i]) << i;
+    return mask;
+#endif
+}
+
+// Lane-wise a < b ? x : y
+inline Float4 simdSelectLess(Float4 a, Float4 b, Float4 x, Float4 y) {
+#if defined(ADSK_SIMD_SSE)
+    const __m128 mask = _mm_cmplt_ps(a, b);
+    return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y));
+#elif defined(ADSK_SIMD_NEON)
+    return vbslq_f32(vcltq_f32(a, b), x, y);
+#else
+    Float4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = a.v[i] < b.v[i] ? x.v[i] : y.v[i];
+    return r;
+#endif
+}
+
+// Copies one lane into all four
+template<int Lane>
+inline Float4 simdBroadcast(Float4 a) {
+    static_assert(Lane >= 0 && Lane < 4, "Lane out of range");
+#if defined(ADSK_SIMD_SSE)
+    return _mm_shuffle_ps(a, a, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+#elif defined(ADSK_SIMD_NEON)
+    return vdupq_n_f32(vgetq_lane_f32(a, Lane));
+#else
+    return { { a.v[Lane], a.v[Lane], a.v[Lane], a.v[Lane] } };
+#endif
+}
+
+// Transposes the 4x4 block held in four registers
+inline void simdTranspose(Float4& a, Float4& b, Float4& c, Float4& d) {
+#if defined(ADSK_SIMD_SSE)
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+#elif defined(ADSK_SIMD_NEON)
+    const float32x4x2_t ab = vtrnq_f32(a, b);
+    const float32x4x2_t cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+#else
+    Float4* rows[4] = { &a, &b, &c, &d };
+    for (int i = 0; i < 4; ++i) {
+        for (int j = i + 1; j < 4; ++j) {
+            const float t = rows[i]->v[j];
+            rows[i]->v[j] = rows[j]->v[i];
+            rows[j]->v[i] = t;
+        }
+    }
+#endif
+}
@@ -0,0 +1,112 @@
+#include "TransformBatch.h"
+
+static inline Float4 add(Float4 a, Float4 b) { return simdAdd(a, b); }
+static inline Float4 sub(Float4 a, Float4 b) { return simdSub(a, b); }
+static inline Float4 mul(Float4 a, Float4 b) { return simdMul(a, b); }
+
+#if defined(ADSK_SIMD_AVX2)
+static inline __m256 add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+static inline __m256 sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+static inline __m256 mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+#endif
+
+// Upper 3x3 of compose(): the quaternion's rotation rows scaled per row, for
+// every lane of V at once
+template<typename V>
+static void rotationScale(V x, V y, V z, V w, V sx, V sy, V sz, V one, V two, V (&r)[3][3])
+{
+    const V x2 = mul(x, two), y2 = mul(y, two), z2 = mul(z, two);
+    const V xx = mul(x, x2), yy = mul(y, y2), zz = mul(z, z2);
+    const V xy = mul(x, y2), xz = mul(x, z2), yz = mul(y, z2);
+    const V wx = mul(w, x2), wy = mul(w, y2), wz = mul(w, z2);
+
+    r[0][0] = mul(sub(one, add(yy, zz)), sx);
+    r[0][1] = mul(add(xy, wz), sx);
+    r[0][2] = mul(sub(xz, wy), sx);
+    r[1][0] = mul(sub(xy, wz), sy);
+    r[1][1] = mul(sub(one, add(xx, zz)), sy);
+    r[1][2] = mul(add(yz, wx), sy);
+    r[2][0] = mul(add(xz, wy), sz);
+    r[2][1] = mul(sub(yz, wx), sz);
+    r[2][2] = mul(sub(one, add(xx, yy)), sz);
+}
+
+// Turns four lanes of matrix elements into four matrices and stores them
+static void storeBlock(const Float4 (&r)[3][3], const Float4 (&t)[3], const int32_t* indices, Mat4* out)
+{
+    const Float4 zero = simdSplat(0.0f);
+    const Float4 one = simdSplat(1.0f);
+
+    for (int row = 0; row < 4; ++row) {
+        Float4 a = row < 3 ? r[row][0] : t[0];
+        Float4 b = row < 3 ? r[row][1] : t[1];
+        Float4 c = row < 3 ? r[row][2] : t[2];
+        Float4 d = row < 3 ? zero : one;
+        simdTranspose(a, b, c, d);
+        simdStore(out[indices[0]].m[row], a);
+        simdStore(out[indices[1]].m[row], b);
+        simdStore(out[indices[2]].m[row], c);
+        simdStore(out[indices[3]].m[row], d);
+    }
+}
+
+static void composeBlock4(const TransformSoA& soa, const int32_t* indices, Mat4* out)
+{
+    auto gather = [indices](const float* values) {
+        return simdSet(values[indices[0]], values[indices[1]], values[indices[2]], values[indices[3]]);
+    };
+
+    Float4 r[3][3];
+    rotationScale(gather(soa.rotationX), gather(soa.rotationY), gather(soa.rotationZ), gather(soa.rotationW),
+        gather(soa.scaleX), gather(soa.scaleY), gather(soa.scaleZ), simdSplat(1.0f), simdSplat(2.0f), r);
+
+    const Float4 t[3] = { gather(soa.positionX), gather(soa.positionY), gather(soa.positionZ) };
+    storeBlock(r, t, indices, out);
+}
+
+#if defined(ADSK_SIMD_AVX2)
+static void composeBlock8(const TransformSoA& soa, const int32_t* indices, Mat4* out)
+{
+    const __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+    auto gather = [lanes](const float* values) { return _mm256_i32gather_ps(values, lanes, 4); };
+
+    __m256 r[3][3];
+    rotationScale(gather(soa.rotationX), gather(soa.rotationY), gather(soa.rotationZ), gather(soa.rotationW),
+        gather(soa.scaleX), gather(soa.scaleY), gather(soa.scaleZ), _mm256_set1_ps(1.0f), _mm256_set1_ps(2.0f), r);
+    const __m256 t[3] = { gather(soa.positionX), gather(soa.positionY), gather(soa.positionZ) };
+
+    // Two 4-wide halves share the transpose and store of the narrow path
+    Float4 lowR[3][3], highR[3][3], lowT[3], highT[3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            lowR[i][j] = _mm256_castps256_ps128(r[i][j]);
+            highR[i][j] = _mm256_extractf128_ps(r[i][j], 1);
+        }
+        lowT[i] = _mm256_castps256_ps128(t[i]);
+        highT[i] = _mm256_extractf128_ps(t[i], 1);
+    }
+    storeBlock(lowR, lowT, indices, out);
+    storeBlock(highR, highT, indices + 4, out);
+}
+#endif
+
+void composeTransforms(const TransformSoA& soa, const int32_t* indices, size_t count, Mat4* out)
+{
+    size_t k = 0;
+#if defined(ADSK_SIMD_AVX2)
+    for (; k + 8 <= count; k += 8) {
+        composeBlock8(soa, indices + k, out);
+    }
+#endif
+    for (; k + 4 <= count; k += 4) {
+        composeBlock4(soa, indices + k, out);
+    }
+
+    for (; k < count; ++k) {
+        const int32_t i = indices[k];
+        out[i] = Mat4::compose(
+            { soa.scaleX[i], soa.scaleY[i], soa.scaleZ[i] },
+            { soa.rotationX[i], soa.rotationY[i], soa.rotationZ[i], soa.rotationW[i] },
+            { soa.positionX[i], soa.positionY[i], soa.positionZ[i] });
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Mat4.h"
+#include <cstddef>
+#include <cstdint>
+
+// Local position, rotation and scale in structure-of-arrays form; element i of
+// every array belongs to the same transform. Rotations are unit quaternions.
+struct TransformSoA {
+    const float* positionX;
+    const float* positionY;
+    const float* positionZ;
+    const float* rotationX;
+    const float* rotationY;
+    const float* rotationZ;
+    const float* rotationW;
+    const float* scaleX;
+    const float* scaleY;
+    const float* scaleZ;
+};
+
+// Writes Mat4::compose(scale, rotation, position) of element indices[k] to
+// out[indices[k]] for every k < count. Works 8 transforms at a time with AVX2
+// and 4 at a time with SSE or NEON. Indices must be unique, so disjoint ranges
+// of one index list can run on different threads.
+void composeTransforms(const TransformSoA& soa, const int32_t* indices, size_t count, Mat4* out);
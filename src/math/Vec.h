@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+constexpr float Pi = 3.14159265358979323846f;
+
+constexpr float toRadians(float degrees) { return degrees * (Pi / 180.0f); }
+constexpr float toDegrees(float radians) { return radians * (180.0f / Pi); }
+
+// Three-component vector for positions, directions and extents. Twelve bytes with
+// no padding, so arrays of it stay tightly packed; the operations are scalar and
+// left for the compiler to keep in registers.
+struct Vec3 {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+
+    constexpr Vec3() = default;
+    constexpr Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+    constexpr Vec3 operator+(const Vec3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+    constexpr Vec3 operator-(const Vec3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+    constexpr Vec3 operator*(float s) const { return { x * s, y * s, z * s }; }
+    constexpr Vec3 operator/(float s) const { return { x / s, y / s, z / s }; }
+    constexpr Vec3 operator-() const { return { -x, -y, -z }; }
+
+    Vec3& operator+=(const Vec3& o) { x += o.x; y += o.y; z += o.z; return *this; }
+    Vec3& operator-=(const Vec3& o) { x -= o.x; y -= o.y; z -= o.z; return *this; }
+    Vec3& operator*=(float s) { x *= s; y *= s; z *= s; return *this; }
+    Vec3& operator/=(float s) { x /= s; y /= s; z /= s; return *this; }
+
+    constexpr bool operator==(const Vec3& o) const { return x == o.x && y == o.y && z == o.z; }
+    constexpr bool operator!=(const Vec3& o) const { return !(*this == o); }
+
+    float& operator[](int i) { return (&x)[i]; }
+    float operator[](int i) const { return (&x)[i]; }
+};
+
+constexpr Vec3 operator*(float s, const Vec3& v) { return v * s; }
+
+constexpr float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+constexpr Vec3 cross(const Vec3& a, const Vec3& b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+constexpr Vec3 mul(const Vec3& a, const Vec3& b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+
+inline float lengthSq(const Vec3& v) { return dot(v, v); }
+inline float length(const Vec3& v) { return std::sqrt(dot(v, v)); }
+
+// Zero vectors stay zero instead of turning into NaNs
+inline Vec3 normalize(const Vec3& v) {
+    const float len = length(v);
+    return len > 0.0f ? v / len : v;
+}
+
+inline Vec3 componentMin(const Vec3& a, const Vec3& b) { return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) }; }
+inline Vec3 componentMax(const Vec3& a, const Vec3& b) { return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+inline Vec3 clamp(const Vec3& v, const Vec3& lo, const Vec3& hi) { return componentMin(componentMax(v, lo), hi); }
+constexpr Vec3 lerp(const Vec3& a, const Vec3& b, float t) { return a + (b - a) * t; }
+
+// Homogeneous vector; 16-byte aligned so it loads straight into a SIMD register
+struct alignas(16) Vec4 {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 0.0f;
+
+    constexpr Vec4() = default;
+    constexpr Vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+    constexpr Vec4(const Vec3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    constexpr Vec3 xyz() const { return { x, y, z }; }
+};
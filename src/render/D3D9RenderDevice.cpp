@@ -0,0 +1,640 @@
+#include "D3D9RenderDevice.h"
+#include "D3DConvert.h"
+#include "ConsolePanel.h"
+#include <d3dx9.h>
+#include <cstring>
+#include <cmath>
+
+// Only called for fixed-function layouts; instance data is only read through a declaration
+static DWORD toFvf(const VertexLayout& layout)
+{
+    DWORD fvf = 0;
+    if (layout.has(VertexAttribute::Position)) fvf |= D3DFVF_XYZ;
+    if (layout.has(VertexAttribute::Normal)) fvf |= D3DFVF_NORMAL;
+    if (layout.has(VertexAttribute::Color)) fvf |= D3DFVF_DIFFUSE;
+    if (layout.has(VertexAttribute::TexCoord)) fvf |= D3DFVF_TEX1;
+    return fvf;
+}
+
+static BYTE toDeclType(VertexElementFormat format)
+{
+    switch (format) {
+    case VertexElementFormat::Float2: return D3DDECLTYPE_FLOAT2;
+    case VertexElementFormat::Float3: return D3DDECLTYPE_FLOAT3;
+    case VertexElementFormat::Half2: return D3DDECLTYPE_FLOAT16_2;
+    case VertexElementFormat::Short4N: return D3DDECLTYPE_SHORT4N;
+    case VertexElementFormat::Octahedral: return D3DDECLTYPE_SHORT2N;
+    case VertexElementFormat::Color: return D3DDECLTYPE_D3DCOLOR;
+    default: return D3DDECLTYPE_FLOAT4;
+    }
+}
+
+static constexpr DWORD MaxShaderLights = 8;
+static constexpr UINT ShaderConstantCount = 53;
+
+// Registers: c0-c3 view * projection, c4 ambient term, c5 flags, five per light
+// from c6, c46-c49 the world matrix of a single draw, c50-c51 position scale and
+// bias, c52 the material diffuse (see uploadShaderConstants). Compiled twice, with
+// INSTANCED taking the world matrix from the instance stream.
+static const char meshShader[] = R"(
+row_major float4x4 viewProj : register(c0);
+float4 ambient : register(c4);
+float4 flags : register(c5);
+float4 lights[40] : register(c6);
+row_major float4x4 objectWorld : register(c46);
+float4 positionScale : register(c50);
+float4 positionBias : register(c51);
+float4 materialDiffuse : register(c52);
+
+struct VertexInput {
+    float4 position : POSITION;
+    float4 normal : NORMAL;
+    float4 color : COLOR0;
+#ifdef INSTANCED
+    float4 world0 : TEXCOORD1;
+    float4 world1 : TEXCOORD2;
+    float4 world2 : TEXCOORD3;
+    float4 world3 : TEXCOORD4;
+#endif
+};
+
+struct VertexOutput {
+    float4 position : POSITION;
+    float4 color : COLOR0;
+};
+
+float3 decodeOctahedral(float2 e)
+{
+    float3 n = float3(e, 1 - abs(e.x) - abs(e.y));
+    if (n.z < 0) n.xy = (1 - abs(n.yx)) * (n.xy >= 0 ? 1 : -1);
+    return normalize(n);
+}
+
+VertexOutput vsMain(VertexInput input)
+{
+#ifdef INSTANCED
+    float4x4 world = float4x4(input.world0, input.world1, input.world2, input.world3);
+#else
+    float4x4 world = objectWorld;
+#endif
+    float3 position = input.position.xyz * positionScale.xyz + positionBias.xyz;
+    float3 localNormal = flags.y > 0 ? decodeOctahedral(input.normal.xy) : input.normal.xyz;
+    float4 baseColor = flags.z > 0 ? input.color : materialDiffuse;
+
+    float4 worldPos = mul(float4(position, 1), world);
+    float3 normal = normalize(mul(localNormal, (float3x3)world));
+
+    float3 diffuse = 0;
+    for (int i = 0; i < 8; ++i) {
+        float4 position = lights[i * 5];
+        float4 direction = lights[i * 5 + 1];
+        float4 color = lights[i * 5 + 2];
+        float4 attenuation = lights[i * 5 + 3];
+        float4 cone = lights[i * 5 + 4];
+
+        float3 toLight = -direction.xyz;
+        float strength = 1;
+        if (position.w > 0) {
+            float3 offset = position.xyz - worldPos.xyz;
+            float distance = length(offset);
+            toLight = offset / max(distance, 1e-5);
+            strength = distance <= direction.w
+                ? 1 / (attenuation.x + attenuation.y * distance + attenuation.z * distance * distance) : 0;
+            if (position.w > 1) {
+                float rho = dot(-toLight, direction.xyz);
+                float t = saturate((rho - cone.y) / max(cone.x - cone.y, 1e-5));
+                strength *= pow(max(t, 1e-5), attenuation.w);
+            }
+        }
+        diffuse += color.rgb * saturate(dot(normal, toLight)) * strength;
+    }
+
+    VertexOutput output;
+    output.position = mul(worldPos, viewProj);
+    output.color = flags.x > 0
+        ? float4(saturate(baseColor.rgb * diffuse + ambient.rgb), baseColor.a)
+        : baseColor;
+    return output;
+}
+
+float4 psMain(float4 color : COLOR0) : COLOR0
+{
+    return color;
+}
+)";
+
+static D3DTRANSFORMSTATETYPE toD3D(TransformSlot slot)
+{
+    switch (slot) {
+    case TransformSlot::View: return D3DTS_VIEW;
+    case TransformSlot::Projection: return D3DTS_PROJECTION;
+    default: return D3DTS_WORLD;
+    }
+}
+
+static D3DPRIMITIVETYPE toD3D(PrimitiveType type)
+{
+    return type == PrimitiveType::LineList ? D3DPT_LINELIST : D3DPT_TRIANGLELIST;
+}
+
+static D3DRENDERSTATETYPE toD3D(RenderState state)
+{
+    switch (state) {
+    case RenderState::DepthTest: return D3DRS_ZENABLE;
+    case RenderState::DepthFunc: return D3DRS_ZFUNC;
+    case RenderState::Cull: return D3DRS_CULLMODE;
+    case RenderState::Lighting: return D3DRS_LIGHTING;
+    default: return D3DRS_AMBIENT;
+    }
+}
+
+static D3DCOLORVALUE toD3D(const Color& c)
+{
+    return { c.r, c.g, c.b, c.a };
+}
+
+D3D9RenderDevice::D3D9RenderDevice(IDirect3DDevice9* device)
+    : device(device)
+{
+    D3DCAPS9 caps;
+    if (SUCCEEDED(device->GetDeviceCaps(&caps))) {
+        index32 = caps.MaxVertexIndex > 0xFFFF;
+        declTypes = caps.DeclTypes;
+        initShaders(caps);
+    }
+}
+
+D3D9RenderDevice::~D3D9RenderDevice()
+{
+    for (const Declaration& entry : declarations) {
+        if (entry.declaration) entry.declaration->Release();
+    }
+    if (meshVertexShader) meshVertexShader->Release();
+    if (instanceVertexShader) instanceVertexShader->Release();
+    if (pixelShader) pixelShader->Release();
+
+    for (Buffer& buffer : buffers) {
+        if (buffer.vertices) buffer.vertices->Release();
+        if (buffer.indices) buffer.indices->Release();
+    }
+    for (IDirect3DTexture9* texture : textures) {
+        if (texture) texture->Release();
+    }
+}
+
+uint32_t D3D9RenderDevice::allocateBuffer()
+{
+    if (!freeBuffers.empty()) {
+        const uint32_t handle = freeBuffers.back();
+        freeBuffers.pop_back();
+        return handle;
+    }
+    buffers.push_back({});
+    return static_cast<uint32_t>(buffers.size());
+}
+
+uint32_t D3D9RenderDevice::allocateTexture()
+{
+    if (!freeTextures.empty()) {
+        const uint32_t handle = freeTextures.back();
+        freeTextures.pop_back();
+        return handle;
+    }
+    textures.push_back(nullptr);
+    return static_cast<uint32_t>(textures.size());
+}
+
+BufferHandle D3D9RenderDevice::createVertexBuffer(const void* data, uint32_t size, const VertexLayout& layout)
+{
+    const DWORD fvf = layout.isFixedFunction() ? toFvf(layout) : 0;
+
+    IDirect3DVertexBuffer9* vb = nullptr;
+    if (FAILED(device->CreateVertexBuffer(size, D3DUSAGE_WRITEONLY, fvf, D3DPOOL_MANAGED, &vb, nullptr))) {
+        ConsolePanel::sError("Failed to create vertex buffer");
+        return NullHandle;
+    }
+
+    void* ptr = nullptr;
+    if (FAILED(vb->Lock(0, 0, &ptr, 0))) {
+        ConsolePanel::sError("Failed to lock vertex buffer");
+        vb->Release();
+        return NullHandle;
+    }
+    if (data) std::memcpy(ptr, data, size);
+    vb->Unlock();
+
+    const uint32_t handle = allocateBuffer();
+    buffers[handle - 1] = { vb, nullptr, layout };
+    return handle;
+}
+
+BufferHandle D3D9RenderDevice::createIndexBuffer(const void* data, uint32_t size, IndexFormat format)
+{
+    const D3DFORMAT d3dFormat = format == IndexFormat::Index32 ? D3DFMT_INDEX32 : D3DFMT_INDEX16;
+
+    IDirect3DIndexBuffer9* ib = nullptr;
+    if (FAILED(device->CreateIndexBuffer(size, D3DUSAGE_WRITEONLY, d3dFormat, D3DPOOL_MANAGED, &ib, nullptr))) {
+        ConsolePanel::sError("Failed to create index buffer");
+        return NullHandle;
+    }
+
+    void* ptr = nullptr;
+    if (FAILED(ib->Lock(0, 0, &ptr, 0))) {
+        ConsolePanel::sError("Failed to lock index buffer");
+        ib->Release();
+        return NullHandle;
+    }
+    if (data) std::memcpy(ptr, data, size);
+    ib->Unlock();
+
+    const uint32_t handle = allocateBuffer();
+    buffers[handle - 1] = { nullptr, ib, VertexLayout() };
+    return handle;
+}
+
+bool D3D9RenderDevice::updateVertexBuffer(BufferHandle handle, const void* data, uint32_t size)
+{
+    if (handle == NullHandle || handle > buffers.size() || !buffers[handle - 1].vertices) return false;
+
+    void* ptr = nullptr;
+    IDirect3DVertexBuffer9* vb = buffers[handle - 1].vertices;
+    if (FAILED(vb->Lock(0, size, &ptr, 0))) return false;
+    std::memcpy(ptr, data, size);
+    vb->Unlock();
+    return true;
+}
+
+void D3D9RenderDevice::destroyBuffer(BufferHandle handle)
+{
+    if (handle == NullHandle || handle > buffers.size()) return;
+
+    Buffer& buffer = buffers[handle - 1];
+    if (buffer.vertices) buffer.vertices->Release();
+    if (buffer.indices) buffer.indices->Release();
+    buffer = Buffer();
+    freeBuffers.push_back(handle);
+    if (boundVertices == handle) boundVertices = NullHandle;
+}
+
+bool D3D9RenderDevice::supportsVertexFormat(VertexElementFormat format) const
+{
+    switch (format) {
+    case VertexElementFormat::Half2: return shaders && (declTypes & D3DDTCAPS_FLOAT16_2);
+    case VertexElementFormat::Short4N: return shaders && (declTypes & D3DDTCAPS_SHORT4N);
+    case VertexElementFormat::Octahedral: return shaders && (declTypes & D3DDTCAPS_SHORT2N);
+    default: return true;
+    }
+}
+
+TextureHandle D3D9RenderDevice::createTextureFromFile(const char* path)
+{
+    IDirect3DTexture9* texture = nullptr;
+    if (FAILED(D3DXCreateTextureFromFileA(device, path, &texture))) {
+        return NullHandle;
+    }
+
+    const uint32_t handle = allocateTexture();
+    textures[handle - 1] = texture;
+    return handle;
+}
+
+TextureHandle D3D9RenderDevice::createSolidTexture(uint32_t width, uint32_t height, uint32_t argb)
+{
+    IDirect3DTexture9* texture = nullptr;
+    if (FAILED(device->CreateTexture(width, height, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &texture, nullptr))) {
+        ConsolePanel::sError("Failed to create texture");
+        return NullHandle;
+    }
+
+    D3DLOCKED_RECT rect;
+    if (SUCCEEDED(texture->LockRect(0, &rect, nullptr, 0))) {
+        for (uint32_t y = 0; y < height; ++y) {
+            uint32_t* row = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(rect.pBits) + y * rect.Pitch);
+            std::fill(row, row + width, argb);
+        }
+        texture->UnlockRect(0);
+    }
+
+    const uint32_t handle = allocateTexture();
+    textures[handle - 1] = texture;
+    return handle;
+}
+
+void D3D9RenderDevice::destroyTexture(TextureHandle handle)
+{
+    if (handle == NullHandle || handle > textures.size()) return;
+
+    if (textures[handle - 1]) textures[handle - 1]->Release();
+    textures[handle - 1] = nullptr;
+    freeTextures.push_back(handle);
+}
+
+void D3D9RenderDevice::setTransform(TransformSlot slot, const Mat4& matrix)
+{
+    device->SetTransform(toD3D(slot), toD3D(matrix));
+}
+
+Mat4 D3D9RenderDevice::getTransform(TransformSlot slot) const
+{
+    D3DMATRIX matrix;
+    device->GetTransform(toD3D(slot), &matrix);
+    return fromD3D(matrix);
+}
+
+void D3D9RenderDevice::setRenderState(RenderState state, uint32_t value)
+{
+    DWORD d3dValue = value;
+    if (state == RenderState::DepthFunc) {
+        const CompareFunc func = static_cast<CompareFunc>(value);
+        d3dValue = func == CompareFunc::Less ? D3DCMP_LESS : func == CompareFunc::Always ? D3DCMP_ALWAYS : D3DCMP_LESSEQUAL;
+    }
+    else if (state == RenderState::Cull) {
+        const CullMode mode = static_cast<CullMode>(value);
+        d3dValue = mode == CullMode::None ? D3DCULL_NONE : mode == CullMode::Clockwise ? D3DCULL_CW : D3DCULL_CCW;
+    }
+    device->SetRenderState(toD3D(state), d3dValue);
+}
+
+uint32_t D3D9RenderDevice::getRenderState(RenderState state) const
+{
+    DWORD value = 0;
+    device->GetRenderState(toD3D(state), &value);
+
+    if (state == RenderState::DepthFunc) {
+        if (value == D3DCMP_LESS) return static_cast<uint32_t>(CompareFunc::Less);
+        if (value == D3DCMP_ALWAYS) return static_cast<uint32_t>(CompareFunc::Always);
+        return static_cast<uint32_t>(CompareFunc::LessEqual);
+    }
+    if (state == RenderState::Cull) {
+        if (value == D3DCULL_NONE) return static_cast<uint32_t>(CullMode::None);
+        if (value == D3DCULL_CW) return static_cast<uint32_t>(CullMode::Clockwise);
+        return static_cast<uint32_t>(CullMode::CounterClockwise);
+    }
+    return value;
+}
+
+void D3D9RenderDevice::setMaterial(const Material& material)
+{
+    D3DMATERIAL9 m;
+    ZeroMemory(&m, sizeof(m));
+    m.Diffuse = toD3D(material.diffuse);
+    m.Ambient = toD3D(material.ambient);
+    device->SetMaterial(&m);
+}
+
+void D3D9RenderDevice::setLight(uint32_t index, const LightDesc& light)
+{
+    D3DLIGHT9 L{};
+    L.Type = light.kind == LightKind::Directional ? D3DLIGHT_DIRECTIONAL
+        : light.kind == LightKind::Point ? D3DLIGHT_POINT : D3DLIGHT_SPOT;
+    L.Diffuse = toD3D(light.diffuse);
+    L.Position = toD3D(light.position);
+    L.Direction = toD3D(light.direction);
+    L.Range = light.range;
+    L.Attenuation0 = light.attenuation[0];
+    L.Attenuation1 = light.attenuation[1];
+    L.Attenuation2 = light.attenuation[2];
+    L.Theta = light.innerAngle;
+    L.Phi = light.outerAngle;
+    L.Falloff = light.falloff;
+    device->SetLight(index, &L);
+}
+
+void D3D9RenderDevice::enableLight(uint32_t index, bool enabled)
+{
+    device->LightEnable(index, enabled ? TRUE : FALSE);
+}
+
+void D3D9RenderDevice::setVertexBuffer(BufferHandle handle)
+{
+    if (handle == NullHandle || handle > buffers.size() || !buffers[handle - 1].vertices) {
+        device->SetStreamSource(0, nullptr, 0, 0);
+        boundVertices = NullHandle;
+        return;
+    }
+
+    const Buffer& buffer = buffers[handle - 1];
+    device->SetStreamSource(0, buffer.vertices, 0, buffer.layout.stride);
+    bindVertexInput(buffer.layout);
+    boundVertices = handle;
+}
+
+void D3D9RenderDevice::bindVertexInput(const VertexLayout& layout)
+{
+    if (layout.isFixedFunction()) device->SetFVF(toFvf(layout));
+    else device->SetVertexDeclaration(getDeclaration(layout, false));
+}
+
+void D3D9RenderDevice::setIndexBuffer(BufferHandle handle)
+{
+    const bool valid = handle != NullHandle && handle <= buffers.size();
+    device->SetIndices(valid ? buffers[handle - 1].indices : nullptr);
+}
+
+void D3D9RenderDevice::setTexture(uint32_t stage, TextureHandle handle)
+{
+    const bool valid = handle != NullHandle && handle <= textures.size();
+    device->SetTexture(stage, valid ? textures[handle - 1] : nullptr);
+}
+
+void D3D9RenderDevice::draw(PrimitiveType type, uint32_t startVertex, uint32_t primitiveCount)
+{
+    device->DrawPrimitive(toD3D(type), startVertex, primitiveCount);
+}
+
+void D3D9RenderDevice::drawIndexed(PrimitiveType type, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount)
+{
+    // Quantized vertices only draw through the shader that decodes them
+    const VertexLayout* layout = boundVertices != NullHandle ? &buffers[boundVertices - 1].layout : nullptr;
+    if (!layout || layout->isFixedFunction()) {
+        device->DrawIndexedPrimitive(toD3D(type), baseVertex, 0, vertexCount, startIndex, primitiveCount);
+        return;
+    }
+    if (!shaders) return;
+
+    beginShaderDraw(*layout, false);
+    device->DrawIndexedPrimitive(toD3D(type), baseVertex, 0, vertexCount, startIndex, primitiveCount);
+    endShaderDraw(*layout);
+}
+
+void D3D9RenderDevice::drawIndexedInstanced(PrimitiveType type, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount,
+    BufferHandle instances, uint32_t firstInstance, uint32_t instanceCount)
+{
+    if (!shaders || instances == NullHandle || instances > buffers.size() || !buffers[instances - 1].vertices) return;
+    if (boundVertices == NullHandle) return;
+
+    const VertexLayout& layout = buffers[boundVertices - 1].layout;
+    beginShaderDraw(layout, true);
+
+    device->SetStreamSourceFreq(0, D3DSTREAMSOURCE_INDEXEDDATA | instanceCount);
+    device->SetStreamSource(1, buffers[instances - 1].vertices, firstInstance * sizeof(Mat4), sizeof(Mat4));
+    device->SetStreamSourceFreq(1, D3DSTREAMSOURCE_INSTANCEDATA | 1u);
+
+    device->DrawIndexedPrimitive(toD3D(type), baseVertex, 0, vertexCount, startIndex, primitiveCount);
+
+    // Back to plain fixed-function drawing of the mesh stream
+    device->SetStreamSourceFreq(0, 1);
+    device->SetStreamSourceFreq(1, 1);
+    device->SetStreamSource(1, nullptr, 0, 0);
+    endShaderDraw(layout);
+}
+
+void D3D9RenderDevice::initShaders(const D3DCAPS9& caps)
+{
+    if (caps.VertexShaderVersion < D3DVS_VERSION(3, 0)
+        || caps.PixelShaderVersion < D3DPS_VERSION(3, 0)) {
+        ConsolePanel::sInfo("Shader model 3 unavailable, drawing objects one by one with full-size vertices");
+        return;
+    }
+
+    ID3DXBuffer* code = nullptr;
+    ID3DXBuffer* errors = nullptr;
+    auto compile = [&](const char* entry, const char* profile, bool instanced) {
+        if (code) { code->Release(); code = nullptr; }
+        const D3DXMACRO defines[] = { { "INSTANCED", "1" }, { nullptr, nullptr } };
+        if (FAILED(D3DXCompileShader(meshShader, sizeof(meshShader) - 1, instanced ? defines : nullptr, nullptr,
+            entry, profile, 0, &code, &errors, nullptr))) {
+            ConsolePanel::sWarning(QString("Mesh shader: %1")
+                .arg(errors ? static_cast<const char*>(errors->GetBufferPointer()) : "compile failed"));
+            if (errors) { errors->Release(); errors = nullptr; }
+            return false;
+        }
+        return true;
+    };
+
+    const bool created = compile("vsMain", "vs_3_0", false)
+        && SUCCEEDED(device->CreateVertexShader(static_cast<const DWORD*>(code->GetBufferPointer()), &meshVertexShader))
+        && compile("vsMain", "vs_3_0", true)
+        && SUCCEEDED(device->CreateVertexShader(static_cast<const DWORD*>(code->GetBufferPointer()), &instanceVertexShader))
+        && compile("psMain", "ps_3_0", false)
+        && SUCCEEDED(device->CreatePixelShader(static_cast<const DWORD*>(code->GetBufferPointer()), &pixelShader));
+    if (code) code->Release();
+
+    shaders = created;
+}
+
+// Stream 0 holds the layout's elements; instanced declarations add one world
+// matrix per instance from stream 1, as TEXCOORD1-4. A failed declaration is
+// cached as null too, so it is reported once.
+IDirect3DVertexDeclaration9* D3D9RenderDevice::getDeclaration(const VertexLayout& layout, bool instanced)
+{
+    const uint32_t key = layout.key();
+    for (const Declaration& entry : declarations) {
+        if (entry.key == key && entry.instanced == instanced) return entry.declaration;
+    }
+
+    static const BYTE usages[] = { D3DDECLUSAGE_POSITION, D3DDECLUSAGE_NORMAL, D3DDECLUSAGE_COLOR, D3DDECLUSAGE_TEXCOORD };
+
+    D3DVERTEXELEMENT9 elements[9];
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        const VertexElementFormat format = layout.formats[i];
+        if (format == VertexElementFormat::None) continue;
+        elements[count++] = { 0, static_cast<WORD>(layout.offsets[i]), toDeclType(format), D3DDECLMETHOD_DEFAULT, usages[i], 0 };
+    }
+    if (instanced) {
+        for (int row = 0; row < 4; ++row) {
+            elements[count++] = { 1, static_cast<WORD>(row * 16), D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT,
+                D3DDECLUSAGE_TEXCOORD, static_cast<BYTE>(row + 1) };
+        }
+    }
+    elements[count] = D3DDECL_END();
+
+    IDirect3DVertexDeclaration9* declaration = nullptr;
+    if (FAILED(device->CreateVertexDeclaration(elements, &declaration))) {
+        ConsolePanel::sWarning("Failed to create vertex declaration");
+        declaration = nullptr;
+    }
+    declarations.push_back({ key, instanced, declaration });
+    return declaration;
+}
+
+void D3D9RenderDevice::beginShaderDraw(const VertexLayout& layout, bool instanced)
+{
+    uploadShaderConstants(layout);
+    device->SetVertexDeclaration(getDeclaration(layout, instanced));
+    device->SetVertexShader(instanced ? instanceVertexShader : meshVertexShader);
+    device->SetPixelShader(pixelShader);
+}
+
+// Leaves the bound vertex buffer readable by whoever draws next, shader or not
+void D3D9RenderDevice::endShaderDraw(const VertexLayout& layout)
+{
+    device->SetVertexShader(nullptr);
+    device->SetPixelShader(nullptr);
+    bindVertexInput(layout);
+}
+
+// Mirrors what fixed function would use: view * projection, the material's
+// ambient times the ambient render state, and the first MaxShaderLights lights.
+// Per light: position and kind, direction and range, diffuse, attenuation and
+// falloff, cosines of the half cone angles. Disabled lights upload as zero.
+// The flags say whether lighting is on, normals are octahedral and the vertices
+// carry a color; without one the material diffuse stands in, as in fixed function.
+void D3D9RenderDevice::uploadShaderConstants(const VertexLayout& layout)
+{
+    float constants[ShaderConstantCount][4] = {};
+
+    D3DMATRIX view, projection;
+    device->GetTransform(D3DTS_VIEW, &view);
+    device->GetTransform(D3DTS_PROJECTION, &projection);
+    const Mat4 viewProj = fromD3D(view) * fromD3D(projection);
+    std::memcpy(constants[0], &viewProj, sizeof(Mat4));
+
+    D3DMATERIAL9 material;
+    DWORD ambient = 0;
+    DWORD lighting = 0;
+    device->GetMaterial(&material);
+    device->GetRenderState(D3DRS_AMBIENT, &ambient);
+    device->GetRenderState(D3DRS_LIGHTING, &lighting);
+
+    constants[4][0] = material.Ambient.r * ((ambient >> 16) & 0xFF) / 255.0f;
+    constants[4][1] = material.Ambient.g * ((ambient >> 8) & 0xFF) / 255.0f;
+    constants[4][2] = material.Ambient.b * (ambient & 0xFF) / 255.0f;
+    constants[5][0] = lighting ? 1.0f : 0.0f;
+    constants[5][1] = layout.format(VertexAttribute::Normal) == VertexElementFormat::Octahedral ? 1.0f : 0.0f;
+    constants[5][2] = layout.has(VertexAttribute::Color) ? 1.0f : 0.0f;
+
+    for (DWORD i = 0; i < MaxShaderLights; ++i) {
+        BOOL enabled = FALSE;
+        D3DLIGHT9 light;
+        if (FAILED(device->GetLightEnable(i, &enabled)) || !enabled) continue;
+        if (FAILED(device->GetLight(i, &light))) continue;
+
+        float (*c)[4] = constants + 6 + i * 5;
+        const Vec3 direction = normalize(Vec3(light.Direction.x, light.Direction.y, light.Direction.z));
+        c[0][0] = light.Position.x;
+        c[0][1] = light.Position.y;
+        c[0][2] = light.Position.z;
+        c[0][3] = light.Type == D3DLIGHT_DIRECTIONAL ? 0.0f : light.Type == D3DLIGHT_POINT ? 1.0f : 2.0f;
+        c[1][0] = direction.x;
+        c[1][1] = direction.y;
+        c[1][2] = direction.z;
+        c[1][3] = light.Range;
+        c[2][0] = light.Diffuse.r;
+        c[2][1] = light.Diffuse.g;
+        c[2][2] = light.Diffuse.b;
+        c[2][3] = light.Diffuse.a;
+        c[3][0] = light.Attenuation0;
+        c[3][1] = light.Attenuation1;
+        c[3][2] = light.Attenuation2;
+        c[3][3] = light.Falloff;
+        c[4][0] = std::cos(light.Theta * 0.5f);
+        c[4][1] = std::cos(light.Phi * 0.5f);
+    }
+
+    D3DMATRIX world;
+    device->GetTransform(D3DTS_WORLD, &world);
+    std::memcpy(constants[46], &world, sizeof(D3DMATRIX));
+
+    for (int i = 0; i < 3; ++i) {
+        constants[50][i] = layout.positionScale[i];
+        constants[51][i] = layout.positionBias[i];
+    }
+    constants[52][0] = material.Diffuse.r;
+    constants[52][1] = material.Diffuse.g;
+    constants[52][2] = material.Diffuse.b;
+    constants[52][3] = material.Diffuse.a;
+
+    device->SetVertexShaderConstantF(0, constants[0], ShaderConstantCount);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include <d3d9.h>
+#include <vector>
+
+// RenderDevice on top of an existing Direct3D 9 device. It adds no state caching,
+// so code that still talks to the device directly (the viewport's gizmo and frame
+// setup) stays in step with it. Resources are created in the managed pool and
+// survive Reset(); everything still alive is released with the wrapper.
+// Instancing and quantized vertex formats need shader model 3. Their shader
+// reproduces the fixed-function diffuse lighting from the device's own lights
+// and material, and decodes whatever layout the bound vertex buffer has.
+class D3D9RenderDevice : public RenderDevice {
+public:
+    explicit D3D9RenderDevice(IDirect3DDevice9* device);
+    ~D3D9RenderDevice() override;
+
+    D3D9RenderDevice(const D3D9RenderDevice&) = delete;
+    D3D9RenderDevice& operator=(const D3D9RenderDevice&) = delete;
+
+    IDirect3DDevice9* getDevice() const { return device; }
+
+    BufferHandle createVertexBuffer(const void* data, uint32_t size, const VertexLayout& layout) override;
+    BufferHandle createIndexBuffer(const void* data, uint32_t size, IndexFormat format) override;
+    bool updateVertexBuffer(BufferHandle buffer, const void* data, uint32_t size) override;
+    void destroyBuffer(BufferHandle buffer) override;
+    bool supportsVertexFormat(VertexElementFormat format) const override;
+
+    TextureHandle createTextureFromFile(const char* path) override;
+    TextureHandle createSolidTexture(uint32_t width, uint32_t height, uint32_t argb) override;
+    void destroyTexture(TextureHandle texture) override;
+
+    void setTransform(TransformSlot slot, const Mat4& matrix) override;
+    Mat4 getTransform(TransformSlot slot) const override;
+    void setRenderState(RenderState state, uint32_t value) override;
+    uint32_t getRenderState(RenderState state) const override;
+    void setMaterial(const Material& material) override;
+    void setLight(uint32_t index, const LightDesc& light) override;
+    void enableLight(uint32_t index, bool enabled) override;
+
+    void setVertexBuffer(BufferHandle buffer) override;
+    void setIndexBuffer(BufferHandle buffer) override;
+    void setTexture(uint32_t stage, TextureHandle texture) override;
+
+    void draw(PrimitiveType type, uint32_t startVertex, uint32_t primitiveCount) override;
+    void drawIndexed(PrimitiveType type, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount) override;
+
+    bool supportsInstancing() const override { return shaders; }
+    bool supportsIndex32() const override { return index32; }
+    void drawIndexedInstanced(PrimitiveType type, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount,
+        BufferHandle instances, uint32_t firstInstance, uint32_t instanceCount) override;
+
+private:
+    // Vertex and index buffers share one handle space; exactly one pointer is set
+    struct Buffer {
+        IDirect3DVertexBuffer9* vertices = nullptr;
+        IDirect3DIndexBuffer9* indices = nullptr;
+        VertexLayout layout;
+    };
+
+    // Vertex declaration for one layout, optionally followed by the instance stream
+    struct Declaration {
+        uint32_t key;
+        bool instanced;
+        IDirect3DVertexDeclaration9* declaration;
+    };
+
+    uint32_t allocateBuffer();
+    uint32_t allocateTexture();
+
+    void initShaders(const D3DCAPS9& caps);
+    IDirect3DVertexDeclaration9* getDeclaration(const VertexLayout& layout, bool instanced);
+    void bindVertexInput(const VertexLayout& layout);
+    void beginShaderDraw(const VertexLayout& layout, bool instanced);
+    void endShaderDraw(const VertexLayout& layout);
+    void uploadShaderConstants(const VertexLayout& layout);
+
+    IDirect3DDevice9* device;
+    std::vector<Buffer> buffers;                // handle - 1
+    std::vector<uint32_t> freeBuffers;
+    std::vector<IDirect3DTexture9*> textures;   // handle - 1
+    std::vector<uint32_t> freeTextures;
+    BufferHandle boundVertices = NullHandle;
+
+    bool shaders = false;
+    bool index32 = false;
+    DWORD declTypes = 0;
+    std::vector<Declaration> declarations;      // a few layouts, found by linear search
+    IDirect3DVertexShader9* meshVertexShader = nullptr;
+    IDirect3DVertexShader9* instanceVertexShader = nullptr;
+    IDirect3DPixelShader9* pixelShader = nullptr;
+};
@@ -0,0 +1,319 @@
+#include "Mesh.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static Vec3 positionOf(const Vertex& v)
+{
+    return { v.x, v.y, v.z };
+}
+
+void Mesh::optimize()
+{
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+}
+
+void Mesh::buildClusters()
+{
+    clusters.clear();
+
+    // A triangle whose corners lie further apart than 16 bits can reach gets its
+    // own copies of them at the end, so the 16-bit fallback can still draw it
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        uint32_t* t = &indices[i];
+        if (std::max({ t[0], t[1], t[2] }) - std::min({ t[0], t[1], t[2] }) <= 0xFFFF) continue;
+        for (int k = 0; k < 3; ++k) {
+            const Vertex copy = vertices[t[k]];
+            t[k] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(copy);
+        }
+    }
+
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    uint32_t triangle = 0;
+    while (triangle < triangleCount) {
+        MeshCluster cluster{};
+        cluster.firstIndex = triangle * 3;
+        cluster.minVertex = UINT32_MAX;
+        cluster.maxVertex = 0;
+
+        // Greedy in index order, which importers keep spatially coherent. A
+        // cluster also closes before its vertices span more than 16 bits can
+        // address, which a single triangle never does after the copies above.
+        while (triangle < triangleCount && cluster.triangleCount < MaxClusterTriangles) {
+            const uint32_t* t = &indices[triangle * 3];
+            const uint32_t lo = std::min({ cluster.minVertex, t[0], t[1], t[2] });
+            const uint32_t hi = std::max({ cluster.maxVertex, t[0], t[1], t[2] });
+            if (cluster.triangleCount > 0 && hi - lo > 0xFFFF) break;
+
+            cluster.minVertex = lo;
+            cluster.maxVertex = hi;
+            ++cluster.triangleCount;
+            ++triangle;
+        }
+
+        Aabb& box = cluster.bounds;
+        box = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+        Vec3 normalSum;
+        std::vector<Vec3> normals;
+        normals.reserve(cluster.triangleCount);
+
+        const uint32_t end = cluster.firstIndex + cluster.triangleCount * 3;
+        for (uint32_t i = cluster.firstIndex; i < end; i += 3) {
+            const Vec3 p0 = positionOf(vertices[indices[i]]);
+            const Vec3 p1 = positionOf(vertices[indices[i + 1]]);
+            const Vec3 p2 = positionOf(vertices[indices[i + 2]]);
+            for (const Vec3& p : { p0, p1, p2 }) {
+                box.min[0] = std::min(box.min[0], p.x); box.max[0] = std::max(box.max[0], p.x);
+                box.min[1] = std::min(box.min[1], p.y); box.max[1] = std::max(box.max[1], p.y);
+                box.min[2] = std::min(box.min[2], p.z); box.max[2] = std::max(box.max[2], p.z);
+            }
+
+            // Faces the viewer when clockwise on screen, matching counter-clockwise culling
+            const Vec3 normal = cross(p1 - p0, p2 - p0);
+            const float area = length(normal);
+            if (area > 1e-12f) {
+                normals.push_back(normal * (1.0f / area));
+                normalSum += normals.back();
+            }
+        }
+
+        cluster.center = Vec3((box.min[0] + box.max[0]) * 0.5f, (box.min[1] + box.max[1]) * 0.5f, (box.min[2] + box.max[2]) * 0.5f);
+        float radiusSq = 0.0f;
+        for (uint32_t i = cluster.firstIndex; i < end; ++i) {
+            radiusSq = std::max(radiusSq, lengthSq(positionOf(vertices[indices[i]]) - cluster.center));
+        }
+        cluster.radius = std::sqrt(radiusSq);
+
+        // The cone only pays off when the normals stay within about 84 degrees of the axis
+        cluster.coneAxis = Vec3(0, 0, 1);
+        cluster.coneCutoff = 1.0f;
+        if (!normals.empty() && lengthSq(normalSum) > 0.0f) {
+            cluster.coneAxis = normalize(normalSum);
+            float minDot = 1.0f;
+            for (const Vec3& n : normals) minDot = std::min(minDot, dot(n, cluster.coneAxis));
+            if (minDot > 0.1f) cluster.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+
+        clusters.push_back(cluster);
+    }
+}
+
+void Mesh::buildLods()
+{
+    lodIndices.clear();
+    lods.clear();
+
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    lods.push_back({ 0, triangleCount, 0.0f });
+    if (triangleCount < MinLodTriangles) return;
+
+    const float maxError = MaxLodError * length(maxBounds - minBounds);
+    std::vector<uint32_t> source = indices;
+    float error = 0.0f;
+
+    while (lods.size() < MaxLods) {
+        float levelError = 0.0f;
+        std::vector<uint32_t> simplified = simplifyMesh(vertices, source, source.size() / 6 * 3, maxError, &levelError);
+
+        // A level that hardly drops anything is not worth switching to
+        if (simplified.empty() || simplified.size() * 4 > source.size() * 3) break;
+
+        // Each level starts from the last, so their errors add up at worst
+        error += levelError;
+        lods.push_back({ static_cast<uint32_t>(indices.size() + lodIndices.size()),
+            static_cast<uint32_t>(simplified.size() / 3), error });
+        source.swap(simplified);
+
+        // Collapses leave holes in the fans, so the level gets its own cache order
+        optimizeVertexCache(source, vertices.size());
+        lodIndices.insert(lodIndices.end(), source.begin(), source.end());
+    }
+}
+
+// Each unsupported quantized format is swapped for its float counterpart
+static VertexLayout supportedLayout(const VertexLayout& wanted, const RenderDevice& device)
+{
+    VertexLayout layout = wanted;
+    for (int i = 0; i < VertexLayout::AttributeCount; ++i) {
+        const VertexElementFormat format = wanted.formats[i];
+        if (device.supportsVertexFormat(format)) continue;
+
+        const VertexAttribute attribute = static_cast<VertexAttribute>(i);
+        layout.set(attribute, format == VertexElementFormat::Half2 ? VertexElementFormat::Float2 : VertexElementFormat::Float3);
+        if (attribute == VertexAttribute::Position) {
+            layout.positionScale = Vec3(1.0f, 1.0f, 1.0f);
+            layout.positionBias = Vec3();
+        }
+    }
+    return layout;
+}
+
+void Mesh::enqueue(RenderQueue& queue, RenderDevice& device, const Mat4& world, uint32_t& lod)
+{
+    if (!ensureBuffers(device)) return;
+
+    static const Material white = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } };
+
+    // Simplified levels are for meshes small on screen; they go whole
+    lod = selectLod(queue, world, lod);
+    if (lod > 0) {
+        const MeshLod& level = lods[lod];
+        queue.push(RenderPass::Opaque, white, vb, ib,
+            0, static_cast<uint32_t>(vertices.size()),
+            level.firstIndex, level.triangleCount, world);
+        queue.addReducedDraw();
+        return;
+    }
+
+    // Small meshes go whole, keeping one packet per object for instancing
+    if (clusters.size() < MinCulledClusters && !clusterBases) {
+        queue.push(RenderPass::Opaque, white, vb, ib,
+            0, static_cast<uint32_t>(vertices.size()),
+            0, static_cast<uint32_t>(indices.size() / 3),
+            world);
+        return;
+    }
+
+    // The cone test runs in mesh space, where which side a triangle shows is the
+    // same as in the world unless the matrix mirrors
+    float determinant = 0.0f;
+    const Mat4 toLocal = inverse(world, &determinant);
+    const bool testCones = queue.isCullingBackfaces() && determinant > 0.0f;
+    const Vec3 camera = transformPoint(queue.getCameraPosition(), toLocal);
+
+    // Visible clusters that follow each other in the index buffer are drawn together
+    const MeshCluster* runFirst = nullptr;
+    uint32_t runTriangles = 0;
+    auto flush = [&]() {
+        if (!runFirst) return;
+        queue.push(RenderPass::Opaque, white, vb, ib,
+            getBaseVertex(*runFirst), getVertexSpan(*runFirst),
+            runFirst->firstIndex, runTriangles, world);
+        runFirst = nullptr;
+        runTriangles = 0;
+    };
+
+    uint32_t culled = 0;
+    for (const MeshCluster& cluster : clusters) {
+        const bool visible = !(testCones && cluster.isBackfacing(camera))
+            && queue.getFrustum().classify(transformAabb(cluster.bounds, world.data())) != Frustum::Outside;
+        if (!visible) {
+            ++culled;
+            flush();
+            continue;
+        }
+
+        // With per-cluster bases every cluster is its own draw
+        if (runFirst && clusterBases) flush();
+        if (!runFirst) runFirst = &cluster;
+        runTriangles += cluster.triangleCount;
+    }
+    flush();
+    queue.addCulledClusters(culled);
+}
+
+uint32_t Mesh::selectLod(const RenderQueue& queue, const Mat4& world, uint32_t current) const
+{
+    if (!hasLods()) return 0;
+
+    // Errors are in mesh units; the largest axis scale is the worst case
+    const Vec3 center = transformPoint((minBounds + maxBounds) * 0.5f, world);
+    const float scale = std::max({ length(world.getRow(0)), length(world.getRow(1)), length(world.getRow(2)) });
+    const float radius = length(maxBounds - minBounds) * 0.5f * scale;
+    const float distance = length(center - queue.getCameraPosition());
+    if (distance <= radius) return 0;
+
+    // Fraction of the viewport height one mesh unit covers at this distance
+    const float toScreen = 0.5f * queue.getProjectionScale() * scale / distance;
+    const uint32_t count = static_cast<uint32_t>(lods.size());
+    auto coarsest = [&](float limit) {
+        for (uint32_t level = count - 1; level > 0; --level) {
+            if (lods[level].error * toScreen <= limit) return level;
+        }
+        return 0u;
+    };
+
+    uint32_t lod = std::min(current, count - 1);
+    if (lods[lod].error * toScreen > MaxLodScreenError) {
+        lod = coarsest(MaxLodScreenError);
+    }
+    else {
+        lod = std::max(lod, coarsest(MaxLodScreenError * LodHysteresis));
+    }
+    return lod;
+}
+
+bool Mesh::ensureBuffers(RenderDevice& device)
+{
+    // Buffers made on another device are as good as lost
+    if (bufferDevice == &device) return true;
+    releaseBuffers();
+
+    if (vertices.empty() || indices.empty()) return false;
+
+    bufferLayout = supportedLayout(layout, device);
+    std::vector<uint8_t> packed(vertices.size() * bufferLayout.stride);
+    packVertices(vertices.data(), vertices.size(), bufferLayout, packed.data());
+
+    vb = device.createVertexBuffer(packed.data(), static_cast<uint32_t>(packed.size()), bufferLayout);
+    if (vb == NullHandle) return false;
+
+    const bool fits16 = vertices.size() <= 0x10000;
+    if (fits16) {
+        clusterBases = false;
+
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        narrow.insert(narrow.end(), lodIndices.begin(), lodIndices.end());
+        ib = device.createIndexBuffer(narrow.data(),
+            static_cast<uint32_t>(narrow.size() * sizeof(uint16_t)), IndexFormat::Index16);
+    }
+    else if (!device.supportsIndex32()) {
+        // The simplified levels reach across clusters, so only the full mesh goes up
+        clusterBases = true;
+
+        std::vector<uint16_t> narrow(indices.size());
+        for (const MeshCluster& cluster : clusters) {
+            const uint32_t base = static_cast<uint32_t>(getBaseVertex(cluster));
+            const uint32_t end = cluster.firstIndex + cluster.triangleCount * 3;
+            for (uint32_t i = cluster.firstIndex; i < end; ++i) {
+                narrow[i] = static_cast<uint16_t>(indices[i] - base);
+            }
+        }
+        ib = device.createIndexBuffer(narrow.data(),
+            static_cast<uint32_t>(narrow.size() * sizeof(uint16_t)), IndexFormat::Index16);
+    }
+    else {
+        clusterBases = false;
+
+        std::vector<uint32_t> wide(indices);
+        wide.insert(wide.end(), lodIndices.begin(), lodIndices.end());
+        ib = device.createIndexBuffer(wide.data(),
+            static_cast<uint32_t>(wide.size() * sizeof(uint32_t)), IndexFormat::Index32);
+    }
+
+    if (ib == NullHandle) {
+        device.destroyBuffer(vb);
+        vb = NullHandle;
+        return false;
+    }
+
+    bufferDevice = &device;
+    return true;
+}
+
+void Mesh::releaseBuffers()
+{
+    if (bufferDevice) {
+        bufferDevice->destroyBuffer(vb);
+        bufferDevice->destroyBuffer(ib);
+    }
+    bufferDevice = nullptr;
+    vb = NullHandle;
+    ib = NullHandle;
+}
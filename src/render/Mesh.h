@@ -0,0 +1,130 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include "Bounds.h"
+#include <vector>
+
+class RenderQueue;
+
+// Run of consecutive triangles that is culled as a unit. Besides its box, a
+// cluster has a bounding sphere and a cone around its triangle normals, so a
+// camera that sees every triangle from behind can skip it.
+struct MeshCluster {
+    uint32_t firstIndex;
+    uint32_t triangleCount;
+    uint32_t minVertex;
+    uint32_t maxVertex;
+    Aabb bounds;
+    Vec3 center;
+    float radius;
+    Vec3 coneAxis;
+    float coneCutoff;       // sine of the normals' spread; 1 disables the cone test
+
+    // True when the camera, in the mesh's space, sees all the triangles from behind
+    bool isBackfacing(const Vec3& camera) const {
+        const Vec3 toCenter = center - camera;
+        return dot(toCenter, coneAxis) >= coneCutoff * length(toCenter) + radius;
+    }
+};
+
+// One level of detail: a triangle range of the mesh's index buffer, drawn
+// against all of its vertices. error bounds how far the surface moved from the
+// full mesh, as measured by simplifyMesh.
+struct MeshLod {
+    uint32_t firstIndex;
+    uint32_t triangleCount;
+    float error;
+};
+
+// Geometry loaded once per path by ResourceManager and shared by every
+// renderer that uses it. The GPU copy lives here too, so a mesh is uploaded
+// once however many renderers reference it, and freed with the last of them.
+//
+// Indices are 32-bit. Devices without 32-bit index support get 16-bit indices
+// instead: as they are for meshes under 65536 vertices, otherwise relative to
+// each cluster's first vertex and drawn cluster by cluster.
+//
+// Vertices stay at full precision here and are packed to layout on upload. The
+// loader picks the layout; formats the device cannot read fall back to floats.
+//
+// Simplified levels share the vertices and follow the full index list in the
+// index buffer. They are left out when clusters need their own base vertex.
+class Mesh {
+public:
+    static constexpr uint32_t MaxClusterTriangles = 256;
+    static constexpr size_t MaxLods = 4;                // the full mesh included
+    static constexpr uint32_t MinLodTriangles = 256;    // smaller meshes keep one level
+    static constexpr float MaxLodError = 0.05f;         // of the bounds' diagonal, per level
+
+    // Meshes with fewer clusters are submitted whole rather than culled cluster by cluster
+    static constexpr size_t MinCulledClusters = 8;
+
+    // A level is used while its error covers at most this fraction of the
+    // viewport height, about a pixel at 1080p. Going coarser needs it to be
+    // LodHysteresis times smaller, so a mesh at the boundary does not flicker.
+    static constexpr float MaxLodScreenError = 0.001f;
+    static constexpr float LodHysteresis = 0.75f;
+
+    Mesh() = default;
+    ~Mesh() { releaseBuffers(); }
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    // Orders triangles for the post-transform cache, then runs of them against
+    // overdraw, then vertices by first use; call before buildClusters()
+    void optimize();
+
+    // Splits the triangles into clusters in index order; call once indices are final.
+    // Triangles spanning more vertices than 16 bits address get copies of theirs.
+    void buildClusters();
+
+    // Simplifies level after level, each to half the triangles of the one before,
+    // until MaxLods or the error limit; call after buildClusters()
+    void buildLods();
+
+    // Queues the mesh drawn with world, uploading it first if needed: a simplified
+    // level when it is small on screen, otherwise the clusters that pass the frustum
+    // and backface tests. lod is the level drawn last time, kept by the caller for
+    // hysteresis, and receives the level chosen now.
+    void enqueue(RenderQueue& queue, RenderDevice& device, const Mat4& world, uint32_t& lod);
+    uint32_t selectLod(const RenderQueue& queue, const Mat4& world, uint32_t current) const;
+
+    // Uploads on first use on a device; later calls are free
+    bool ensureBuffers(RenderDevice& device);
+    void releaseBuffers();
+
+    BufferHandle getVertexBuffer() const { return vb; }
+    BufferHandle getIndexBuffer() const { return ib; }
+    const VertexLayout& getBufferLayout() const { return bufferLayout; }
+
+    // Whether clusters have to be drawn one at a time with their own base vertex
+    bool hasClusterBases() const { return clusterBases; }
+    bool hasLods() const { return lods.size() > 1 && !clusterBases; }
+    // CPU-side indices of a level, for lods[level].triangleCount triangles
+    const uint32_t* getLodIndices(size_t level) const {
+        return level == 0 ? indices.data() : lodIndices.data() + (lods[level].firstIndex - indices.size());
+    }
+    int32_t getBaseVertex(const MeshCluster& cluster) const {
+        return clusterBases ? static_cast<int32_t>(cluster.minVertex) : 0;
+    }
+    uint32_t getVertexSpan(const MeshCluster& cluster) const {
+        return clusterBases ? cluster.maxVertex - cluster.minVertex + 1 : static_cast<uint32_t>(vertices.size());
+    }
+
+    std::vector<Vertex> vertices;
+    VertexLayout layout = VertexLayout::mesh();
+    std::vector<uint32_t> indices;
+    std::vector<MeshCluster> clusters;
+    std::vector<uint32_t> lodIndices;   // the simplified levels back to back
+    std::vector<MeshLod> lods;          // lods[0] is the full mesh
+    Vec3 minBounds;
+    Vec3 maxBounds;
+
+private:
+    RenderDevice* bufferDevice = nullptr;
+    BufferHandle vb = NullHandle;
+    BufferHandle ib = NullHandle;
+    VertexLayout bufferLayout;
+    bool clusterBases = false;
+};
@@ -0,0 +1,229 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+static constexpr uint32_t NoVertex = UINT32_MAX;
+
+// FIFO cache kept as the time each vertex last entered it. Advancing the clock
+// by more than the cache size empties it.
+struct VertexCache {
+    std::vector<uint32_t> entered;
+    uint32_t clock;
+    unsigned size;
+
+    VertexCache(size_t vertexCount, unsigned cacheSize)
+        : entered(vertexCount, 0), clock(cacheSize + 1), size(cacheSize) {}
+
+    bool contains(uint32_t v) const { return clock - entered[v] <= size; }
+
+    // True on a miss, which brings the vertex in
+    bool access(uint32_t v) {
+        if (contains(v)) return false;
+        entered[v] = clock++;
+        return true;
+    }
+
+    unsigned accessTriangle(const uint32_t* t) { return access(t[0]) + access(t[1]) + access(t[2]); }
+    void flush() { clock += size + 1; }
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, unsigned cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.size() < 3 || vertexCount == 0) return stats;
+
+    VertexCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> used(vertexCount, 0);
+    size_t misses = 0;
+    size_t distinct = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        misses += cache.accessTriangle(&indices[i]);
+        for (int k = 0; k < 3; ++k) {
+            distinct += !used[indices[i + k]];
+            used[indices[i + k]] = 1;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(distinct);
+    return stats;
+}
+
+// Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw", SIGGRAPH 2007
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, unsigned cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertexCount == 0) return;
+
+    // Triangles around each vertex, and how many of them are still to be emitted
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) ++live[indices[i]];
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    std::partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    VertexCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    deadEnd.reserve(triangleCount * 3);
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    uint32_t current = indices[0];
+    uint32_t cursor = 0;
+    while (current != NoVertex) {
+        // Fan out every remaining triangle around the current vertex
+        const size_t firstCandidate = deadEnd.size();
+        for (uint32_t k = offsets[current]; k < offsets[current + 1]; ++k) {
+            const uint32_t triangle = adjacency[k];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = 1;
+
+            for (int j = 0; j < 3; ++j) {
+                const uint32_t v = indices[triangle * 3 + j];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                --live[v];
+                cache.access(v);
+            }
+        }
+
+        // The oldest candidate that would still be cached after its own fan
+        uint32_t next = NoVertex;
+        int64_t bestPriority = -1;
+        for (size_t i = firstCandidate; i < deadEnd.size(); ++i) {
+            const uint32_t v = deadEnd[i];
+            if (live[v] == 0) continue;
+
+            const int64_t age = cache.clock - cache.entered[v];
+            const int64_t priority = age + 2 * static_cast<int64_t>(live[v]) <= cacheSize ? age : 0;
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        // Nothing left around here: back up the recently used vertices, then scan
+        while (next == NoVertex && !deadEnd.empty()) {
+            const uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) next = v;
+        }
+        while (next == NoVertex && cursor < vertexCount) {
+            if (live[cursor] > 0) next = cursor;
+            ++cursor;
+        }
+        current = next;
+    }
+
+    indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold, unsigned cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertices.empty()) return;
+
+    VertexCache cache(vertices.size(), cacheSize);
+
+    // Hard boundaries: triangles that miss on all three vertices start over anyway.
+    // The first triangle always opens one, even when repeated indices make it miss less.
+    std::vector<uint32_t> hard;
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        const unsigned misses = cache.accessTriangle(&indices[t * 3]);
+        if (t == 0 || misses == 3) hard.push_back(t);
+    }
+    hard.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Soft boundaries: split a stretch once a run's ACMR is close enough to the stretch's
+    std::vector<uint32_t> runs;
+    for (size_t h = 0; h + 1 < hard.size(); ++h) {
+        const uint32_t begin = hard[h];
+        const uint32_t end = hard[h + 1];
+
+        cache.flush();
+        unsigned stretchMisses = 0;
+        for (uint32_t t = begin; t < end; ++t) stretchMisses += cache.accessTriangle(&indices[t * 3]);
+        const float target = threshold * stretchMisses / static_cast<float>(end - begin);
+
+        cache.flush();
+        runs.push_back(begin);
+        unsigned misses = 0;
+        for (uint32_t t = begin; t + 1 < end; ++t) {
+            misses += cache.accessTriangle(&indices[t * 3]);
+            if (misses <= target * (t + 1 - runs.back())) {
+                runs.push_back(t + 1);
+                cache.flush();
+                misses = 0;
+            }
+        }
+    }
+    runs.push_back(static_cast<uint32_t>(triangleCount));
+    const size_t runCount = runs.size() - 1;
+    if (runCount < 2) return;
+
+    // Area-weighted centroid and normal of each run, with the same facing as Mesh::buildClusters
+    std::vector<Vec3> centroids(runCount);
+    std::vector<Vec3> normals(runCount);
+    std::vector<float> areas(runCount, 0.0f);
+    Vec3 meshCentroid;
+    float meshArea = 0.0f;
+    for (size_t r = 0; r < runCount; ++r) {
+        for (uint32_t t = runs[r]; t < runs[r + 1]; ++t) {
+            const Vertex& a = vertices[indices[t * 3]];
+            const Vertex& b = vertices[indices[t * 3 + 1]];
+            const Vertex& c = vertices[indices[t * 3 + 2]];
+            const Vec3 p0(a.x, a.y, a.z), p1(b.x, b.y, b.z), p2(c.x, c.y, c.z);
+
+            const Vec3 normal = cross(p1 - p0, p2 - p0);
+            const float area = length(normal);
+            centroids[r] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[r] += normal;
+            areas[r] += area;
+        }
+        meshCentroid += centroids[r];
+        meshArea += areas[r];
+        if (areas[r] > 0.0f) centroids[r] = centroids[r] * (1.0f / areas[r]);
+    }
+    if (meshArea <= 0.0f) return;
+    meshCentroid = meshCentroid * (1.0f / meshArea);
+
+    std::vector<float> keys(runCount, 0.0f);
+    for (size_t r = 0; r < runCount; ++r) {
+        if (lengthSq(normals[r]) > 0.0f) keys[r] = dot(centroids[r] - meshCentroid, normalize(normals[r]));
+    }
+
+    std::vector<uint32_t> order(runCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const uint32_t r : order) {
+        result.insert(result.end(), indices.begin() + runs[r] * 3, indices.begin() + runs[r + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), NoVertex);
+    uint32_t next = 0;
+    for (uint32_t& index : indices) {
+        if (remap[index] == NoVertex) remap[index] = next++;
+        index = remap[index];
+    }
+
+    std::vector<Vertex> result(next);
+    for (size_t v = 0; v < vertices.size(); ++v) {
+        if (remap[v] != NoVertex) result[remap[v]] = vertices[v];
+    }
+    vertices.swap(result);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "VertexLayout.h"
+#include <vector>
+
+// Post-transform cache behaviour of an index list on a FIFO cache. acmr is the
+// number of vertices transformed per triangle (0.5 at best on a regular grid,
+// 3 with no reuse); atvr is the same per distinct vertex referenced (1 at best).
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// Entries of the simulated cache; roughly what pre-unified hardware kept
+static constexpr unsigned VertexCacheSize = 16;
+
+// How much worse than the cache order a run may be before it is cut off
+static constexpr float OverdrawThreshold = 1.05f;
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount,
+    unsigned cacheSize = VertexCacheSize);
+
+// Reorders triangles for the post-transform cache with Tipsify: it fans around
+// one vertex at a time and moves on to the neighbour that is still in the cache
+// and has the fewest triangles left. Runs in linear time.
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount,
+    unsigned cacheSize = VertexCacheSize);
+
+// Cuts cache-ordered indices into runs where the cache starts over anyway, or
+// where a run's ACMR is already within threshold times its whole stretch's,
+// then draws the runs facing away from the mesh's center first, since those
+// tend to hide the rest. Each run keeps its inner order.
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+    float threshold = OverdrawThreshold, unsigned cacheSize = VertexCacheSize);
+
+// Renumbers the vertices in the order the indices first use them, so vertex
+// fetches walk the buffer forward, and drops vertices no triangle uses.
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
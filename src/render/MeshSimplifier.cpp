@@ -0,0 +1,526 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+// Sum of squared distances to a set of weighted planes, kept as the upper half
+// of a symmetric 4x4 matrix. Dividing by the total weight turns it into a mean.
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0;
+
+    void addPlane(const Vec3& n, float d, double w) {
+        a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+        a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+        a22 += w * n.z * n.z; a23 += w * n.z * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric& o) {
+        a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+        a11 += o.a11; a12 += o.a12; a13 += o.a13;
+        a22 += o.a22; a23 += o.a23;
+        a33 += o.a33;
+        weight += o.weight;
+    }
+
+    // Mean squared distance from p to the planes
+    double error(const Vec3& p) const {
+        if (weight <= 0.0) return 0.0;
+        const double x = p.x, y = p.y, z = p.z;
+        const double e = a00 * x * x + a11 * y * y + a22 * z * z + a33
+            + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z + a03 * x + a13 * y + a23 * z);
+        return std::max(e, 0.0) / weight;
+    }
+};
+
+enum class VertexKind : uint8_t { Manifold, Border, Seam, Locked };
+
+// One collapse per vertex and pass; a seam collapse moves the vertex's twin too
+struct Collapse {
+    uint32_t vertex;
+    uint32_t target;
+    uint32_t twin;
+    uint32_t twinTarget;
+    double cost;
+};
+
+static constexpr uint32_t NoVertex = UINT32_MAX;
+
+// Open edges pull much harder than faces, so outlines and seams keep their shape
+static constexpr double OpenEdgeWeight = 10.0;
+
+// Rejects collapses that turn a neighbouring triangle by more than about 75 degrees
+static constexpr float MinNormalAlignment = 0.25f;
+
+struct PositionKey {
+    uint32_t bits[3];
+    bool operator==(const PositionKey& o) const { return std::memcmp(bits, o.bits, sizeof(bits)) == 0; }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const {
+        return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+    }
+};
+
+static Vec3 positionOf(const Vertex& v)
+{
+    return { v.x, v.y, v.z };
+}
+
+static uint64_t edgeKey(uint32_t a, uint32_t b)
+{
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+// Directed triangle edges, sorted for lookups; through remap when given
+static void collectEdges(const std::vector<uint32_t>& indices, const std::vector<uint32_t>* remap, std::vector<uint64_t>& edges)
+{
+    edges.clear();
+    edges.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int e = 0; e < 3; ++e) {
+            uint32_t a = indices[i + e];
+            uint32_t b = indices[i + (e + 1) % 3];
+            if (remap) {
+                a = (*remap)[a];
+                b = (*remap)[b];
+            }
+            edges.push_back(edgeKey(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+}
+
+static bool hasEdge(const std::vector<uint64_t>& edges, uint32_t a, uint32_t b)
+{
+    return std::binary_search(edges.begin(), edges.end(), edgeKey(a, b));
+}
+
+// An edge with triangles on one side only
+static bool isOpen(const std::vector<uint64_t>& edges, uint32_t a, uint32_t b)
+{
+    return hasEdge(edges, a, b) != hasEdge(edges, b, a);
+}
+
+// Vertices at the same position form a group, linked in a ring through nextWedge.
+// Only vertices the indices use are grouped; the rest stay alone.
+static void buildGroups(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    std::vector<uint32_t>& group, std::vector<uint32_t>& nextWedge)
+{
+    const uint32_t count = static_cast<uint32_t>(vertices.size());
+    group.resize(count);
+    nextWedge.resize(count);
+    std::iota(group.begin(), group.end(), 0u);
+    std::iota(nextWedge.begin(), nextWedge.end(), 0u);
+
+    std::vector<uint8_t> used(count, 0);
+    for (uint32_t index : indices) used[index] = 1;
+
+    std::unordered_map<PositionKey, uint32_t, PositionKeyHash> first;
+    first.reserve(count);
+    for (uint32_t v = 0; v < count; ++v) {
+        if (!used[v]) continue;
+
+        // Adding zero folds -0 into +0
+        const float p[3] = { vertices[v].x + 0.0f, vertices[v].y + 0.0f, vertices[v].z + 0.0f };
+        PositionKey key;
+        std::memcpy(key.bits, p, sizeof(p));
+
+        const auto inserted = first.emplace(key, v);
+        if (inserted.second) continue;
+
+        const uint32_t head = inserted.first->second;
+        group[v] = head;
+        nextWedge[v] = nextWedge[head];
+        nextWedge[head] = v;
+    }
+}
+
+static void classify(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& group,
+    const std::vector<uint32_t>& nextWedge, std::vector<VertexKind>& kinds)
+{
+    const size_t count = group.size();
+    std::vector<uint64_t> vertexEdges;
+    std::vector<uint64_t> groupEdges;
+    collectEdges(indices, nullptr, vertexEdges);
+    collectEdges(indices, &group, groupEdges);
+
+    // Open edges in and out of each vertex and each group; an edge used twice in
+    // the same direction is not manifold and pins both ends
+    std::vector<uint8_t> vertexOut(count, 0), vertexIn(count, 0);
+    std::vector<uint8_t> groupOut(count, 0), groupIn(count, 0);
+    std::vector<uint8_t> pinned(count, 0);
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int e = 0; e < 3; ++e) {
+            const uint32_t a = indices[i + e];
+            const uint32_t b = indices[i + (e + 1) % 3];
+            if (!hasEdge(vertexEdges, b, a)) {
+                vertexOut[a] = static_cast<uint8_t>(std::min(vertexOut[a] + 1, 255));
+                vertexIn[b] = static_cast<uint8_t>(std::min(vertexIn[b] + 1, 255));
+            }
+            const uint32_t ga = group[a];
+            const uint32_t gb = group[b];
+            if (!hasEdge(groupEdges, gb, ga)) {
+                groupOut[ga] = static_cast<uint8_t>(std::min(groupOut[ga] + 1, 255));
+                groupIn[gb] = static_cast<uint8_t>(std::min(groupIn[gb] + 1, 255));
+            }
+        }
+    }
+    for (size_t i = 1; i < groupEdges.size(); ++i) {
+        if (groupEdges[i] != groupEdges[i - 1]) continue;
+        pinned[groupEdges[i] >> 32] = 1;
+        pinned[groupEdges[i] & 0xFFFFFFFF] = 1;
+    }
+
+    kinds.assign(count, VertexKind::Locked);
+    for (size_t v = 0; v < count; ++v) {
+        const uint32_t g = group[v];
+        if (pinned[g]) continue;
+
+        const uint32_t twin = nextWedge[v];
+        const bool closed = groupOut[g] == 0 && groupIn[g] == 0;
+        if (twin == v) {
+            if (closed) kinds[v] = VertexKind::Manifold;
+            else if (groupOut[g] == 1 && groupIn[g] == 1) kinds[v] = VertexKind::Border;
+        }
+        else if (nextWedge[twin] == v && closed
+            && vertexOut[v] == 1 && vertexIn[v] == 1 && vertexOut[twin] == 1 && vertexIn[twin] == 1) {
+            kinds[v] = VertexKind::Seam;
+        }
+    }
+}
+
+static void buildQuadrics(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    const std::vector<uint32_t>& group, std::vector<Quadric>& quadrics)
+{
+    std::vector<uint64_t> vertexEdges;
+    collectEdges(indices, nullptr, vertexEdges);
+
+    quadrics.assign(vertices.size(), Quadric());
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const uint32_t corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
+        const Vec3 p[3] = { positionOf(vertices[corners[0]]), positionOf(vertices[corners[1]]), positionOf(vertices[corners[2]]) };
+
+        Vec3 normal = cross(p[1] - p[0], p[2] - p[0]);
+        const float doubleArea = length(normal);
+        if (doubleArea <= 0.0f) continue;
+        normal = normal / doubleArea;
+
+        const float d = -dot(normal, p[0]);
+        for (uint32_t corner : corners) {
+            quadrics[group[corner]].addPlane(normal, d, doubleArea * 0.5);
+        }
+
+        // Open edges, seams included, add a plane standing on the edge
+        for (int e = 0; e < 3; ++e) {
+            const uint32_t a = corners[e];
+            const uint32_t b = corners[(e + 1) % 3];
+            if (hasEdge(vertexEdges, b, a)) continue;
+
+            const Vec3 edge = p[(e + 1) % 3] - p[e];
+            const Vec3 side = normalize(cross(edge, normal));
+            const float sideD = -dot(side, p[e]);
+            const double w = lengthSq(edge) * OpenEdgeWeight;
+            quadrics[group[a]].addPlane(side, sideD, w);
+            quadrics[group[b]].addPlane(side, sideD, w);
+        }
+    }
+}
+
+// Triangles around each vertex, as offsets into a flat list; a trailing partial
+// triangle is ignored
+static void buildAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount,
+    std::vector<uint32_t>& offsets, std::vector<uint32_t>& triangles)
+{
+    const size_t count = indices.size() - indices.size() % 3;
+    offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < count; ++i) ++offsets[indices[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+
+    triangles.resize(count);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+// Squared distance from p to the closest point of triangle abc
+static float distanceSqToTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+{
+    const Vec3 ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return lengthSq(ap);
+
+    const Vec3 bp = p - b;
+    const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) return lengthSq(bp);
+
+    const Vec3 cp = p - c;
+    const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) return lengthSq(cp);
+
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return lengthSq(ap - ab * (d1 / (d1 - d3)));
+
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return lengthSq(ap - ac * (d2 / (d2 - d6)));
+
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        return lengthSq(bp - (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+    }
+
+    const float denom = 1.0f / (va + vb + vc);
+    return lengthSq(ap - ab * (vb * denom) - ac * (vc * denom));
+}
+
+// Largest distance between the input surface and the result, taken both ways:
+// from every input vertex to the result, and from the centroid and edge midpoints
+// of every result triangle back to the input. Each point is only checked against
+// triangles near where it ended up, which can only overstate its distance, so the
+// value is an upper bound on what was sampled. The quadrics only estimate this:
+// they average over the planes a vertex has gathered, so they can report far less
+// than the surface actually moved.
+static float measureError(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    const std::vector<uint32_t>& result, const std::vector<uint32_t>& collapseTo)
+{
+    const size_t vertexCount = vertices.size();
+    std::vector<uint32_t> offsets, adjacency, inputOffsets, inputAdjacency;
+    buildAdjacency(result, vertexCount, offsets, adjacency);
+    buildAdjacency(indices, vertexCount, inputOffsets, inputAdjacency);
+
+    auto nearestAround = [&](const Vec3& p, const std::vector<uint32_t>& mesh, const std::vector<uint32_t>& fanOffsets,
+        const std::vector<uint32_t>& fans, uint32_t corner, float nearest) {
+        for (uint32_t k = fanOffsets[corner]; k < fanOffsets[corner + 1]; ++k) {
+            const uint32_t* tri = &mesh[fans[k] * 3];
+            nearest = std::min(nearest, distanceSqToTriangle(p,
+                positionOf(vertices[tri[0]]), positionOf(vertices[tri[1]]), positionOf(vertices[tri[2]])));
+        }
+        return nearest;
+    };
+
+    // The result vertex each input vertex collapsed into, and the input vertices
+    // each result vertex gathered
+    std::vector<uint32_t> finalOf(vertexCount, NoVertex);
+    std::vector<uint32_t> gatheredOffsets(vertexCount + 1, 0), gathered;
+    for (size_t i = 0; i < inputOffsets[vertexCount]; ++i) {
+        const uint32_t v = indices[i];
+        if (finalOf[v] != NoVertex) continue;
+
+        uint32_t target = v;
+        while (collapseTo[target] != target) target = collapseTo[target];
+        finalOf[v] = target;
+        ++gatheredOffsets[target + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) gatheredOffsets[v + 1] += gatheredOffsets[v];
+    gathered.resize(gatheredOffsets[vertexCount]);
+    std::vector<uint32_t> fill(gatheredOffsets.begin(), gatheredOffsets.end() - 1);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        if (finalOf[v] != NoVertex) gathered[fill[finalOf[v]]++] = v;
+    }
+
+    // Widening a search can only lower a distance, so each point starts with the
+    // closest triangles and only looks further while it could still be the worst
+    float worst = 0.0f;
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        const uint32_t target = finalOf[v];
+        if (target == NoVertex || target == v || offsets[target] == offsets[target + 1]) continue;
+
+        const Vec3 p = positionOf(vertices[v]);
+        float nearest = nearestAround(p, result, offsets, adjacency, target, FLT_MAX);
+        for (uint32_t k = offsets[target]; k < offsets[target + 1] && nearest > worst; ++k) {
+            const uint32_t* tri = &result[adjacency[k] * 3];
+            for (int c = 0; c < 3; ++c) {
+                if (tri[c] != target) nearest = nearestAround(p, result, offsets, adjacency, tri[c], nearest);
+            }
+        }
+        worst = std::max(worst, nearest);
+    }
+
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const uint32_t* tri = &result[i];
+        const Vec3 p[3] = { positionOf(vertices[tri[0]]), positionOf(vertices[tri[1]]), positionOf(vertices[tri[2]]) };
+        const Vec3 samples[4] = { (p[0] + p[1] + p[2]) * (1.0f / 3.0f),
+            (p[0] + p[1]) * 0.5f, (p[1] + p[2]) * 0.5f, (p[2] + p[0]) * 0.5f };
+
+        for (const Vec3& sample : samples) {
+            float nearest = FLT_MAX;
+            for (int c = 0; c < 3; ++c) nearest = nearestAround(sample, indices, inputOffsets, inputAdjacency, tri[c], nearest);
+            for (int c = 0; c < 3 && nearest > worst; ++c) {
+                for (uint32_t k = gatheredOffsets[tri[c]]; k < gatheredOffsets[tri[c] + 1]; ++k) {
+                    nearest = nearestAround(sample, indices, inputOffsets, inputAdjacency, gathered[k], nearest);
+                }
+            }
+            worst = std::max(worst, nearest);
+        }
+    }
+    return std::sqrt(worst);
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    size_t targetIndexCount, float maxError, float* resultError)
+{
+    std::vector<uint32_t> result(indices.begin(), indices.end() - indices.size() % 3);
+    if (resultError) *resultError = 0.0f;
+    if (result.size() <= targetIndexCount || vertices.empty()) return result;
+
+    const size_t vertexCount = vertices.size();
+    std::vector<uint32_t> group, nextWedge;
+    std::vector<VertexKind> kinds;
+    std::vector<Quadric> quadrics;
+    buildGroups(vertices, result, group, nextWedge);
+    classify(result, group, nextWedge, kinds);
+    buildQuadrics(vertices, result, group, quadrics);
+
+    std::vector<uint32_t> collapseTo(vertexCount);
+    std::iota(collapseTo.begin(), collapseTo.end(), 0u);
+    std::vector<uint8_t> dirty(vertexCount, 0);
+    std::vector<uint64_t> vertexEdges, groupEdges;
+    std::vector<uint32_t> offsets, adjacency;
+    std::vector<Collapse> best(vertexCount);
+    std::vector<Collapse> candidates;
+
+    const double maxCost = static_cast<double>(maxError) * maxError;
+    const size_t targetTriangles = targetIndexCount / 3;
+    bool changed = false;
+
+    auto consider = [&](uint32_t v, uint32_t t) {
+        Collapse c{ v, t, NoVertex, NoVertex, 0.0 };
+        switch (kinds[v]) {
+        case VertexKind::Manifold:
+            break;
+        case VertexKind::Border:
+            if (kinds[t] != VertexKind::Border && kinds[t] != VertexKind::Locked) return;
+            if (!isOpen(groupEdges, group[v], group[t])) return;
+            break;
+        case VertexKind::Seam:
+            if (kinds[t] != VertexKind::Seam && kinds[t] != VertexKind::Locked) return;
+            if (!isOpen(vertexEdges, v, t)) return;
+
+            // The twin has to run along the same seam, to a copy of the target
+            c.twin = nextWedge[v];
+            for (uint32_t w = nextWedge[t]; w != t; w = nextWedge[w]) {
+                if (isOpen(vertexEdges, c.twin, w)) {
+                    c.twinTarget = w;
+                    break;
+                }
+            }
+            if (c.twinTarget == NoVertex) return;
+            break;
+        default:
+            return;
+        }
+
+        c.cost = quadrics[group[v]].error(positionOf(vertices[t]));
+        if (c.cost < best[v].cost) best[v] = c;
+    };
+
+    auto flips = [&](uint32_t v, uint32_t t) {
+        const Vec3 moved = positionOf(vertices[t]);
+        for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) {
+            const uint32_t* tri = &result[adjacency[i] * 3];
+            if (tri[0] == t || tri[1] == t || tri[2] == t) continue;
+
+            Vec3 p[3] = { positionOf(vertices[tri[0]]), positionOf(vertices[tri[1]]), positionOf(vertices[tri[2]]) };
+            const Vec3 before = cross(p[1] - p[0], p[2] - p[0]);
+            for (int k = 0; k < 3; ++k) {
+                if (tri[k] == v) p[k] = moved;
+            }
+            const Vec3 after = cross(p[1] - p[0], p[2] - p[0]);
+            if (dot(before, after) <= MinNormalAlignment * length(before) * length(after)) return true;
+        }
+        return false;
+    };
+
+    auto removedBy = [&](uint32_t v, uint32_t t) {
+        size_t removed = 0;
+        for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) {
+            const uint32_t* tri = &result[adjacency[i] * 3];
+            if (tri[0] == t || tri[1] == t || tri[2] == t) ++removed;
+        }
+        return removed;
+    };
+
+    auto markDirty = [&](uint32_t v) {
+        for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) {
+            const uint32_t* tri = &result[adjacency[i] * 3];
+            dirty[tri[0]] = dirty[tri[1]] = dirty[tri[2]] = 1;
+        }
+    };
+
+    // Each pass takes the cheapest collapses whose neighbourhoods do not overlap,
+    // then rebuilds the topology
+    size_t triangleCount = result.size() / 3;
+    while (triangleCount > targetTriangles) {
+        collectEdges(result, nullptr, vertexEdges);
+        collectEdges(result, &group, groupEdges);
+        buildAdjacency(result, vertexCount, offsets, adjacency);
+
+        for (Collapse& c : best) c.cost = DBL_MAX;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int e = 0; e < 3; ++e) {
+                const uint32_t a = result[i + e];
+                const uint32_t b = result[i + (e + 1) % 3];
+                consider(a, b);
+                consider(b, a);
+            }
+        }
+
+        candidates.clear();
+        for (const Collapse& c : best) {
+            if (c.cost <= maxCost) candidates.push_back(c);
+        }
+        std::sort(candidates.begin(), candidates.end(),
+            [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        std::fill(dirty.begin(), dirty.end(), 0);
+        bool collapsed = false;
+        for (const Collapse& c : candidates) {
+            if (triangleCount <= targetTriangles) break;
+            if (dirty[c.vertex] || dirty[c.target]) continue;
+            if (c.twin != NoVertex && (dirty[c.twin] || dirty[c.twinTarget])) continue;
+            if (flips(c.vertex, c.target)) continue;
+            if (c.twin != NoVertex && flips(c.twin, c.twinTarget)) continue;
+
+            collapseTo[c.vertex] = c.target;
+            triangleCount -= removedBy(c.vertex, c.target);
+            markDirty(c.vertex);
+            if (c.twin != NoVertex) {
+                collapseTo[c.twin] = c.twinTarget;
+                triangleCount -= removedBy(c.twin, c.twinTarget);
+                markDirty(c.twin);
+            }
+
+            quadrics[group[c.target]].add(quadrics[group[c.vertex]]);
+            collapsed = true;
+        }
+        if (!collapsed) break;
+        changed = true;
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            const uint32_t a = collapseTo[result[i]];
+            const uint32_t b = collapseTo[result[i + 1]];
+            const uint32_t c = collapseTo[result[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+        triangleCount = write / 3;
+    }
+
+    if (resultError && changed) *resultError = measureError(vertices, indices, result, collapseTo);
+    return result;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "VertexLayout.h"
+#include <vector>
+
+// Quadric-error edge collapse over an index list. Vertices only ever collapse
+// onto neighbouring vertices and are never modified, so every level can be
+// drawn from the original vertex buffer.
+//
+// Open edges are kept in place: a boundary vertex only slides along its
+// boundary, and the two copies of a vertex on a UV or normal seam (same
+// position, different attributes) slide along the seam together, so neither
+// side tears. Vertices where seams or boundaries meet never move.
+//
+// Runs without a device, so it can be measured on its own. Stops once the
+// index count is at most targetIndexCount or the next collapse's quadric
+// estimate exceeds maxError. resultError, if given, receives how far the result
+// is from the input, in the vertices' units: measured after the collapses, both
+// from the input vertices to the result and from points on the result back to
+// the input, and never less than the sampled distance. It can exceed maxError.
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    size_t targetIndexCount, float maxError, float* resultError = nullptr);
@@ -0,0 +1,206 @@
+#include "NullRenderDevice.h"
+#include <cassert>
+#include <cstring>
+
+NullRenderDevice::NullRenderDevice()
+{
+    for (Mat4& transform : transforms) {
+        transform = Mat4::identity();
+    }
+
+    // Direct3D 9's defaults, so both backends start from the same state
+    states[static_cast<int>(RenderState::DepthTest)] = 1;
+    states[static_cast<int>(RenderState::DepthFunc)] = static_cast<uint32_t>(CompareFunc::LessEqual);
+    states[static_cast<int>(RenderState::Cull)] = static_cast<uint32_t>(CullMode::CounterClockwise);
+    states[static_cast<int>(RenderState::Lighting)] = 1;
+}
+
+BufferHandle NullRenderDevice::createVertexBuffer(const void*, uint32_t size, const VertexLayout& layout)
+{
+    for ([[maybe_unused]] const VertexElementFormat format : layout.formats) {
+        assert(supportsVertexFormat(format));
+    }
+    if (size == 0) return NullHandle;
+    ++liveBuffers;
+    vertexBytes += size;
+    bufferSizes.resize(nextHandle);
+    bufferSizes[nextHandle - 1] = size;
+    return nextHandle++;
+}
+
+BufferHandle NullRenderDevice::createIndexBuffer(const void*, uint32_t size, [[maybe_unused]] IndexFormat format)
+{
+    assert(format != IndexFormat::Index32 || index32);
+    if (size == 0) return NullHandle;
+    ++liveBuffers;
+    bufferSizes.resize(nextHandle);
+    return nextHandle++;
+}
+
+bool NullRenderDevice::updateVertexBuffer(BufferHandle buffer, const void* data, uint32_t size)
+{
+    return buffer != NullHandle && data && size > 0;
+}
+
+void NullRenderDevice::destroyBuffer(BufferHandle buffer)
+{
+    if (buffer == NullHandle) return;
+    assert(liveBuffers > 0);
+    --liveBuffers;
+    if (buffer <= bufferSizes.size()) {
+        vertexBytes -= bufferSizes[buffer - 1];
+        bufferSizes[buffer - 1] = 0;
+    }
+    if (vertexBuffer == buffer) vertexBuffer = NullHandle;
+    if (indexBuffer == buffer) indexBuffer = NullHandle;
+}
+
+bool NullRenderDevice::supportsVertexFormat(VertexElementFormat format) const
+{
+    switch (format) {
+    case VertexElementFormat::Half2:
+    case VertexElementFormat::Short4N:
+    case VertexElementFormat::Octahedral:
+        return packedFormats;
+    default:
+        return true;
+    }
+}
+
+TextureHandle NullRenderDevice::createTextureFromFile(const char* path)
+{
+    if (!path || !*path) return NullHandle;
+    ++liveTextures;
+    return nextHandle++;
+}
+
+TextureHandle NullRenderDevice::createSolidTexture(uint32_t width, uint32_t height, uint32_t)
+{
+    if (width == 0 || height == 0) return NullHandle;
+    ++liveTextures;
+    return nextHandle++;
+}
+
+void NullRenderDevice::destroyTexture(TextureHandle texture)
+{
+    if (texture == NullHandle) return;
+    assert(liveTextures > 0);
+    --liveTextures;
+    for (TextureHandle& bound : textures) {
+        if (bound == texture) bound = NullHandle;
+    }
+}
+
+void NullRenderDevice::setTransform(TransformSlot slot, const Mat4& matrix)
+{
+    Mat4& current = transforms[static_cast<int>(slot)];
+    countChange(std::memcmp(&current, &matrix, sizeof(Mat4)) != 0);
+    current = matrix;
+
+    if (recording) {
+        record(RenderCommand::SetTransform, static_cast<uint32_t>(slot), static_cast<uint32_t>(matrices.size()));
+        matrices.push_back(matrix);
+    }
+}
+
+Mat4 NullRenderDevice::getTransform(TransformSlot slot) const
+{
+    return transforms[static_cast<int>(slot)];
+}
+
+void NullRenderDevice::setRenderState(RenderState state, uint32_t value)
+{
+    uint32_t& current = states[static_cast<int>(state)];
+    countChange(current != value);
+    current = value;
+    record(RenderCommand::SetRenderState, static_cast<uint32_t>(state), value);
+}
+
+uint32_t NullRenderDevice::getRenderState(RenderState state) const
+{
+    return states[static_cast<int>(state)];
+}
+
+void NullRenderDevice::setMaterial(const Material&)
+{
+    record(RenderCommand::SetMaterial);
+}
+
+void NullRenderDevice::setLight(uint32_t index, const LightDesc&)
+{
+    record(RenderCommand::SetLight, index);
+}
+
+void NullRenderDevice::enableLight(uint32_t index, bool enabled)
+{
+    record(RenderCommand::EnableLight, index, enabled ? 1 : 0);
+}
+
+void NullRenderDevice::setVertexBuffer(BufferHandle buffer)
+{
+    countChange(vertexBuffer != buffer);
+    vertexBuffer = buffer;
+    record(RenderCommand::SetVertexBuffer, buffer);
+}
+
+void NullRenderDevice::setIndexBuffer(BufferHandle buffer)
+{
+    countChange(indexBuffer != buffer);
+    indexBuffer = buffer;
+    record(RenderCommand::SetIndexBuffer, buffer);
+}
+
+void NullRenderDevice::setTexture(uint32_t stage, TextureHandle texture)
+{
+    assert(stage < MaxTextureStages);
+    countChange(textures[stage] != texture);
+    textures[stage] = texture;
+    record(RenderCommand::SetTexture, stage, texture);
+}
+
+void NullRenderDevice::draw(PrimitiveType type, uint32_t startVertex, uint32_t primitiveCount)
+{
+    assert(vertexBuffer != NullHandle);
+    ++stats.drawCalls;
+    ++stats.instances;
+    stats.primitives += primitiveCount;
+    record(RenderCommand::Draw, static_cast<uint32_t>(type), startVertex, primitiveCount);
+}
+
+void NullRenderDevice::drawIndexed(PrimitiveType, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount)
+{
+    assert(vertexBuffer != NullHandle && indexBuffer != NullHandle);
+    ++stats.drawCalls;
+    ++stats.instances;
+    stats.primitives += primitiveCount;
+    record(RenderCommand::DrawIndexed, static_cast<uint32_t>(baseVertex), vertexCount, startIndex, primitiveCount);
+}
+
+void NullRenderDevice::drawIndexedInstanced(PrimitiveType, int32_t, uint32_t, uint32_t, uint32_t primitiveCount,
+    BufferHandle instances, uint32_t firstInstance, uint32_t instanceCount)
+{
+    assert(instancing && instances != NullHandle);
+    assert(vertexBuffer != NullHandle && indexBuffer != NullHandle);
+    ++stats.drawCalls;
+    stats.instances += instanceCount;
+    stats.primitives += primitiveCount * instanceCount;
+    record(RenderCommand::DrawInstanced, instances, firstInstance, primitiveCount, instanceCount);
+}
+
+void NullRenderDevice::resetFrame()
+{
+    commands.clear();
+    matrices.clear();
+    stats = RenderStats();
+}
+
+void NullRenderDevice::record(RenderCommand::Type type, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    if (recording) commands.push_back({ type, a, b, c, d });
+}
+
+void NullRenderDevice::countChange(bool changed)
+{
+    if (changed) ++stats.stateChanges;
+    else ++stats.redundantStateChanges;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include <vector>
+
+// One recorded call. Arguments depend on the type:
+//   SetTransform     a = slot, b = index into getMatrices()
+//   SetRenderState   a = state, b = value
+//   SetLight         a = light index
+//   EnableLight      a = light index, b = enabled
+//   SetVertexBuffer  a = buffer
+//   SetIndexBuffer   a = buffer
+//   SetTexture       a = stage, b = texture
+//   Draw             a = primitive type, b = start vertex, c = primitive count
+//   DrawIndexed      a = base vertex, b = vertex count, c = start index, d = primitive count
+//   DrawInstanced    a = instance buffer, b = first instance, c = primitive count, d = instance count
+struct RenderCommand {
+    enum Type : uint8_t {
+        SetTransform, SetRenderState, SetMaterial, SetLight, EnableLight,
+        SetVertexBuffer, SetIndexBuffer, SetTexture, Draw, DrawIndexed, DrawInstanced
+    };
+
+    Type type;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+    uint32_t d = 0;
+};
+
+struct RenderStats {
+    uint32_t drawCalls = 0;
+    uint32_t instances = 0;             // objects drawn, counting each instance of an instanced call
+    uint32_t primitives = 0;
+    uint32_t stateChanges = 0;          // render states, bindings and transforms that changed a value
+    uint32_t redundantStateChanges = 0; // the same calls setting the value already current
+};
+
+// Backend without a GPU: tracks device state, hands out resource handles and
+// records every call, so tests and benchmarks can inspect or count submission.
+class NullRenderDevice : public RenderDevice {
+public:
+    NullRenderDevice();
+
+    BufferHandle createVertexBuffer(const void* data, uint32_t size, const VertexLayout& layout) override;
+    BufferHandle createIndexBuffer(const void* data, uint32_t size, IndexFormat format) override;
+    bool updateVertexBuffer(BufferHandle buffer, const void* data, uint32_t size) override;
+    void destroyBuffer(BufferHandle buffer) override;
+    bool supportsVertexFormat(VertexElementFormat format) const override;
+
+    TextureHandle createTextureFromFile(const char* path) override;
+    TextureHandle createSolidTexture(uint32_t width, uint32_t height, uint32_t argb) override;
+    void destroyTexture(TextureHandle texture) override;
+
+    void setTransform(TransformSlot slot, const Mat4& matrix) override;
+    Mat4 getTransform(TransformSlot slot) const override;
+    void setRenderState(RenderState state, uint32_t value) override;
+    uint32_t getRenderState(RenderState state) const override;
+    void setMaterial(const Material& material) override;
+    void setLight(uint32_t index, const LightDesc& light) override;
+    void enableLight(uint32_t index, bool enabled) override;
+
+    void setVertexBuffer(BufferHandle buffer) override;
+    void setIndexBuffer(BufferHandle buffer) override;
+    void setTexture(uint32_t stage, TextureHandle texture) override;
+
+    void draw(PrimitiveType type, uint32_t startVertex, uint32_t primitiveCount) override;
+    void drawIndexed(PrimitiveType type, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount) override;
+
+    bool supportsInstancing() const override { return instancing; }
+    bool supportsIndex32() const override { return index32; }
+    void drawIndexedInstanced(PrimitiveType type, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount,
+        BufferHandle instances, uint32_t firstInstance, uint32_t instanceCount) override;
+
+    // Recording can be switched off to measure submission without the stream's cost
+    void setRecording(bool enabled) { recording = enabled; }
+
+    // Lets callers exercise both their instanced and per-object paths
+    void setInstancingSupported(bool supported) { instancing = supported; }
+    void setIndex32Supported(bool supported) { index32 = supported; }
+    void setPackedVertexFormatsSupported(bool supported) { packedFormats = supported; }
+
+    const std::vector<RenderCommand>& getCommands() const { return commands; }
+    const std::vector<Mat4>& getMatrices() const { return matrices; }
+    const RenderStats& getStats() const { return stats; }
+    size_t getLiveBufferCount() const { return liveBuffers; }
+    size_t getVertexBytes() const { return vertexBytes; }       // held by live vertex buffers
+    size_t getLiveTextureCount() const { return liveTextures; }
+
+    // Drops the recorded stream and counters, e.g. between frames; state and resources stay
+    void resetFrame();
+
+private:
+    void record(RenderCommand::Type type, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0);
+    void countChange(bool changed);
+
+    static constexpr int MaxTextureStages = 8;
+
+    Mat4 transforms[3];
+    uint32_t states[static_cast<int>(RenderState::Count)] = {};
+    BufferHandle vertexBuffer = NullHandle;
+    BufferHandle indexBuffer = NullHandle;
+    TextureHandle textures[MaxTextureStages] = {};
+
+    // Handles count up and are never reused, so a stale handle is easy to spot
+    uint32_t nextHandle = 1;
+    size_t liveBuffers = 0;
+    size_t vertexBytes = 0;
+    std::vector<uint32_t> bufferSizes;  // vertex bytes by handle - 1, 0 for index buffers
+    size_t liveTextures = 0;
+
+    bool instancing = true;
+    bool index32 = true;
+    bool packedFormats = true;
+    bool recording = true;
+    std::vector<RenderCommand> commands;
+    std::vector<Mat4> matrices;
+    RenderStats stats;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Mat4.h"
+#include "VertexLayout.h"
+#include <algorithm>
+#include <cstdint>
+
+// Linear RGBA; same layout as D3DCOLORVALUE
+struct Color {
+    float r, g, b, a;
+};
+
+// Packs to 0xAARRGGBB, clamping each channel to [0, 1]
+inline uint32_t packColor(const Color& c) {
+    auto channel = [](float v) { return static_cast<uint32_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return (channel(c.a) << 24) | (channel(c.r) << 16) | (channel(c.g) << 8) | channel(c.b);
+}
+
+enum class IndexFormat { Index16, Index32 };
+enum class PrimitiveType { TriangleList, LineList };
+enum class TransformSlot { World, View, Projection };
+
+enum class CullMode : uint32_t { None, Clockwise, CounterClockwise };
+enum class CompareFunc : uint32_t { Less, LessEqual, Always };
+
+// Values are bools, CullMode, CompareFunc or a packed color, as noted
+enum class RenderState {
+    DepthTest,      // bool
+    DepthFunc,      // CompareFunc
+    Cull,           // CullMode
+    Lighting,       // bool
+    Ambient,        // packColor()
+    Count
+};
+
+struct Material {
+    Color diffuse;
+    Color ambient;
+};
+
+enum class LightKind { Directional, Point, Spot };
+
+struct LightDesc {
+    LightKind kind = LightKind::Point;
+    Color diffuse{ 1, 1, 1, 1 };
+    Vec3 position;
+    Vec3 direction{ 0, 0, 1 };
+    float range = 0.0f;
+    float attenuation[3] = { 1.0f, 0.0f, 0.0f };
+    float innerAngle = 0.0f;    // spot cone, radians
+    float outerAngle = 0.0f;
+    float falloff = 1.0f;
+};
+
+// 0 is never a live resource
+using BufferHandle = uint32_t;
+using TextureHandle = uint32_t;
+constexpr uint32_t NullHandle = 0;
+
+// What the scene and its components submit rendering through. The D3D9 backend
+// drives the editor's device; NullRenderDevice records the stream instead, so
+// submission can run and be measured without a GPU or Windows headers.
+class RenderDevice {
+public:
+    virtual ~RenderDevice() = default;
+
+    // Buffers filled from data, which may be null to leave them uninitialized,
+    // e.g. for a vertex buffer written later with updateVertexBuffer(); sizes are
+    // in bytes. Vertex data is already packed to the layout, which has to use
+    // supported formats only.
+    virtual BufferHandle createVertexBuffer(const void* data, uint32_t size, const VertexLayout& layout) = 0;
+    virtual BufferHandle createIndexBuffer(const void* data, uint32_t size, IndexFormat format) = 0;
+    virtual bool updateVertexBuffer(BufferHandle buffer, const void* data, uint32_t size) = 0;
+    virtual void destroyBuffer(BufferHandle buffer) = 0;
+    virtual bool supportsVertexFormat(VertexElementFormat format) const = 0;
+
+    virtual TextureHandle createTextureFromFile(const char* path) = 0;
+    virtual TextureHandle createSolidTexture(uint32_t width, uint32_t height, uint32_t argb) = 0;
+    virtual void destroyTexture(TextureHandle texture) = 0;
+
+    virtual void setTransform(TransformSlot slot, const Mat4& matrix) = 0;
+    virtual Mat4 getTransform(TransformSlot slot) const = 0;
+    virtual void setRenderState(RenderState state, uint32_t value) = 0;
+    virtual uint32_t getRenderState(RenderState state) const = 0;
+    virtual void setMaterial(const Material& material) = 0;
+    virtual void setLight(uint32_t index, const LightDesc& light) = 0;
+    virtual void enableLight(uint32_t index, bool enabled) = 0;
+
+    virtual void setVertexBuffer(BufferHandle buffer) = 0;
+    virtual void setIndexBuffer(BufferHandle buffer) = 0;
+    virtual void setTexture(uint32_t stage, TextureHandle texture) = 0;
+
+    // Indexed draws add baseVertex to every index; vertexCount is the span of
+    // vertices the indices reach from there
+    virtual void draw(PrimitiveType type, uint32_t startVertex, uint32_t primitiveCount) = 0;
+    virtual void drawIndexed(PrimitiveType type, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount) = 0;
+
+    // Draws the bound mesh once per world matrix in instances[firstInstance, +instanceCount),
+    // lit by the current lights and material. Only valid when supportsInstancing().
+    virtual bool supportsInstancing() const = 0;
+    virtual bool supportsIndex32() const = 0;
+    virtual void drawIndexedInstanced(PrimitiveType type, int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount,
+        BufferHandle instances, uint32_t firstInstance, uint32_t instanceCount) = 0;
+};
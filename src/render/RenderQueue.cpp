@@ -0,0 +1,248 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+void RenderQueue::begin(const RenderDevice& device)
+{
+    const Mat4 view = device.getTransform(TransformSlot::View);
+    const Mat4 projection = device.getTransform(TransformSlot::Projection);
+    const Mat4 viewProjection = view * projection;
+
+    viewZ = { view.m[0][2], view.m[1][2], view.m[2][2] };
+    viewZOffset = view.m[3][2];
+    frustum = Frustum::fromViewProjection(viewProjection.data());
+    cameraPosition = inverse(view).getTranslation();
+    projectionScale = projection.m[1][1];
+    cullBackfaces = device.getRenderState(RenderState::Cull) == static_cast<uint32_t>(CullMode::CounterClockwise);
+    stats = RenderQueueStats();
+
+    packets.clear();
+    entries.clear();
+    materials.clear();
+}
+
+void RenderQueue::push(RenderPass pass, const Material& material, BufferHandle vertexBuffer, BufferHandle indexBuffer,
+    int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount, const Mat4& world)
+{
+    const uint32_t materialIndex = internMaterial(material);
+    packets.push_back({ vertexBuffer, indexBuffer, baseVertex, vertexCount, startIndex, primitiveCount, materialIndex, world });
+
+    // Sorting on the object's origin is enough to get most of early-z
+    const float depth = dot(world.getTranslation(), viewZ) + viewZOffset;
+    entries.push_back({ makeKey(pass, materialIndex, vertexBuffer, depth), static_cast<uint32_t>(packets.size() - 1) });
+}
+
+uint64_t RenderQueue::makeKey(RenderPass pass, uint32_t material, uint32_t mesh, float depth)
+{
+    // Non-negative floats order the same as their bits; behind the camera is 0
+    uint32_t depthBits = 0;
+    if (depth > 0.0f) std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    if (pass == RenderPass::Transparent) depthBits = ~depthBits;
+
+    return (static_cast<uint64_t>(pass) << 62)
+        | (static_cast<uint64_t>(material & (MaxMaterials - 1)) << 48)
+        | (static_cast<uint64_t>(mesh & 0xFFFF) << 32)
+        | depthBits;
+}
+
+uint32_t RenderQueue::internMaterial(const Material& material)
+{
+    for (size_t i = 0; i < materials.size(); ++i) {
+        if (std::memcmp(&materials[i], &material, sizeof(Material)) == 0) return static_cast<uint32_t>(i);
+    }
+
+    assert(materials.size() < MaxMaterials);
+    materials.push_back(material);
+    return static_cast<uint32_t>(materials.size() - 1);
+}
+
+// LSD radix sort, one byte per pass. All eight histograms come from a single
+// read of the keys, and a pass whose byte is the same everywhere is skipped,
+// which in practice drops the unused pass and material bits.
+void RenderQueue::sortEntries()
+{
+    const size_t count = entries.size();
+    if (count < 2) return;
+
+    uint32_t histograms[8][256] = {};
+    for (const SortEntry& entry : entries) {
+        for (int pass = 0; pass < 8; ++pass) {
+            ++histograms[pass][(entry.key >> (pass * 8)) & 0xFF];
+        }
+    }
+
+    scratch.resize(count);
+    SortEntry* src = entries.data();
+    SortEntry* dst = scratch.data();
+
+    for (int pass = 0; pass < 8; ++pass) {
+        uint32_t* histogram = histograms[pass];
+        const int shift = pass * 8;
+        if (histogram[(src[0].key >> shift) & 0xFF] == count) continue;
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            const uint32_t n = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != entries.data()) entries.swap(scratch);
+}
+
+void RenderQueue::buildRuns(bool instancing)
+{
+    runs.clear();
+    instanceData.clear();
+
+    const uint32_t count = static_cast<uint32_t>(entries.size());
+    uint32_t begin = 0;
+    while (begin < count) {
+        const DrawPacket& first = packets[entries[begin].packet];
+
+        // Same pass, material and mesh bits; those only hold part of the handle, so
+        // check the buffers too, and the index range since clusters draw parts of a mesh
+        uint32_t end = begin + 1;
+        while (end < count && (entries[end].key >> 32) == (entries[begin].key >> 32)) {
+            const DrawPacket& next = packets[entries[end].packet];
+            if (next.vertexBuffer != first.vertexBuffer || next.indexBuffer != first.indexBuffer
+                || next.startIndex != first.startIndex || next.primitiveCount != first.primitiveCount
+                || next.baseVertex != first.baseVertex) break;
+            ++end;
+        }
+
+        // Transparent draws keep their back-to-front order
+        const bool opaque = (entries[begin].key >> 62) == static_cast<uint64_t>(RenderPass::Opaque);
+        if (instancing && opaque && end - begin >= MinInstances) {
+            runs.push_back({ begin, end, static_cast<uint32_t>(instanceData.size()) });
+            for (uint32_t i = begin; i < end; ++i) {
+                instanceData.push_back(packets[entries[i].packet].world);
+            }
+        }
+        else {
+            runs.push_back({ begin, end, NoInstances });
+        }
+        begin = end;
+    }
+}
+
+bool RenderQueue::uploadInstances(RenderDevice& device)
+{
+    if (instanceData.empty()) return true;
+    if (instanceDevice && instanceDevice != &device) releaseDeviceObjects();
+
+    const uint32_t needed = static_cast<uint32_t>(instanceData.size());
+    if (needed > instanceCapacity) {
+        if (instanceDevice) instanceDevice->destroyBuffer(instanceBuffer);
+
+        // Grow geometrically so a scene that keeps adding props reallocates rarely
+        const uint32_t capacity = std::max({ needed, instanceCapacity * 2, 256u });
+        instanceBuffer = device.createVertexBuffer(nullptr, capacity * sizeof(Mat4), VertexLayout::instance());
+        if (instanceBuffer == NullHandle) {
+            instanceDevice = nullptr;
+            instanceCapacity = 0;
+            return false;
+        }
+        instanceDevice = &device;
+        instanceCapacity = capacity;
+    }
+
+    return device.updateVertexBuffer(instanceBuffer, instanceData.data(), needed * sizeof(Mat4));
+}
+
+void RenderQueue::releaseDeviceObjects()
+{
+    if (instanceDevice) instanceDevice->destroyBuffer(instanceBuffer);
+    instanceDevice = nullptr;
+    instanceBuffer = NullHandle;
+    instanceCapacity = 0;
+}
+
+void RenderQueue::submit(RenderDevice& device)
+{
+    const auto sortStart = std::chrono::steady_clock::now();
+    sortEntries();
+    stats.sortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+
+    if (entries.empty()) return;
+
+    // Without a usable instance buffer every run falls back to per-object draws
+    const bool instancing = instancingEnabled && device.supportsInstancing();
+    buildRuns(instancing);
+    if (instancing && !uploadInstances(device)) buildRuns(false);
+
+    const Mat4 savedWorld = device.getTransform(TransformSlot::World);
+    const uint32_t savedLighting = device.getRenderState(RenderState::Lighting);
+    device.setRenderState(RenderState::Lighting, 1);
+    ++stats.stateChanges;
+
+    BufferHandle boundVertices = NullHandle;
+    BufferHandle boundIndices = NullHandle;
+    uint32_t boundMaterial = UINT32_MAX;
+    const Mat4* boundWorld = nullptr;
+
+    for (const Run& run : runs) {
+        const DrawPacket& first = packets[entries[run.begin].packet];
+
+        if (first.material != boundMaterial) {
+            device.setMaterial(materials[first.material]);
+            boundMaterial = first.material;
+            ++stats.stateChanges;
+        }
+        else ++stats.skippedChanges;
+
+        if (first.vertexBuffer != boundVertices) {
+            device.setVertexBuffer(first.vertexBuffer);
+            boundVertices = first.vertexBuffer;
+            ++stats.stateChanges;
+        }
+        else ++stats.skippedChanges;
+
+        if (first.indexBuffer != boundIndices) {
+            device.setIndexBuffer(first.indexBuffer);
+            boundIndices = first.indexBuffer;
+            ++stats.stateChanges;
+        }
+        else ++stats.skippedChanges;
+
+        if (run.firstInstance != NoInstances) {
+            const uint32_t count = run.end - run.begin;
+            device.drawIndexedInstanced(PrimitiveType::TriangleList, first.baseVertex, first.vertexCount,
+                first.startIndex, first.primitiveCount,
+                instanceBuffer, run.firstInstance, count);
+            ++stats.draws;
+            ++stats.instancedDraws;
+            stats.instances += count;
+            stats.primitives += first.primitiveCount * count;
+            continue;
+        }
+
+        for (uint32_t i = run.begin; i < run.end; ++i) {
+            const DrawPacket& packet = packets[entries[i].packet];
+
+            if (!boundWorld || std::memcmp(boundWorld, &packet.world, sizeof(Mat4)) != 0) {
+                device.setTransform(TransformSlot::World, packet.world);
+                boundWorld = &packet.world;
+                ++stats.stateChanges;
+            }
+            else ++stats.skippedChanges;
+
+            device.drawIndexed(PrimitiveType::TriangleList, packet.baseVertex, packet.vertexCount,
+                packet.startIndex, packet.primitiveCount);
+            ++stats.draws;
+            stats.primitives += packet.primitiveCount;
+        }
+    }
+
+    device.setTransform(TransformSlot::World, savedWorld);
+    device.setRenderState(RenderState::Lighting, savedLighting);
+    entries.clear();
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include "Bounds.h"
+#include <vector>
+#include <cstdint>
+
+// Passes draw in enum order; opaque front to back, transparent back to front
+enum class RenderPass : uint8_t { Opaque, Transparent };
+
+// One indexed draw, everything needed to submit it without the component
+struct DrawPacket {
+    BufferHandle vertexBuffer;
+    BufferHandle indexBuffer;
+    int32_t baseVertex;
+    uint32_t vertexCount;
+    uint32_t startIndex;
+    uint32_t primitiveCount;
+    uint32_t material;      // index into the queue's material table
+    Mat4 world;
+};
+
+struct RenderQueueStats {
+    uint32_t draws = 0;
+    uint32_t instancedDraws = 0;    // draws covering a whole run of identical packets
+    uint32_t instances = 0;         // packets drawn through those
+    uint32_t primitives = 0;
+    uint32_t stateChanges = 0;      // bindings, materials and transforms sent to the device
+    uint32_t skippedChanges = 0;    // the same, dropped because the value was already bound
+    uint32_t culledClusters = 0;    // mesh clusters rejected before they became packets
+    uint32_t reducedDraws = 0;      // meshes drawn at one of their simplified levels
+    double sortMilliseconds = 0.0;
+};
+
+// Collects the frame's draws, sorts them by a 64-bit key and submits them in
+// order, binding buffers and materials only when they change. Key layout, most
+// significant first:
+//   63..62  pass
+//   61..48  material
+//   47..32  mesh (vertex buffer)
+//   31..0   view depth, float bits; inverted for transparent draws
+// so state changes sort out of the way before depth does. That also puts every
+// opaque packet sharing a material and mesh next to each other; when the device
+// supports it, runs of at least MinInstances are drawn with one instanced call
+// whose world matrices go into a per-frame instance buffer.
+class RenderQueue {
+public:
+    // Starts a frame with the device's current camera: depth is measured along
+    // the view's z axis, and the frustum and cull mode are kept for cluster culling
+    void begin(const RenderDevice& device);
+
+    void push(RenderPass pass, const Material& material, BufferHandle vertexBuffer, BufferHandle indexBuffer,
+        int32_t baseVertex, uint32_t vertexCount, uint32_t startIndex, uint32_t primitiveCount, const Mat4& world);
+
+    const Frustum& getFrustum() const { return frustum; }
+    const Vec3& getCameraPosition() const { return cameraPosition; }
+
+    // Cotangent of half the vertical field of view: a length s at distance d
+    // covers s * scale / d of half the viewport height
+    float getProjectionScale() const { return projectionScale; }
+    bool isCullingBackfaces() const { return cullBackfaces; }
+    void addCulledClusters(uint32_t count) { stats.culledClusters += count; }
+    void addReducedDraw() { ++stats.reducedDraws; }
+
+    // Sorts and draws everything pushed since begin(), leaving the world
+    // transform and lighting as they were
+    void submit(RenderDevice& device);
+
+    // Frees the instance buffer; due before the device that made it goes away
+    void releaseDeviceObjects();
+
+    void setInstancingEnabled(bool enabled) { instancingEnabled = enabled; }
+
+    size_t size() const { return packets.size(); }
+    const RenderQueueStats& getStats() const { return stats; }
+
+    static uint64_t makeKey(RenderPass pass, uint32_t material, uint32_t mesh, float depth);
+
+private:
+    struct SortEntry {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+    // Consecutive sorted entries [begin, end); firstInstance is NoInstances
+    // when they are drawn one by one
+    struct Run {
+        uint32_t begin;
+        uint32_t end;
+        uint32_t firstInstance;
+    };
+
+    uint32_t internMaterial(const Material& material);
+    void sortEntries();
+    void buildRuns(bool instancing);
+    bool uploadInstances(RenderDevice& device);
+
+    static constexpr uint32_t MaxMaterials = 1u << 14;
+    static constexpr uint32_t MinInstances = 4;
+    static constexpr uint32_t NoInstances = UINT32_MAX;
+
+    Vec3 viewZ;
+    float viewZOffset = 0.0f;
+    Frustum frustum;
+    Vec3 cameraPosition;
+    float projectionScale = 1.0f;
+    bool cullBackfaces = false;
+
+    std::vector<DrawPacket> packets;
+    std::vector<SortEntry> entries;
+    std::vector<SortEntry> scratch;
+    std::vector<Material> materials;    // a handful per frame, found by linear search
+    std::vector<Run> runs;
+
+    bool instancingEnabled = true;
+    std::vector<Mat4> instanceData;
+    RenderDevice* instanceDevice = nullptr;
+    BufferHandle instanceBuffer = NullHandle;
+    uint32_t instanceCapacity = 0;      // in matrices
+
+    RenderQueueStats stats;
+};
@@ -0,0 +1,222 @@
+#include "VertexLayout.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+uint32_t elementSize(VertexElementFormat format)
+{
+    switch (format) {
+    case VertexElementFormat::Float2: return 8;
+    case VertexElementFormat::Float3: return 12;
+    case VertexElementFormat::Float4: return 16;
+    case VertexElementFormat::Half2: return 4;
+    case VertexElementFormat::Short4N: return 8;
+    case VertexElementFormat::Octahedral: return 4;
+    case VertexElementFormat::Color: return 4;
+    case VertexElementFormat::Matrix4: return 64;
+    default: return 0;
+    }
+}
+
+VertexLayout& VertexLayout::set(VertexAttribute attribute, VertexElementFormat format)
+{
+    formats[static_cast<int>(attribute)] = format;
+
+    stride = 0;
+    for (int i = 0; i < AttributeCount; ++i) {
+        offsets[i] = static_cast<uint8_t>(stride);
+        stride += elementSize(formats[i]);
+    }
+    return *this;
+}
+
+void VertexLayout::setPositionRange(const Vec3& min, const Vec3& max)
+{
+    positionBias = (min + max) * 0.5f;
+    positionScale = (max - min) * 0.5f;
+
+    // A flat axis still needs a scale that divides
+    for (int i = 0; i < 3; ++i) {
+        if (positionScale[i] <= 0.0f) positionScale[i] = 1.0f;
+    }
+}
+
+bool VertexLayout::isFixedFunction() const
+{
+    const VertexElementFormat position = format(VertexAttribute::Position);
+    const VertexElementFormat normal = format(VertexAttribute::Normal);
+    const VertexElementFormat color = format(VertexAttribute::Color);
+    const VertexElementFormat texCoord = format(VertexAttribute::TexCoord);
+
+    return (position == VertexElementFormat::Float3 || position == VertexElementFormat::None)
+        && (normal == VertexElementFormat::Float3 || normal == VertexElementFormat::None)
+        && (color == VertexElementFormat::Color || color == VertexElementFormat::None)
+        && (texCoord == VertexElementFormat::Float2 || texCoord == VertexElementFormat::None);
+}
+
+uint32_t VertexLayout::key() const
+{
+    uint32_t result = 0;
+    for (int i = 0; i < AttributeCount; ++i) {
+        result |= static_cast<uint32_t>(formats[i]) << (i * 4);
+    }
+    return result;
+}
+
+VertexLayout VertexLayout::mesh()
+{
+    VertexLayout layout;
+    layout.set(VertexAttribute::Position, VertexElementFormat::Float3)
+        .set(VertexAttribute::Normal, VertexElementFormat::Float3)
+        .set(VertexAttribute::Color, VertexElementFormat::Color)
+        .set(VertexAttribute::TexCoord, VertexElementFormat::Float2);
+    return layout;
+}
+
+VertexLayout VertexLayout::skybox()
+{
+    VertexLayout layout;
+    layout.set(VertexAttribute::Position, VertexElementFormat::Float3)
+        .set(VertexAttribute::TexCoord, VertexElementFormat::Float2);
+    return layout;
+}
+
+VertexLayout VertexLayout::instance()
+{
+    VertexLayout layout;
+    layout.set(VertexAttribute::Instance, VertexElementFormat::Matrix4);
+    return layout;
+}
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    // Too large for a half (or already infinite): infinity; NaN stays NaN
+    if (magnitude >= 0x47800000) {
+        return sign | (magnitude > 0x7F800000 ? 0x7E00 : 0x7C00);
+    }
+
+    // Below the smallest normal half: denormal, or zero
+    if (magnitude < 0x38800000) {
+        if (magnitude < 0x33000000) return sign;
+        const uint32_t exponent = magnitude >> 23;
+        const uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+        const uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1))) ++half;
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    // Rebias the exponent and round the mantissa; a carry correctly bumps the exponent
+    uint32_t half = (magnitude - 0x38000000) >> 13;
+    const uint32_t rest = magnitude & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ++half;
+    return sign | static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t half)
+{
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1F;
+    const uint32_t mantissa = half & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else {
+        const float denormal = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -denormal : denormal;
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int16_t toSnorm16(float value)
+{
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// Projects onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over
+// the diagonals, so x and y alone identify the direction. Zero comes out as +z.
+static void encodeOctahedral(const Vec3& n, int16_t out[2])
+{
+    const float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    float x = sum > 0.0f ? n.x / sum : 0.0f;
+    float y = sum > 0.0f ? n.y / sum : 0.0f;
+    if (n.z < 0.0f) {
+        const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    out[0] = toSnorm16(x);
+    out[1] = toSnorm16(y);
+}
+
+void packVertices(const Vertex* vertices, size_t count, const VertexLayout& layout, void* out)
+{
+    uint8_t* dst = static_cast<uint8_t*>(out);
+
+    const VertexElementFormat positionFormat = layout.format(VertexAttribute::Position);
+    const VertexElementFormat normalFormat = layout.format(VertexAttribute::Normal);
+    const VertexElementFormat colorFormat = layout.format(VertexAttribute::Color);
+    const VertexElementFormat texCoordFormat = layout.format(VertexAttribute::TexCoord);
+    const Vec3 toStored(1.0f / layout.positionScale.x, 1.0f / layout.positionScale.y, 1.0f / layout.positionScale.z);
+
+    for (size_t i = 0; i < count; ++i, dst += layout.stride) {
+        const Vertex& v = vertices[i];
+
+        uint8_t* position = dst + layout.offset(VertexAttribute::Position);
+        if (positionFormat == VertexElementFormat::Float3) {
+            const float p[3] = { v.x, v.y, v.z };
+            std::memcpy(position, p, sizeof(p));
+        }
+        else if (positionFormat == VertexElementFormat::Short4N) {
+            const Vec3 stored = mul(Vec3(v.x, v.y, v.z) - layout.positionBias, toStored);
+            const int16_t q[4] = { toSnorm16(stored.x), toSnorm16(stored.y), toSnorm16(stored.z), 32767 };
+            std::memcpy(position, q, sizeof(q));
+        }
+
+        const Vec3 n = normalize(Vec3(v.nx, v.ny, v.nz));
+        uint8_t* normal = dst + layout.offset(VertexAttribute::Normal);
+        if (normalFormat == VertexElementFormat::Float3) {
+            const float f[3] = { n.x, n.y, n.z };
+            std::memcpy(normal, f, sizeof(f));
+        }
+        else if (normalFormat == VertexElementFormat::Short4N) {
+            const int16_t q[4] = { toSnorm16(n.x), toSnorm16(n.y), toSnorm16(n.z), 0 };
+            std::memcpy(normal, q, sizeof(q));
+        }
+        else if (normalFormat == VertexElementFormat::Octahedral) {
+            int16_t q[2];
+            encodeOctahedral(n, q);
+            std::memcpy(normal, q, sizeof(q));
+        }
+
+        if (colorFormat == VertexElementFormat::Color) {
+            std::memcpy(dst + layout.offset(VertexAttribute::Color), &v.color, sizeof(v.color));
+        }
+
+        uint8_t* texCoord = dst + layout.offset(VertexAttribute::TexCoord);
+        if (texCoordFormat == VertexElementFormat::Float2) {
+            const float uv[2] = { v.u, v.v };
+            std::memcpy(texCoord, uv, sizeof(uv));
+        }
+        else if (texCoordFormat == VertexElementFormat::Half2) {
+            const uint16_t uv[2] = { floatToHalf(v.u), floatToHalf(v.v) };
+            std::memcpy(texCoord, uv, sizeof(uv));
+        }
+    }
+}
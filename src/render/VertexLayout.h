@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Vec.h"
+#include <cstddef>
+#include <cstdint>
+
+// Mesh vertex as loaded, at full precision; what reaches the GPU is described
+// by the mesh's VertexLayout and packed from this
+struct Vertex {
+    float x, y, z;
+    float nx, ny, nz;
+    uint32_t color;         // 0xAARRGGBB
+    float u, v;
+};
+
+struct SkyboxVertex {
+    float x, y, z;
+    float u, v;
+};
+
+// Instance is a per-instance world matrix, read from the second stream of an instanced draw
+enum class VertexAttribute : uint8_t { Position, Normal, Color, TexCoord, Instance, Count };
+
+// Storage of one attribute. Short4N is four signed 16-bit values normalized to
+// [-1, 1]; Octahedral is a unit vector folded onto a square and stored as two of them.
+enum class VertexElementFormat : uint8_t {
+    None, Float2, Float3, Float4, Half2, Short4N, Octahedral, Color, Matrix4
+};
+
+uint32_t elementSize(VertexElementFormat format);
+
+// Which attributes a vertex buffer holds and in what format. Elements follow
+// attribute order without padding, the order fixed-function vertices use.
+// Quantized positions decode as stored * positionScale + positionBias, which
+// setPositionRange() points at the mesh bounds.
+struct VertexLayout {
+    static constexpr int AttributeCount = static_cast<int>(VertexAttribute::Count);
+
+    VertexElementFormat formats[AttributeCount] = {};
+    uint8_t offsets[AttributeCount] = {};
+    uint32_t stride = 0;
+    Vec3 positionScale{ 1.0f, 1.0f, 1.0f };
+    Vec3 positionBias;
+
+    VertexLayout& set(VertexAttribute attribute, VertexElementFormat format);
+    void setPositionRange(const Vec3& min, const Vec3& max);
+
+    VertexElementFormat format(VertexAttribute attribute) const { return formats[static_cast<int>(attribute)]; }
+    uint32_t offset(VertexAttribute attribute) const { return offsets[static_cast<int>(attribute)]; }
+    bool has(VertexAttribute attribute) const { return format(attribute) != VertexElementFormat::None; }
+
+    // True when fixed-function vertex processing can read every element as stored
+    bool isFixedFunction() const;
+
+    // Same for layouts with the same formats, e.g. to cache a declaration per layout
+    uint32_t key() const;
+
+    static VertexLayout mesh();     // Vertex as is
+    static VertexLayout skybox();
+    static VertexLayout instance();
+};
+
+// Writes count vertices in the layout's formats; out holds count * stride bytes.
+// Normals are normalized on the way, whatever their format.
+void packVertices(const Vertex* vertices, size_t count, const VertexLayout& layout, void* out);
+
+// IEEE half precision, rounded to nearest even
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t half);
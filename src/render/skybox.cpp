@@ -2,19 +2,15 @@
 #include "Skybox.h"
 #include <QDebug>
 
-struct SkyboxVertex {
-    float x, y, z;
-    float u, v;
-};
-
-#define D3DFVF_SKYBOX (D3DFVF_XYZ | D3DFVF_TEX1)
-
 Skybox::Skybox() {}
 Skybox::~Skybox() {
     cleanup();
 }
 
-bool Skybox::initialize(LPDIRECT3DDEVICE9 device, const char* texturePath) {
+bool Skybox::initialize(RenderDevice& device, const char* texturePath) {
+    cleanup();
+    this->device = &device;
+
     SkyboxVertex vertices[] = {
         // edge +Z
         { -1,  1,  1, 0, 0 }, { 1,  1,  1, 1, 0 }, { 1, -1,  1, 1, 1 },
@@ -36,56 +32,44 @@ bool Skybox::initialize(LPDIRECT3DDEVICE9 device, const char* texturePath) {
         { -1, -1,  1, 0, 0 }, {  1, -1, -1, 1, 1 }, { -1, -1, -1, 0, 1 },
     };
 
-    if (FAILED(device->CreateVertexBuffer(sizeof(vertices), 0, D3DFVF_SKYBOX,
-        D3DPOOL_MANAGED, &vertexBuffer, nullptr))) {
+    vertexBuffer = device.createVertexBuffer(vertices, sizeof(vertices), VertexLayout::skybox());
+    if (vertexBuffer == NullHandle) {
         ConsolePanel::sError("Failed to create vertex buffer");
         return false;
     }
 
-    void* data = nullptr;
-    vertexBuffer->Lock(0, sizeof(vertices), &data, 0);
-    memcpy(data, vertices, sizeof(vertices));
-    vertexBuffer->Unlock();
-
     if (texturePath && *texturePath) {
-        if (FAILED(D3DXCreateTextureFromFileA(device, texturePath, &texture))) {
+        texture = device.createTextureFromFile(texturePath);
+        if (texture == NullHandle) {
             ConsolePanel::sError("Failed to load skybox texture from: " + QString(texturePath));
             return false;
         }
     }
     else {
-        if (FAILED(device->CreateTexture(256, 256, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &texture, nullptr))) {
+        texture = device.createSolidTexture(256, 256, 0xFFFFFFFF);
+        if (texture == NullHandle) {
             ConsolePanel::sError("Failed to create fallback texture");
             return false;
         }
-        D3DLOCKED_RECT rect;
-        texture->LockRect(0, &rect, nullptr, 0);
-        uint32_t* pixels = static_cast<uint32_t*>(rect.pBits);
-        for (int i = 0; i < 256 * 256; ++i) {
-            pixels[i] = 0xFFFFFFFF;
-        }
-        texture->UnlockRect(0);
     }
 
     return true;
 }
 
-void Skybox::draw(LPDIRECT3DDEVICE9 device) {
+void Skybox::draw(RenderDevice& device) {
     if (!vertexBuffer || !texture) return;
 
-    device->SetStreamSource(0, vertexBuffer, 0, sizeof(SkyboxVertex));
-    device->SetFVF(D3DFVF_SKYBOX);
-    device->SetTexture(0, texture);
-    device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 12);
+    device.setVertexBuffer(vertexBuffer);
+    device.setTexture(0, texture);
+    device.draw(PrimitiveType::TriangleList, 0, 12);
 }
 
 void Skybox::cleanup() {
-    if (vertexBuffer) {
-        vertexBuffer->Release();
-        vertexBuffer = nullptr;
-    }
-    if (texture) {
-        texture->Release();
-        texture = nullptr;
+    if (device) {
+        device->destroyBuffer(vertexBuffer);
+        device->destroyTexture(texture);
     }
+    device = nullptr;
+    vertexBuffer = NullHandle;
+    texture = NullHandle;
 }
\ No newline at end of file
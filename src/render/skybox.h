@@ -1,17 +1,17 @@
 #pragma once
-#include <d3d9.h>
-#include <d3dx9.h>
+#include "RenderDevice.h"
 
 class Skybox {
 public:
     Skybox();
     ~Skybox();
 
-    bool initialize(LPDIRECT3DDEVICE9 device, const char* texturePath);
+    bool initialize(RenderDevice& device, const char* texturePath);
     void cleanup();
-    void draw(LPDIRECT3DDEVICE9 device);
+    void draw(RenderDevice& device);
 
 private:
-    LPDIRECT3DVERTEXBUFFER9 vertexBuffer = nullptr;
-    LPDIRECT3DTEXTURE9 texture = nullptr;
+    RenderDevice* device = nullptr;
+    BufferHandle vertexBuffer = NullHandle;
+    TextureHandle texture = NullHandle;
 };
\ No newline at end of file
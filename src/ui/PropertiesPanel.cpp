@@ -5,6 +5,8 @@ PropertiesPanel::PropertiesPanel(Scene* scene, QWidget* parent) : QWidget(parent
     vbox = new QVBoxLayout(this);
     formLayout = new QFormLayout();
     vbox->addLayout(formLayout);
+
+    connect(scene, &Scene::objectsChanged, this, &PropertiesPanel::onObjectsChanged);
 }
 
 void PropertiesPanel::clearPanel()
@@ -15,10 +17,20 @@ void PropertiesPanel::clearPanel()
     }
 }
 
-void PropertiesPanel::onObjectSelected(QPointer<SceneObject> obj)
+void PropertiesPanel::onObjectsChanged()
+{
+    // Inspector widgets point into the object's components, drop them with it
+    if (!currentHandle.isNull() && !scene->isValid(currentHandle)) {
+        currentHandle = EntityHandle();
+        clearPanel();
+    }
+}
+
+void PropertiesPanel::onObjectSelected(EntityHandle handle)
 {
     clearPanel();
-    currentObject = obj;
+    currentHandle = handle;
+    SceneObject* currentObject = scene->getObject(currentHandle);
     if (!currentObject) return;
 
     for (auto* comp : currentObject->getAllComponents()) {
@@ -32,7 +44,7 @@ void PropertiesPanel::onObjectSelected(QPointer<SceneObject> obj)
     delBtn = new QPushButton("Delete Object", this);
     delBtn->setStyleSheet("background-color: #c0392b; color: white;");
     connect(delBtn, &QPushButton::clicked, [this]() {
-        if (currentObject) {
+        if (SceneObject* currentObject = scene->getObject(currentHandle)) {
             auto reply = QMessageBox::question(
                 this,
                 "Delete Object",
@@ -41,7 +53,7 @@ void PropertiesPanel::onObjectSelected(QPointer<SceneObject> obj)
             );
 
             if (reply == QMessageBox::Yes) {
-                scene->removeObject(currentObject);
+                scene->removeObject(currentHandle);
                 clearPanel();
             }
         }
@@ -56,6 +68,7 @@ void PropertiesPanel::updateUI()
 
 void PropertiesPanel::onAddComponent()
 {
+    SceneObject* currentObject = scene->getObject(currentHandle);
     if (!currentObject) return;
     QStringList availableComponents;
 
@@ -96,5 +109,5 @@ void PropertiesPanel::onAddComponent()
         currentObject->addComponent<SphereColliderComponent>();
     }
 
-    onObjectSelected(currentObject);
+    onObjectSelected(currentHandle);
 }
\ No newline at end of file
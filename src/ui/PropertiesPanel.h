@@ -20,7 +20,7 @@ public:
     explicit PropertiesPanel(Scene* scene, QWidget* parent = nullptr);
 
 public slots:
-    void onObjectSelected(QPointer<SceneObject> obj);
+    void onObjectSelected(EntityHandle handle);
     void updateUI();
 
 private slots:
@@ -28,11 +28,12 @@ private slots:
 
 private:
     void clearPanel();
+    void onObjectsChanged();
 
     Scene* scene;
     QVBoxLayout* vbox;
     QFormLayout* formLayout;
-    QPointer<SceneObject> currentObject;
+    EntityHandle currentHandle;
     QLayoutItem* layItem;
     QString selected;
 
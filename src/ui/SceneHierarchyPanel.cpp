@@ -1,9 +1,12 @@
 ﻿#include "SceneHierarchyPanel.h"
+#include "Prefab.h"
 #include "Scene.h"
 #include "SceneObject.h"
 
 #include <QVBoxLayout>
 #include <QLabel>
+#include <QDropEvent>
+#include <unordered_set>
 
 SceneHierarchyPanel::SceneHierarchyPanel(Scene* scene, QWidget* parent) : QWidget(parent), scene(scene)
 {
@@ -16,6 +19,8 @@ SceneHierarchyPanel::SceneHierarchyPanel(Scene* scene, QWidget* parent) : QWidge
 
     treeWidget = new QTreeWidget();
     treeWidget->setHeaderHidden(true);
+    treeWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    treeWidget->setDragDropMode(QAbstractItemView::InternalMove);
     layout->addWidget(treeWidget);
 
     setStyleSheet("background-color: #2d2d30; color: white;");
@@ -24,12 +29,14 @@ SceneHierarchyPanel::SceneHierarchyPanel(Scene* scene, QWidget* parent) : QWidge
     treeWidget->viewport()->installEventFilter(this);
 
     connect(treeWidget, &QTreeWidget::itemSelectionChanged, this, &SceneHierarchyPanel::onItemSelectionChanged);
-    connect(scene, &Scene::objectAdded, this, &SceneHierarchyPanel::updateHierarchy);
-    connect(scene, &Scene::objectRemoved, this, &SceneHierarchyPanel::updateHierarchy);
+    connect(scene, &Scene::objectsChanged, this, &SceneHierarchyPanel::onObjectsChanged);
+    connect(scene, &Scene::objectsModified, this, &SceneHierarchyPanel::onObjectsModified);
     connect(treeWidget, &QTreeWidget::itemChanged, this, &SceneHierarchyPanel::onItemEdited);
 
     contextMenu = new QMenu(this);
     renameAction = contextMenu->addAction("Rename");
+    duplicateAction = contextMenu->addAction("Duplicate");
+    prefabAction = contextMenu->addAction("Create Prefab");
     deleteAction = contextMenu->addAction("Delete");
 
     connect(renameAction, &QAction::triggered, [this]() {
@@ -38,14 +45,16 @@ SceneHierarchyPanel::SceneHierarchyPanel(Scene* scene, QWidget* parent) : QWidge
         }
     });
 
+    connect(duplicateAction, &QAction::triggered, [this]() {
+        duplicateSelectedObjects();
+    });
+
+    connect(prefabAction, &QAction::triggered, [this]() {
+        createPrefabsFromSelection();
+    });
+
     connect(deleteAction, &QAction::triggered, [this]() {
-        auto selectedItems = treeWidget->selectedItems();
-        if (!selectedItems.isEmpty()) {
-            auto* item = selectedItems.first();
-            if (auto obj = itemObjectMap.value(item)) {
-                this->scene->removeObject(obj.data());
-            }
-        }
+        removeSelectedObjects();
     });
 
     treeWidget->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -57,43 +66,119 @@ SceneHierarchyPanel::SceneHierarchyPanel(Scene* scene, QWidget* parent) : QWidge
 }
 
 void SceneHierarchyPanel::updateHierarchy() {
-    SceneObject* oldObj = nullptr;
+    EntityHandle oldHandle;
     if (auto* oldItem = treeWidget->currentItem()) {
-        auto ptr = itemObjectMap.value(oldItem);
-        oldObj = ptr.data();
-    }
-
-    for (auto it = itemObjectMap.keyBegin(); it != itemObjectMap.keyEnd(); ++it) {
-        if (auto obj = itemObjectMap.value(*it)) {
-            disconnect(obj, &SceneObject::nameChanged,
-                this, &SceneHierarchyPanel::onObjectNameChanged);
-        }
+        oldHandle = itemObjectMap.value(oldItem);
     }
 
     treeWidget->clear();
     itemObjectMap.clear();
+    handleItemMap.clear();
 
     treeWidget->blockSignals(true);
     for (const auto& objPtr : scene->getObjects()) {
-        auto* item = new QTreeWidgetItem(treeWidget);
-        item->setText(0, QString::fromStdString(objPtr->getName()));
-        item->setFlags(item->flags() | Qt::ItemIsEditable);
+        addItem(objPtr.get());
+    }
+    for (const auto& objPtr : scene->getObjects()) {
+        placeItem(objPtr->getHandle());
+    }
+    treeWidget->blockSignals(false);
+
+    auto it = handleItemMap.find(oldHandle);
+    if (it != handleItemMap.end()) {
+        treeWidget->setCurrentItem(it->second);
+    }
+}
 
-        itemObjectMap[item] = QPointer<SceneObject>(objPtr.get());
+void SceneHierarchyPanel::onObjectsChanged(const SceneChangeSet& changes)
+{
+    // Patch only the affected rows instead of rebuilding the whole tree
+    bool selectionLost = false;
 
-        connect(objPtr.get(), &SceneObject::nameChanged,
-            this, &SceneHierarchyPanel::onObjectNameChanged);
+    treeWidget->setUpdatesEnabled(false);
+    treeWidget->blockSignals(true);
+
+    if (changes.cleared) {
+        selectionLost = !treeWidget->selectedItems().isEmpty();
+        treeWidget->clear();
+        itemObjectMap.clear();
+        handleItemMap.clear();
     }
-    treeWidget->blockSignals(false);
+    else {
+        std::vector<QTreeWidgetItem*> removedItems;
+        std::unordered_set<QTreeWidgetItem*> removedSet;
+        for (EntityHandle handle : changes.removed) {
+            auto it = handleItemMap.find(handle);
+            if (it == handleItemMap.end()) continue;
 
-    if (oldObj) {
-        for (auto it = itemObjectMap.begin(); it != itemObjectMap.end(); ++it) {
-            if (it.value().data() == oldObj) {
-                treeWidget->setCurrentItem(it.key());
-                break;
+            QTreeWidgetItem* item = it->second;
+            selectionLost |= item->isSelected();
+            itemObjectMap.remove(item);
+            handleItemMap.erase(it);
+            removedItems.push_back(item);
+            removedSet.insert(item);
+        }
+
+        // Children are removed with their parents, and deleting an item deletes its children
+        for (QTreeWidgetItem* item : removedItems) {
+            if (!removedSet.count(item->parent())) {
+                delete item;
             }
         }
     }
+
+    for (EntityHandle handle : changes.added) {
+        if (auto* obj = scene->getObject(handle)) {
+            addItem(obj);
+        }
+    }
+    for (EntityHandle handle : changes.added) {
+        placeItem(handle);
+    }
+    for (EntityHandle handle : changes.reparented) {
+        placeItem(handle);
+    }
+
+    treeWidget->blockSignals(false);
+    treeWidget->setUpdatesEnabled(true);
+
+    if (selectionLost) {
+        onItemSelectionChanged();
+    }
+}
+
+void SceneHierarchyPanel::addItem(SceneObject* obj)
+{
+    auto* item = new QTreeWidgetItem();
+    item->setText(0, QString::fromStdString(obj->getName()));
+    item->setFlags(item->flags() | Qt::ItemIsEditable);
+
+    itemObjectMap[item] = obj->getHandle();
+    handleItemMap[obj->getHandle()] = item;
+}
+
+void SceneHierarchyPanel::placeItem(EntityHandle handle)
+{
+    auto it = handleItemMap.find(handle);
+    if (it == handleItemMap.end()) return;
+
+    QTreeWidgetItem* item = it->second;
+    if (auto* oldParent = item->parent()) {
+        oldParent->removeChild(item);
+    }
+    else {
+        int index = treeWidget->indexOfTopLevelItem(item);
+        if (index >= 0) treeWidget->takeTopLevelItem(index);
+    }
+
+    auto parent = handleItemMap.find(scene->getParent(handle));
+    if (parent != handleItemMap.end()) {
+        parent->second->addChild(item);
+        parent->second->setExpanded(true);
+    }
+    else {
+        treeWidget->addTopLevelItem(item);
+    }
 }
 
 bool SceneHierarchyPanel::eventFilter(QObject* watched, QEvent* ev)
@@ -105,6 +190,24 @@ bool SceneHierarchyPanel::eventFilter(QObject* watched, QEvent* ev)
             return true;
         }
     }
+    else if (watched == treeWidget->viewport() && ev->type() == QEvent::Drop) {
+        // Dropping reparents through the scene; the tree follows from objectsChanged
+        auto* de = static_cast<QDropEvent*>(ev);
+        QTreeWidgetItem* target = treeWidget->itemAt(de->pos());
+        EntityHandle parent = target ? itemObjectMap.value(target) : EntityHandle();
+
+        scene->beginBatch();
+        for (auto* item : treeWidget->selectedItems()) {
+            if (item != target) {
+                scene->setParent(itemObjectMap.value(item), parent);
+            }
+        }
+        scene->commit();
+
+        de->setDropAction(Qt::IgnoreAction);
+        de->accept();
+        return true;
+    }
     else if (ev->type() == QEvent::KeyPress) {
         QKeyEvent* keyEvent = static_cast<QKeyEvent*>(ev);
         if (keyEvent->key() == Qt::Key_F2) {
@@ -113,14 +216,16 @@ bool SceneHierarchyPanel::eventFilter(QObject* watched, QEvent* ev)
                 return true;
             }
         }
-    else if (keyEvent->key() == Qt::Key_Delete) {
-        auto selectedItems = treeWidget->selectedItems();
-        if (!selectedItems.isEmpty()) {
-            auto* item = selectedItems.first();
-            if (auto obj = itemObjectMap.value(item)) {
-                this->scene->removeObject(obj.data());
+        else if (keyEvent->key() == Qt::Key_Delete) {
+            if (!treeWidget->selectedItems().isEmpty()) {
+                removeSelectedObjects();
+                return true;
+            }
+        }
+        else if (keyEvent->key() == Qt::Key_D && (keyEvent->modifiers() & Qt::ControlModifier)) {
+            if (!treeWidget->selectedItems().isEmpty()) {
+                duplicateSelectedObjects();
                 return true;
-                }
             }
         }
     }
@@ -132,23 +237,27 @@ void SceneHierarchyPanel::onItemSelectionChanged() {
     auto selectedItems = treeWidget->selectedItems();
     if (!selectedItems.isEmpty()) {
         auto* selectedItem = selectedItems.first();
-        auto objPtr = itemObjectMap.value(selectedItem);
-        if (objPtr) {
-            emit objectSelected(objPtr.data());
-        }
-        else {
-            emit objectSelected(nullptr);
-        }
+        EntityHandle handle = itemObjectMap.value(selectedItem);
+        emit objectSelected(scene->isValid(handle) ? handle : EntityHandle());
     }
     else {
-        emit objectSelected(nullptr);
+        emit objectSelected(EntityHandle());
     }
 }
 
+void SceneHierarchyPanel::selectObject(EntityHandle handle) {
+    auto it = handleItemMap.find(handle);
+    if (it == handleItemMap.end()) return;
+
+    // Selection change emits objectSelected
+    treeWidget->setCurrentItem(it->second);
+    treeWidget->scrollToItem(it->second);
+}
+
 void SceneHierarchyPanel::onItemEdited(QTreeWidgetItem* item, int column) {
     if (column != 0) return;
 
-    if (auto obj = itemObjectMap.value(item)) {
+    if (auto* obj = scene->getObject(itemObjectMap.value(item))) {
         QString newName = item->text(0);
 
         treeWidget->blockSignals(true);
@@ -157,32 +266,75 @@ void SceneHierarchyPanel::onItemEdited(QTreeWidgetItem* item, int column) {
     }
 }
 
-void SceneHierarchyPanel::onObjectNameChanged(const std::string& newName)
+void SceneHierarchyPanel::onObjectsModified(const std::vector<ObjectModification>& modifications)
 {
-    SceneObject* obj = qobject_cast<SceneObject*>(sender());
-    if (!obj) return;
-
-    for (auto it = itemObjectMap.begin(); it != itemObjectMap.end(); ++it) {
-        if (it.value() == obj) {
-            treeWidget->blockSignals(true);
-            it.key()->setText(0, QString::fromStdString(newName));
-            treeWidget->blockSignals(false);
-            break;
+    treeWidget->blockSignals(true);
+    for (const auto& modification : modifications) {
+        if (!(modification.changes & ObjectChangeName)) continue;
+
+        auto it = handleItemMap.find(modification.handle);
+        SceneObject* obj = scene->getObject(modification.handle);
+        if (it != handleItemMap.end() && obj) {
+            it->second->setText(0, QString::fromStdString(obj->getName()));
         }
     }
+    treeWidget->blockSignals(false);
 }
 
 void SceneHierarchyPanel::keyPressEvent(QKeyEvent* event)
 {
     if (event->key() == Qt::Key_Delete) {
-        auto selectedItems = treeWidget->selectedItems();
-        if (!selectedItems.isEmpty()) {
-            auto* item = selectedItems.first();
-            if (auto obj = itemObjectMap.value(item)) {
-                scene->removeObject(obj.data());
-            }
-        }
+        removeSelectedObjects();
     }
 
     QWidget::keyPressEvent(event);
 }
+
+void SceneHierarchyPanel::removeSelectedObjects()
+{
+    std::vector<EntityHandle> handles;
+    for (auto* item : treeWidget->selectedItems()) {
+        handles.push_back(itemObjectMap.value(item));
+    }
+
+    if (!handles.empty()) {
+        scene->removeObjects(handles);
+    }
+}
+
+void SceneHierarchyPanel::duplicateSelectedObjects()
+{
+    std::vector<std::unique_ptr<SceneObject>> copies;
+    std::vector<std::pair<SceneObject*, EntityHandle>> copyParents;
+    for (auto* item : treeWidget->selectedItems()) {
+        if (auto* obj = scene->getObject(itemObjectMap.value(item))) {
+            copies.push_back(Scene::instantiate(obj->serialize()));
+            copies.back()->setPrefab(obj->getPrefab());
+            copyParents.emplace_back(copies.back().get(), scene->getParent(obj->getHandle()));
+        }
+    }
+
+    if (copies.empty()) return;
+
+    scene->addObjects(std::move(copies));
+
+    // Copies become siblings of their originals
+    scene->beginBatch();
+    for (const auto& copy : copyParents) {
+        if (!copy.second.isNull()) {
+            scene->setParent(copy.first->getHandle(), copy.second);
+        }
+    }
+    scene->commit();
+}
+
+// Each selected object becomes the first instance of a new prefab; duplicating it
+// afterwards places further instances
+void SceneHierarchyPanel::createPrefabsFromSelection()
+{
+    for (auto* item : treeWidget->selectedItems()) {
+        if (auto* obj = scene->getObject(itemObjectMap.value(item))) {
+            obj->setPrefab(Prefab::create(QString::fromStdString(obj->getName()), obj->serialize()));
+        }
+    }
+}
@@ -7,6 +7,7 @@
 #include <QMouseEvent>
 #include <QPointer>
 #include <QMenu>
+#include <unordered_map>
 
 class Scene;
 
@@ -20,21 +21,34 @@ protected:
     bool eventFilter(QObject* watched, QEvent* ev) override;
 
 signals:
-    void objectSelected(SceneObject* object);
+    void objectSelected(EntityHandle handle);
+
+public slots:
+    // Selects the object's item, e.g. after picking in the viewport
+    void selectObject(EntityHandle handle);
 
 private slots:
     void onItemSelectionChanged();
     void onItemEdited(QTreeWidgetItem* item, int column);
-    void onObjectNameChanged(const std::string& newName);
+    void onObjectsModified(const std::vector<ObjectModification>& modifications);
+    void onObjectsChanged(const SceneChangeSet& changes);
 
 private:
     void keyPressEvent(QKeyEvent* event) override;
+    void addItem(SceneObject* obj);
+    void placeItem(EntityHandle handle);
+    void removeSelectedObjects();
+    void duplicateSelectedObjects();
+    void createPrefabsFromSelection();
 
     Scene* scene;
     QTreeWidget* treeWidget;
-    QMap<QTreeWidgetItem*, QPointer<SceneObject>> itemObjectMap;
+    QMap<QTreeWidgetItem*, EntityHandle> itemObjectMap;
+    std::unordered_map<EntityHandle, QTreeWidgetItem*> handleItemMap;
 
     QMenu* contextMenu;
     QAction* renameAction;
+    QAction* duplicateAction;
+    QAction* prefabAction;
     QAction* deleteAction;
 };
\ No newline at end of file
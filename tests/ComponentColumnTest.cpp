@@ -0,0 +1,107 @@
+#include "ComponentColumn.h"
+#include "Quat.h"
+#include <cstdint>
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            std::printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);              \
+            ++failures;                                                                     \
+        }                                                                                   \
+    } while (0)
+
+struct Base {
+    virtual ~Base() = default;
+    int tag = 0;
+};
+
+// Counts live values and keeps a pointer to itself, so a relocation that skipped
+// the move constructor or left a value behind shows up
+struct Tracked : Base {
+    static int live;
+
+    explicit Tracked(int value) : value(value), self(this) { ++live; }
+    Tracked(Tracked&& other) noexcept : Base(), value(other.value), self(this) { tag = other.tag; other.value = -1; ++live; }
+    ~Tracked() override { --live; }
+
+    Quat rotation;
+    int value;
+    Tracked* self;
+};
+
+int Tracked::live = 0;
+
+static bool intact(const ComponentColumn& column)
+{
+    for (size_t row = 0; row < column.size(); ++row) {
+        const Tracked* value = static_cast<const Tracked*>(column.at(row));
+        if (value->self != value) return false;
+        if (reinterpret_cast<uintptr_t>(value) % alignof(Tracked) != 0) return false;
+    }
+    return true;
+}
+
+// Growing past the first block keeps every value, in order, at an aligned address
+static void testGrowKeepsValues()
+{
+    {
+        ComponentColumn column(ColumnOps::of<Tracked, Base>());
+        for (int i = 0; i < 100; ++i) column.emplaceBack<Tracked>(i);
+
+        CHECK(column.size() == 100);
+        CHECK(Tracked::live == 100);
+        CHECK(intact(column));
+        for (int i = 0; i < 100; ++i) CHECK(column.data<Tracked>()[i].value == i);
+    }
+    CHECK(Tracked::live == 0);
+}
+
+// The last row fills a removed or moved-out one; the moved value arrives at the end
+static void testRowsMoveByValue()
+{
+    {
+        ComponentColumn from(ColumnOps::of<Tracked, Base>());
+        ComponentColumn to(ColumnOps::of<Tracked, Base>());
+        for (int i = 0; i < 5; ++i) from.emplaceBack<Tracked>(i);
+
+        to.moveFrom(from, 1);
+        CHECK(from.size() == 4 && to.size() == 1);
+        CHECK(to.data<Tracked>()[0].value == 1);
+        CHECK(from.data<Tracked>()[1].value == 4);
+
+        to.moveFrom(from, 3);
+        CHECK(from.size() == 3 && to.size() == 2);
+        CHECK(to.data<Tracked>()[1].value == 3);
+
+        from.swapRemove(0);
+        CHECK(from.size() == 2);
+        CHECK(from.data<Tracked>()[0].value == 2);
+        CHECK(from.data<Tracked>()[1].value == 4);
+
+        CHECK(Tracked::live == 4);
+        CHECK(intact(from) && intact(to));
+    }
+    CHECK(Tracked::live == 0);
+}
+
+// base() reaches the common base the way ArchetypeStorage hands out Component*
+static void testBaseAddress()
+{
+    ComponentColumn column(ColumnOps::of<Tracked, Base>());
+    column.emplaceBack<Tracked>(7)->tag = 3;
+    CHECK(static_cast<Base*>(column.base(0)) == static_cast<Base*>(column.data<Tracked>()));
+    CHECK(static_cast<Base*>(column.base(0))->tag == 3);
+}
+
+int main()
+{
+    testGrowKeepsValues();
+    testRowsMoveByValue();
+    testBaseAddress();
+
+    if (failures) std::printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+#include "Mesh.h"
+#include "NullRenderDevice.h"
+#include "RenderQueue.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            std::printf("%s:%d: %s\n", __FILE__, __LINE__, #condition);                     \
+            ++failures;                                                                     \
+        }                                                                                   \
+    } while (0)
+
+// Unit sphere with outward, clockwise-front triangles. Indices go patch by patch
+// of 8 rings and 16 segments, so each cluster is a patch whose normals a cone bounds.
+static void buildSphere(Mesh& mesh, bool withLods)
+{
+    constexpr uint32_t Rings = 64;
+    constexpr uint32_t Segments = 128;
+
+    for (uint32_t r = 0; r <= Rings; ++r) {
+        const float theta = 3.14159265f * r / Rings;
+        for (uint32_t s = 0; s <= Segments; ++s) {
+            const float phi = 6.28318531f * s / Segments;
+            const Vec3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            mesh.vertices.push_back({ n.x, n.y, n.z, n.x, n.y, n.z, 0xFFFFFFFFu,
+                static_cast<float>(s) / Segments, static_cast<float>(r) / Rings });
+        }
+    }
+
+    auto position = [&mesh](uint32_t i) { return Vec3(mesh.vertices[i].x, mesh.vertices[i].y, mesh.vertices[i].z); };
+    auto triangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+        const Vec3 normal = cross(position(b) - position(a), position(c) - position(a));
+        if (dot(normal, position(a) + position(b) + position(c)) < 0.0f) std::swap(b, c);
+        mesh.indices.insert(mesh.indices.end(), { a, b, c });
+    };
+
+    for (uint32_t patchRing = 0; patchRing < Rings; patchRing += 8) {
+        for (uint32_t patchSegment = 0; patchSegment < Segments; patchSegment += 16) {
+            for (uint32_t r = patchRing; r < patchRing + 8; ++r) {
+                for (uint32_t s = patchSegment; s < patchSegment + 16; ++s) {
+                    const uint32_t a = r * (Segments + 1) + s;
+                    const uint32_t b = a + Segments + 1;
+                    triangle(a, b, a + 1);
+                    triangle(a + 1, b, b + 1);
+                }
+            }
+        }
+    }
+
+    mesh.minBounds = Vec3(-1.0f, -1.0f, -1.0f);
+    mesh.maxBounds = Vec3(1.0f, 1.0f, 1.0f);
+    mesh.buildClusters();
+    if (withLods) mesh.buildLods();
+}
+
+// Camera on the -z axis looking at the origin
+struct TestView {
+    NullRenderDevice device;
+    RenderQueue queue;
+
+    void look(float distance, CullMode cull = CullMode::CounterClockwise) {
+        device.setTransform(TransformSlot::View, Mat4::lookAtLH({ 0, 0, -distance }, { 0, 0, 0 }, { 0, 1, 0 }));
+        device.setTransform(TransformSlot::Projection, Mat4::perspectiveFovLH(1.0f, 1.0f, 0.1f, 100000.0f));
+        device.setRenderState(RenderState::Cull, static_cast<uint32_t>(cull));
+        device.resetFrame();
+        queue.begin(device);
+    }
+
+    ~TestView() { queue.releaseDeviceObjects(); }
+};
+
+// Whether a triangle of the full mesh faces a camera at the given position
+static bool facesCamera(const Mesh& mesh, const uint32_t* triangle, const Vec3& camera)
+{
+    Vec3 p[3];
+    for (int k = 0; k < 3; ++k) {
+        const Vertex& v = mesh.vertices[triangle[k]];
+        p[k] = Vec3(v.x, v.y, v.z);
+    }
+    return dot(cross(p[1] - p[0], p[2] - p[0]), camera - p[0]) > 0.0f;
+}
+
+// Triangles of the recorded per-object draws of the full mesh, and how many of
+// them face the camera
+static uint32_t drawnTriangles(const TestView& view, const Mesh& mesh, uint32_t* facing = nullptr)
+{
+    uint32_t total = 0;
+    uint32_t front = 0;
+    for (const RenderCommand& command : view.device.getCommands()) {
+        if (command.type != RenderCommand::DrawIndexed) continue;
+        total += command.d;
+        for (uint32_t t = 0; t < command.d; ++t) {
+            front += facesCamera(mesh, &mesh.indices[command.c + t * 3], view.queue.getCameraPosition());
+        }
+    }
+    if (facing) *facing = front;
+    return total;
+}
+
+// Cluster cones drop most of the far side
+static void testBackfacingClustersAreCulled()
+{
+    // The view outlives the mesh, whose buffers go back to its device
+    TestView view;
+    Mesh mesh;
+    buildSphere(mesh, false);
+    CHECK(mesh.clusters.size() >= Mesh::MinCulledClusters);
+
+    view.look(3.0f);
+    uint32_t lod = 0;
+    mesh.enqueue(view.queue, view.device, Mat4::identity(), lod);
+    view.queue.submit(view.device);
+
+    const RenderQueueStats& stats = view.queue.getStats();
+    uint32_t facing = 0;
+    const uint32_t drawn = drawnTriangles(view, mesh, &facing);
+    CHECK(lod == 0);
+    CHECK(stats.reducedDraws == 0);
+    CHECK(stats.culledClusters > 0);
+    CHECK(drawn < mesh.indices.size() / 3);
+    CHECK(drawn == stats.primitives);
+
+    // Culling is conservative: every camera-facing triangle is still drawn
+    uint32_t allFacing = 0;
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        allFacing += facesCamera(mesh, &mesh.indices[i], view.queue.getCameraPosition());
+    }
+    CHECK(facing == allFacing);
+}
+
+// Without backface culling only the frustum removes clusters: the sphere half off screen
+static void testFrustumCullsClusters()
+{
+    TestView view;
+    Mesh mesh;
+    buildSphere(mesh, false);
+
+    view.look(3.0f, CullMode::None);
+    uint32_t lod = 0;
+    mesh.enqueue(view.queue, view.device, Mat4::translation({ 1.6f, 0.0f, 0.0f }), lod);
+    view.queue.submit(view.device);
+
+    CHECK(view.queue.getStats().culledClusters > 0);
+    CHECK(drawnTriangles(view, mesh) < mesh.indices.size() / 3);
+
+    // Centered, every cluster is in view
+    view.look(3.0f, CullMode::None);
+    mesh.enqueue(view.queue, view.device, Mat4::identity(), lod);
+    view.queue.submit(view.device);
+    CHECK(view.queue.getStats().culledClusters == 0);
+    CHECK(drawnTriangles(view, mesh) == mesh.indices.size() / 3);
+}
+
+// Far away the mesh is drawn whole at a simplified level. Between the thresholds
+// for switching coarser and back, the level drawn last time is kept.
+static void testLodSelection()
+{
+    TestView view;
+    Mesh mesh;
+    buildSphere(mesh, true);
+    CHECK(mesh.hasLods());
+    if (!mesh.hasLods()) return;
+
+    view.look(100000.0f);
+    uint32_t lod = 0;
+    mesh.enqueue(view.queue, view.device, Mat4::identity(), lod);
+    view.queue.submit(view.device);
+    CHECK(lod == mesh.lods.size() - 1);
+    CHECK(view.queue.getStats().reducedDraws == 1);
+    CHECK(view.queue.getStats().draws == 1);
+    CHECK(view.queue.getStats().primitives == mesh.lods[lod].triangleCount);
+
+    // Level 1 covers between the two limits here: too little to switch to, enough to keep
+    const float projectionScale = view.queue.getProjectionScale();
+    const float screenError = Mesh::MaxLodScreenError * (1.0f + Mesh::LodHysteresis) * 0.5f;
+    const float distance = mesh.lods[1].error * 0.5f * projectionScale / screenError;
+    view.look(distance);
+    CHECK(mesh.selectLod(view.queue, Mat4::identity(), 0) == 0);
+    CHECK(mesh.selectLod(view.queue, Mat4::identity(), 1) == 1);
+}
+
+int main()
+{
+    testBackfacingClustersAreCulled();
+    testFrustumCullsClusters();
+    testLodSelection();
+
+    if (failures) std::printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
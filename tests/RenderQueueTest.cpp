@@ -0,0 +1,159 @@
+#include "NullRenderDevice.h"
+#include "RenderQueue.h"
+#include <cstdio>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK_EQ(actual, expected)                                                          \
+    do {                                                                                    \
+        const auto a_ = (actual);                                                           \
+        const auto e_ = (expected);                                                         \
+        if (!(a_ == e_)) {                                                                  \
+            std::printf("%s:%d: %s is %g, expected %g\n", __FILE__, __LINE__, #actual,       \
+                static_cast<double>(a_), static_cast<double>(e_));                          \
+            ++failures;                                                                     \
+        }                                                                                   \
+    } while (0)
+
+// Two meshes and two materials, seen by a camera at z = -10 looking down +z
+struct TestScene {
+    NullRenderDevice device;
+    RenderQueue queue;
+    BufferHandle vertexA, indexA, vertexB, indexB;
+    Material red{ { 1, 0, 0, 1 }, { 0.1f, 0, 0, 1 } };
+    Material blue{ { 0, 0, 1, 1 }, { 0, 0, 0.1f, 1 } };
+
+    TestScene() {
+        const uint16_t indices[3] = { 0, 1, 2 };
+        vertexA = device.createVertexBuffer(nullptr, 3 * sizeof(Vertex), VertexLayout::mesh());
+        indexA = device.createIndexBuffer(indices, sizeof(indices), IndexFormat::Index16);
+        vertexB = device.createVertexBuffer(nullptr, 3 * sizeof(Vertex), VertexLayout::mesh());
+        indexB = device.createIndexBuffer(indices, sizeof(indices), IndexFormat::Index16);
+
+        device.setTransform(TransformSlot::View, Mat4::lookAtLH({ 0, 0, -10 }, { 0, 0, 0 }, { 0, 1, 0 }));
+        device.setTransform(TransformSlot::Projection, Mat4::perspectiveFovLH(1.0f, 1.0f, 0.1f, 100.0f));
+        queue.begin(device);
+    }
+
+    ~TestScene() {
+        queue.releaseDeviceObjects();
+    }
+
+    void push(RenderPass pass, const Material& material, bool meshA, float z) {
+        queue.push(pass, material, meshA ? vertexA : vertexB, meshA ? indexA : indexB, 0, 3, 0, 1,
+            Mat4::translation({ 0, 0, z }));
+    }
+
+    // World z of every per-object draw, in submission order
+    std::vector<float> drawDepths() const {
+        std::vector<float> depths;
+        float world = 0.0f;
+        for (const RenderCommand& command : device.getCommands()) {
+            if (command.type == RenderCommand::SetTransform && command.a == static_cast<uint32_t>(TransformSlot::World)) {
+                world = device.getMatrices()[command.b].m[3][2];
+            }
+            else if (command.type == RenderCommand::DrawIndexed) {
+                depths.push_back(world);
+            }
+        }
+        return depths;
+    }
+};
+
+// Packets sort by pass, material (numbered in order of first use) and mesh, then
+// depth: opaque front to back, transparent back to front. State is only sent when
+// it changes.
+static void testSortAndStateChanges()
+{
+    TestScene scene;
+    scene.queue.setInstancingEnabled(false);
+
+    scene.push(RenderPass::Opaque, scene.red, true, 5.0f);
+    scene.push(RenderPass::Transparent, scene.blue, false, 2.0f);
+    scene.push(RenderPass::Opaque, scene.red, false, 1.0f);
+    scene.push(RenderPass::Opaque, scene.red, true, -3.0f);
+    scene.push(RenderPass::Opaque, scene.blue, true, 0.0f);
+    scene.push(RenderPass::Transparent, scene.blue, false, 8.0f);
+    scene.push(RenderPass::Opaque, scene.red, true, 1.0f);
+    scene.push(RenderPass::Opaque, scene.red, false, -1.0f);
+    scene.device.resetFrame();
+    scene.queue.submit(scene.device);
+
+    const std::vector<float> expected = { -3.0f, 1.0f, 5.0f, -1.0f, 1.0f, 0.0f, 8.0f, 2.0f };
+    const std::vector<float> depths = scene.drawDepths();
+    CHECK_EQ(depths.size(), expected.size());
+    for (size_t i = 0; i < expected.size() && i < depths.size(); ++i) CHECK_EQ(depths[i], expected[i]);
+
+    // Lighting, then per run: material, vertex and index buffer, and one world per draw.
+    // Red A, red B, blue A and transparent blue B; the second and last keep the material.
+    const RenderQueueStats& stats = scene.queue.getStats();
+    CHECK_EQ(stats.draws, 8u);
+    CHECK_EQ(stats.instancedDraws, 0u);
+    CHECK_EQ(stats.primitives, 8u);
+    CHECK_EQ(stats.stateChanges, 1u + (3 + 3) + (2 + 2) + (3 + 1) + (2 + 2));
+    CHECK_EQ(stats.skippedChanges, 2u);
+    CHECK_EQ(scene.device.getStats().drawCalls, 8u);
+}
+
+// Two packets at the same place share a world matrix, so the second one skips it
+static void testRepeatedWorldIsSkipped()
+{
+    TestScene scene;
+    scene.queue.setInstancingEnabled(false);
+
+    scene.push(RenderPass::Opaque, scene.red, true, 4.0f);
+    scene.push(RenderPass::Opaque, scene.red, true, 4.0f);
+    scene.queue.submit(scene.device);
+
+    const RenderQueueStats& stats = scene.queue.getStats();
+    CHECK_EQ(stats.draws, 2u);
+    CHECK_EQ(stats.stateChanges, 1u + 3 + 1);
+    CHECK_EQ(stats.skippedChanges, 1u);
+}
+
+// Opaque runs of at least four identical packets become one instanced draw;
+// shorter runs and transparent ones are drawn one by one
+static void testInstancingThreshold()
+{
+    TestScene scene;
+
+    for (int i = 0; i < 4; ++i) scene.push(RenderPass::Opaque, scene.red, true, static_cast<float>(i));
+    for (int i = 0; i < 3; ++i) scene.push(RenderPass::Opaque, scene.red, false, static_cast<float>(i));
+    for (int i = 0; i < 4; ++i) scene.push(RenderPass::Transparent, scene.blue, true, static_cast<float>(i));
+    scene.device.resetFrame();
+    scene.queue.submit(scene.device);
+
+    const RenderQueueStats& stats = scene.queue.getStats();
+    CHECK_EQ(stats.instancedDraws, 1u);
+    CHECK_EQ(stats.instances, 4u);
+    CHECK_EQ(stats.draws, 1u + 3 + 4);
+    CHECK_EQ(stats.primitives, 11u);
+
+    uint32_t instancedCalls = 0;
+    for (const RenderCommand& command : scene.device.getCommands()) {
+        if (command.type != RenderCommand::DrawInstanced) continue;
+        ++instancedCalls;
+        CHECK_EQ(command.b, 0u);
+        CHECK_EQ(command.d, 4u);
+    }
+    CHECK_EQ(instancedCalls, 1u);
+
+    // Without device support the same frame falls back to per-object draws
+    scene.device.setInstancingSupported(false);
+    scene.queue.begin(scene.device);
+    for (int i = 0; i < 4; ++i) scene.push(RenderPass::Opaque, scene.red, true, static_cast<float>(i));
+    scene.queue.submit(scene.device);
+    CHECK_EQ(scene.queue.getStats().instancedDraws, 0u);
+    CHECK_EQ(scene.queue.getStats().draws, 4u);
+}
+
+int main()
+{
+    testSortAndStateChanges();
+    testRepeatedWorldIsSkipped();
+    testInstancingThreshold();
+
+    if (failures) std::printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
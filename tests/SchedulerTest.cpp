@@ -0,0 +1,131 @@
+#include "JobSystem.h"
+#include "SystemScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            std::printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);              \
+            ++failures;                                                                     \
+        }                                                                                   \
+    } while (0)
+
+constexpr ComponentMask Bit(int n) { return ComponentMask(1) << n; }
+
+// Stamps when each run started and finished from one shared clock, so the test
+// can tell whether a system overlapped one it should have waited for
+class RecordingSystem : public System {
+public:
+    RecordingSystem(std::atomic<int>& clock, ComponentMask reads, ComponentMask writes)
+        : clock(clock), reads(reads), writes(writes) {}
+
+    const char* getName() const override { return "Recording"; }
+    ComponentMask getReadMask() const override { return reads; }
+    ComponentMask getWriteMask() const override { return writes; }
+
+    void update(float, JobSystem&) override {
+        started = clock.fetch_add(1);
+        // Long enough for a wrongly unordered system to start in the meantime
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        finished = clock.fetch_add(1);
+        ++runs;
+    }
+
+    std::atomic<int>& clock;
+    ComponentMask reads;
+    ComponentMask writes;
+    int started = -1;
+    int finished = -1;
+    int runs = 0;
+};
+
+static bool runsAfter(const RecordingSystem& later, const RecordingSystem& earlier)
+{
+    return later.started > earlier.finished;
+}
+
+// Read after write, write after read and write after write are ordered by
+// registration; systems that share nothing are not
+static void testDependencyOrder(unsigned threads)
+{
+    JobSystem jobs(threads);
+    SystemScheduler scheduler(jobs);
+    std::atomic<int> clock{ 0 };
+
+    RecordingSystem writer(clock, 0, Bit(0));
+    RecordingSystem reader(clock, Bit(0), Bit(1));
+    RecordingSystem rewriter(clock, 0, Bit(0));
+    RecordingSystem second(clock, Bit(1), Bit(2));
+    RecordingSystem unrelated(clock, Bit(5), Bit(6));
+
+    for (RecordingSystem* system : { &writer, &reader, &rewriter, &second, &unrelated }) scheduler.addSystem(system);
+    CHECK(scheduler.getSystemCount() == 5);
+
+    for (int frame = 0; frame < 50; ++frame) {
+        scheduler.run(0.016f);
+        CHECK(runsAfter(reader, writer));
+        CHECK(runsAfter(rewriter, reader));
+        CHECK(runsAfter(rewriter, writer));
+        CHECK(runsAfter(second, reader));
+    }
+    CHECK(writer.runs == 50 && reader.runs == 50 && rewriter.runs == 50 && second.runs == 50 && unrelated.runs == 50);
+}
+
+// A reader registered first holds back a writer registered after it
+static void testRegistrationOrderDecides(unsigned threads)
+{
+    JobSystem jobs(threads);
+    SystemScheduler scheduler(jobs);
+    std::atomic<int> clock{ 0 };
+
+    RecordingSystem reader(clock, Bit(3), 0);
+    RecordingSystem writer(clock, 0, Bit(3));
+    scheduler.addSystem(&reader);
+    scheduler.addSystem(&writer);
+
+    for (int frame = 0; frame < 20; ++frame) {
+        scheduler.run(0.016f);
+        CHECK(runsAfter(writer, reader));
+    }
+}
+
+// Removing a system drops the edges through it and the rest still runs
+static void testRemoveRebuildsGraph(unsigned threads)
+{
+    JobSystem jobs(threads);
+    SystemScheduler scheduler(jobs);
+    std::atomic<int> clock{ 0 };
+
+    RecordingSystem first(clock, 0, Bit(0));
+    RecordingSystem middle(clock, Bit(0), Bit(1));
+    RecordingSystem last(clock, Bit(1), 0);
+    scheduler.addSystem(&first);
+    scheduler.addSystem(&middle);
+    scheduler.addSystem(&last);
+    scheduler.run(0.016f);
+    CHECK(runsAfter(last, middle));
+
+    scheduler.removeSystem(&middle);
+    CHECK(scheduler.getSystemCount() == 2);
+    scheduler.run(0.016f);
+    CHECK(middle.runs == 1);
+    CHECK(first.runs == 2 && last.runs == 2);
+}
+
+int main()
+{
+    for (unsigned threads : { 1u, 2u, 4u }) {
+        testDependencyOrder(threads);
+        testRegistrationOrderDecides(threads);
+        testRemoveRebuildsGraph(threads);
+    }
+
+    if (failures) std::printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            std::printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);              \
+            ++failures;                                                                     \
+        }                                                                                   \
+    } while (0)
+
+// Closed-form surfaces like the simplifier bench uses, smaller so the test runs quickly
+struct TestSurface {
+    const char* name;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::function<float(const Vec3&)> distance;
+};
+
+// Unit UV sphere with a texture seam from pole to pole
+static TestSurface makeSphere(uint32_t rings, uint32_t segments)
+{
+    TestSurface surface;
+    surface.name = "sphere";
+    for (uint32_t r = 0; r <= rings; ++r) {
+        const float theta = 3.14159265f * r / rings;
+        for (uint32_t s = 0; s <= segments; ++s) {
+            const float phi = 6.28318531f * s / segments;
+            const Vec3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            surface.vertices.push_back({ n.x, n.y, n.z, n.x, n.y, n.z, 0xFFFFFFFFu,
+                static_cast<float>(s) / segments, static_cast<float>(r) / rings });
+        }
+    }
+    for (uint32_t r = 0; r < rings; ++r) {
+        for (uint32_t s = 0; s < segments; ++s) {
+            const uint32_t a = r * (segments + 1) + s;
+            const uint32_t b = a + segments + 1;
+            surface.indices.insert(surface.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+    surface.distance = [](const Vec3& p) { return std::fabs(length(p) - 1.0f); };
+    return surface;
+}
+
+// Height field over [-1, 1]^2 with an open boundary all around
+static TestSurface makeTerrain(uint32_t size)
+{
+    auto height = [](float x, float z) { return 0.1f * std::sin(3.0f * x) * std::cos(2.0f * z) + 0.05f * std::sin(7.0f * x + 5.0f * z); };
+    auto slope = [](float x, float z) {
+        const float dx = 0.3f * std::cos(3.0f * x) * std::cos(2.0f * z) + 0.35f * std::cos(7.0f * x + 5.0f * z);
+        const float dz = -0.2f * std::sin(3.0f * x) * std::sin(2.0f * z) + 0.25f * std::cos(7.0f * x + 5.0f * z);
+        return std::sqrt(1.0f + dx * dx + dz * dz);
+    };
+
+    TestSurface surface;
+    surface.name = "terrain";
+    for (uint32_t j = 0; j <= size; ++j) {
+        for (uint32_t i = 0; i <= size; ++i) {
+            const float x = -1.0f + 2.0f * i / size;
+            const float z = -1.0f + 2.0f * j / size;
+            surface.vertices.push_back({ x, height(x, z), z, 0.0f, 1.0f, 0.0f, 0xFFFFFFFFu,
+                static_cast<float>(i) / size, static_cast<float>(j) / size });
+        }
+    }
+    for (uint32_t j = 0; j < size; ++j) {
+        for (uint32_t i = 0; i < size; ++i) {
+            const uint32_t a = j * (size + 1) + i;
+            const uint32_t b = a + size + 1;
+            surface.indices.insert(surface.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+    surface.distance = [height, slope](const Vec3& p) { return std::fabs(p.y - height(p.x, p.z)) / slope(p.x, p.z); };
+    return surface;
+}
+
+// Largest distance to the surface over each triangle's centroid and edge midpoints
+static float measureError(const TestSurface& surface, const std::vector<uint32_t>& indices)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Vec3 p[3];
+        for (int k = 0; k < 3; ++k) {
+            const Vertex& v = surface.vertices[indices[i + k]];
+            p[k] = Vec3(v.x, v.y, v.z);
+        }
+        const Vec3 samples[4] = { (p[0] + p[1] + p[2]) * (1.0f / 3.0f),
+            (p[0] + p[1]) * 0.5f, (p[1] + p[2]) * 0.5f, (p[2] + p[0]) * 0.5f };
+        for (const Vec3& sample : samples) worst = std::max(worst, surface.distance(sample));
+    }
+    return worst;
+}
+
+// The reported error plus the input's own distance to the true surface has to
+// cover what is measured on the result, at every ratio and with an error limit
+static void testReportedErrorBoundsMeasured(const TestSurface& surface)
+{
+    const float inputError = measureError(surface, surface.indices);
+
+    for (size_t divisor = 2; divisor <= 16; divisor *= 2) {
+        float reported = -1.0f;
+        const std::vector<uint32_t> simplified = simplifyMesh(surface.vertices, surface.indices,
+            surface.indices.size() / divisor, FLT_MAX, &reported);
+        const float measured = measureError(surface, simplified);
+
+        CHECK(simplified.size() < surface.indices.size());
+        CHECK(reported > 0.0f);
+        if (reported + inputError < measured) {
+            std::printf("%s 1/%zu: reported %g + input %g < measured %g\n", surface.name, divisor, reported, inputError, measured);
+            ++failures;
+        }
+    }
+
+    float reported = -1.0f;
+    const std::vector<uint32_t> limited = simplifyMesh(surface.vertices, surface.indices,
+        surface.indices.size() / 6 * 3, 0.01f, &reported);
+    CHECK(reported + inputError >= measureError(surface, limited));
+}
+
+// Nothing collapsed, nothing moved
+static void testUntouchedMeshReportsZero()
+{
+    const TestSurface sphere = makeSphere(8, 16);
+    float reported = -1.0f;
+    const std::vector<uint32_t> same = simplifyMesh(sphere.vertices, sphere.indices, sphere.indices.size(), FLT_MAX, &reported);
+    CHECK(same == sphere.indices);
+    CHECK(reported == 0.0f);
+}
+
+int main()
+{
+    testReportedErrorBoundsMeasured(makeSphere(40, 80));
+    testReportedErrorBoundsMeasured(makeTerrain(48));
+    testUntouchedMeshReportsZero();
+
+    if (failures) std::printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}